@@ -0,0 +1,753 @@
+#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include "../src/renderer/vk/VkHelper.h"
+#include "../src/renderer/vk/RenderPass.h"
+#include "../src/renderer/vk/VkWindow.h"
+#include "../src/renderer/vk/GraphicsPipeline.h"
+#include "../src/renderer/vk/ParallelRecorder.h"
+#include "../src/renderer/vk/InstanceBatcher.h"
+#include "../src/renderer/vk/IndirectScene.h"
+#include "../src/renderer/vk/AssetStreamer.h"
+#include "../src/renderer/vk/Texture.h"
+#include "../src/renderer/FrustumCuller.h"
+#include "../src/renderer/MeshOptimizer.h"
+#include "../src/renderer/VertexEncoding.h"
+
+// headless benchmark: renders fixed scenes into offscreen images for N frames and prints frame time percentiles.
+// runs on any vulkan ICD (including lavapipe), no window or display required.
+
+struct BenchOptions {
+    std::string scene = "triangle";
+    uint32_t frames = 1000;
+    uint32_t warmupFrames = 50;
+    VkExtent2D extent = {1280, 720};
+    uint32_t framesInFlight = 2;
+    // off compares against render pass objects on devices that have dynamic rendering
+    bool dynamicRendering = true;
+    // chrome trace of the run, empty for none
+    std::string tracePath;
+    // scalar|sse|avx2, empty picks the best the cpu supports
+    std::string cullKernel;
+    // float (Vertex) or compact (CompactVertex), for the mesh scene
+    std::string vertexFormat = "compact";
+    // rgba8 (mips blitted on the gpu) or bc1 (compressed on the cpu, mips included), for the textured scene
+    std::string textureFormat = "rgba8";
+};
+
+struct BenchScene {
+    std::string name;
+    std::function<void(VkWindow&, RenderPass&)> setup;
+    std::function<void()> record;
+    std::function<void()> teardown;
+    VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE;
+    // recorded before the render pass begins (compute), optional
+    std::function<void()> prepare;
+};
+
+// state shared by the scene callbacks, owned by runBench
+struct BenchState {
+    std::unique_ptr<GraphicsPipeline> pipeline;
+    std::unique_ptr<ParallelRecorder> recorder;
+    std::unique_ptr<InstanceBatcher> batcher;
+    std::unique_ptr<IndirectScene> indirect;
+    std::unique_ptr<FrustumCuller> culler;
+    std::unique_ptr<AssetStreamer> streamer;
+    std::unique_ptr<Texture> texture;
+    AssetPack pack;
+    std::string packPath;
+    std::vector<StreamedMesh> streamed;
+    uint32_t frame = 0;
+    BoundsStore bounds;
+    std::vector<InstanceData> objects;
+    std::string cullKernel;
+    std::string vertexFormat;
+    std::string textureFormat;
+    Mesh mesh;
+    VkWindow* win = nullptr;
+    RenderPass* pass = nullptr;
+};
+
+// draw calls per frame of the triangles scenes, instances of the instanced scene
+static constexpr uint32_t drawCount = 10000;
+// spheres culled per frame by the cpu_culled scene
+static constexpr uint32_t cullObjectCount = 100000;
+// vertices per side of the mesh scene's grid (still 16 bit indices) and copies of it per side of the screen
+static constexpr uint32_t meshGridSide = 255;
+static constexpr uint32_t meshCopiesSide = 4;
+// the streaming scene's world: cells per side, each its own mesh in a temporary pack, vertices per side of a cell's
+// grid, how many cells the budget keeps resident and how many frames the camera stays on a cell
+static constexpr uint32_t streamCellsSide = 8;
+static constexpr uint32_t streamGridSide = 64;
+static constexpr uint32_t streamResidentCells = 16;
+static constexpr uint32_t streamFramesPerCell = 20;
+// the textured scene's checker texture, pixels per side and per square
+static constexpr uint32_t textureSide = 1024;
+static constexpr uint32_t checkerSide = 32;
+
+// gpu time of one profiler scope, averaged over the measured frames
+struct GpuScopeTotal {
+    std::string name;
+    uint32_t depth;
+    double totalMilliseconds = 0;
+    uint32_t samples = 0;
+};
+
+static void accumulateGpuScopes(const std::vector<GpuScopeResult>& results, std::vector<GpuScopeTotal>& totals) {
+    for (const auto& result: results) {
+        auto total = std::find_if(totals.begin(), totals.end(), [&](const GpuScopeTotal& t) { return t.name == result.name && t.depth == result.depth; });
+        if (total == totals.end()) total = totals.insert(totals.end(), GpuScopeTotal{result.name, result.depth});
+        total->totalMilliseconds += result.milliseconds;
+        total->samples++;
+    }
+}
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// RGBA8 level from the one above it, 2x2 box filter
+static std::vector<uint8_t> downsample(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height) {
+    uint32_t levelWidth = std::max(width / 2, 1u), levelHeight = std::max(height / 2, 1u);
+    std::vector<uint8_t> level(levelWidth * levelHeight * 4);
+    for (uint32_t y = 0; y < levelHeight; ++y) {
+        for (uint32_t x = 0; x < levelWidth; ++x) {
+            for (uint32_t c = 0; c < 4; ++c) {
+                uint32_t x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                uint32_t y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+                uint32_t sum = pixels[(y0 * width + x0) * 4 + c] + pixels[(y0 * width + x1) * 4 + c] + pixels[(y1 * width + x0) * 4 + c] + pixels[(y1 * width + x1) * 4 + c];
+                level[(y * levelWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+    return level;
+}
+
+// RGBA8 level to BC1 blocks. endpoints are the darkest and brightest pixel of a block, good enough for a checker,
+// a real asset would come out of an offline encoder in a .ktx2
+static std::vector<std::byte> encodeBc1(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height) {
+    auto to565 = [](const uint8_t* p) { return static_cast<uint16_t>((p[0] >> 3) << 11 | (p[1] >> 2) << 5 | p[2] >> 3); };
+    auto from565 = [](uint16_t c, int* rgb) {
+        rgb[0] = (c >> 11) * 255 / 31;
+        rgb[1] = (c >> 5 & 63) * 255 / 63;
+        rgb[2] = (c & 31) * 255 / 31;
+    };
+    
+    uint32_t blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    std::vector<std::byte> blocks(blocksX * blocksY * 8);
+    for (uint32_t by = 0; by < blocksY; ++by) {
+        for (uint32_t bx = 0; bx < blocksX; ++bx) {
+            const uint8_t* texels[16];
+            const uint8_t* lo = nullptr;
+            const uint8_t* hi = nullptr;
+            int loLuma = INT32_MAX, hiLuma = -1;
+            for (uint32_t i = 0; i < 16; ++i) {
+                uint32_t x = std::min(bx * 4 + i % 4, width - 1), y = std::min(by * 4 + i / 4, height - 1);
+                texels[i] = &pixels[(y * width + x) * 4];
+                int luma = texels[i][0] * 2 + texels[i][1] * 5 + texels[i][2];
+                if (luma < loLuma) { loLuma = luma; lo = texels[i]; }
+                if (luma > hiLuma) { hiLuma = luma; hi = texels[i]; }
+            }
+            
+            // color0 > color1 selects the four color mode
+            uint16_t color0 = to565(hi), color1 = to565(lo);
+            if (color0 < color1) std::swap(color0, color1);
+            int palette[4][3];
+            from565(color0, palette[0]);
+            from565(color1, palette[1]);
+            for (int c = 0; c < 3; ++c) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            
+            uint32_t indices = 0;
+            if (color0 != color1) {
+                for (uint32_t i = 0; i < 16; ++i) {
+                    uint32_t best = 0;
+                    int bestDistance = INT32_MAX;
+                    for (uint32_t p = 0; p < 4; ++p) {
+                        int distance = 0;
+                        for (int c = 0; c < 3; ++c) distance += (texels[i][c] - palette[p][c]) * (texels[i][c] - palette[p][c]);
+                        if (distance < bestDistance) { bestDistance = distance; best = p; }
+                    }
+                    indices |= best << (i * 2);
+                }
+            }
+            std::byte* block = &blocks[(by * blocksX + bx) * 8];
+            std::memcpy(block, &color0, 2);
+            std::memcpy(block + 2, &color1, 2);
+            std::memcpy(block + 4, &indices, 4);
+        }
+    }
+    return blocks;
+}
+
+static void printUsage() {
+    std::cout << "usage: citrine_bench [--scene clear|triangle|triangles|triangles_mt|instanced|indirect|cpu_culled|mesh|streaming|textured] [--frames N] [--warmup N] [--width W] [--height H] [--frames-in-flight N] [--dynamic-rendering on|off] [--cull-kernel scalar|sse|avx2] [--vertex-format float|compact] [--texture-format rgba8|bc1] [--trace FILE]\n";
+}
+
+// the whole value as a positive count, throws naming the option otherwise
+static uint32_t parseCount(const std::string& arg, const std::string& value) {
+    uint32_t count = 0;
+    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), count);
+    if (error != std::errc() || end != value.data() + value.size() || count == 0)
+        throw std::runtime_error("invalid value '" + value + "' for '" + arg + "'");
+    return count;
+}
+
+static bool parseOptions(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") return false;
+        if (i + 1 >= argc) throw std::runtime_error("missing value for '" + arg + "'");
+        std::string value = argv[++i];
+        
+        if (arg == "--scene") options.scene = value;
+        else if (arg == "--frames") options.frames = parseCount(arg, value);
+        else if (arg == "--warmup") options.warmupFrames = value == "0" ? 0 : parseCount(arg, value);
+        else if (arg == "--width") options.extent.width = parseCount(arg, value);
+        else if (arg == "--height") options.extent.height = parseCount(arg, value);
+        else if (arg == "--frames-in-flight") options.framesInFlight = parseCount(arg, value);
+        else if (arg == "--dynamic-rendering") options.dynamicRendering = value != "off";
+        else if (arg == "--trace") options.tracePath = value;
+        else if (arg == "--cull-kernel") options.cullKernel = value;
+        else if (arg == "--vertex-format") options.vertexFormat = value;
+        else if (arg == "--texture-format") options.textureFormat = value;
+        else throw std::runtime_error("unknown option '" + arg + "'");
+    }
+    return true;
+}
+
+static std::vector<BenchScene> createScenes(BenchState& state) {
+    std::vector<BenchScene> scenes;
+    
+    auto setupTriangle = [&state](VkWindow& win, RenderPass& pass) {
+        state.win = &win;
+        state.pass = &pass;
+        state.pipeline = std::make_unique<GraphicsPipeline>(win);
+        state.pipeline->loadVertexShader("shaders/basic/vert.spv");
+        state.pipeline->loadFragmentShader("shaders/basic/frag.spv");
+        state.pipeline->createVertexBuffer();
+        state.pipeline->createPipeline(pass);
+    };
+    auto teardownTriangle = [&state] {
+        state.pipeline->destroyPipeline();
+        state.pipeline->destroyVertexBuffer();
+    };
+    
+    // render pass with clear only, measures fixed per-frame overhead
+    scenes.push_back({"clear", [](VkWindow&, RenderPass&) {}, [] {}, [] {}});
+    
+    scenes.push_back({"triangle", setupTriangle, [&state] { state.pipeline->bindPipeline(); }, teardownTriangle});
+    
+    // cpu bound: many small draws recorded on the frame thread
+    scenes.push_back({"triangles", setupTriangle,
+        [&state] {
+            if (!state.pipeline->prepare()) return;
+            VkCommandBuffer commandBuffer = state.win->commandPool.currentCommandBuffer().vk;
+            for (uint32_t i = 0; i < drawCount; ++i) state.pipeline->record(commandBuffer);
+        },
+        teardownTriangle
+    });
+    
+    // same draws, split into slices recorded as jobs into secondary command buffers
+    scenes.push_back({"triangles_mt",
+        [&state, setupTriangle](VkWindow& win, RenderPass& pass) {
+            setupTriangle(win, pass);
+            state.recorder = std::make_unique<ParallelRecorder>(win);
+            state.recorder->create();
+            std::cout << "recorder slices: " << state.recorder->sliceCount() << "\n";
+        },
+        [&state] {
+            if (!state.pipeline->prepare()) return;
+            state.recorder->beginFrame();
+            const GraphicsPipeline& pipeline = *state.pipeline;
+            auto recordDraws = [&pipeline](VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end) {
+                for (uint32_t i = begin; i < end; ++i) pipeline.record(commandBuffer);
+            };
+            state.recorder->record(*state.pass, drawCount, recordDraws);
+        },
+        [&state, teardownTriangle] {
+            state.recorder->destroy();
+            teardownTriangle();
+        },
+        VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+    });
+    
+    // same triangles as one instanced draw, the cpu cost is filling the instance buffer
+    scenes.push_back({"instanced",
+        [&state](VkWindow& win, RenderPass& pass) {
+            state.win = &win;
+            state.pipeline = std::make_unique<GraphicsPipeline>(win);
+            state.pipeline->setInstanced(true);
+            state.pipeline->loadVertexShader("shaders/instanced/vert.spv");
+            state.pipeline->loadFragmentShader("shaders/basic/frag.spv");
+            state.pipeline->createPipeline(pass);
+            const Vertex triangle[] = {
+                    {{-.5f,.5f,0}, {1,1,0}},
+                    {{0,-.5f,0}, {1,0,1}},
+                    {{.5f,.5f,0}, {0,1,1}},
+            };
+            state.mesh.create(win.uploader, triangle);
+            state.batcher = std::make_unique<InstanceBatcher>(win);
+            state.batcher->create(drawCount);
+        },
+        [&state] {
+            std::span<InstanceData> instances = state.batcher->add(*state.pipeline, state.mesh, drawCount);
+            for (InstanceData& instance: instances) {
+                instance.transform = glm::mat4(1);
+                instance.color = InstanceData::packColor(1, 1, 1);
+            }
+            state.batcher->record(state.win->commandPool.currentCommandBuffer().vk);
+        },
+        [&state] {
+            state.batcher->destroy();
+            state.mesh.destroy(state.win->deletionQueue);
+            state.pipeline->destroyPipeline();
+        }
+    });
+    
+    // drawCount objects over four times the screen, culled on the gpu and drawn with one indirect call
+    scenes.push_back({"indirect",
+        [&state](VkWindow& win, RenderPass& pass) {
+            if (!IndirectScene::isSupported(win)) throw std::runtime_error("device lacks drawIndirectFirstInstance");
+            state.win = &win;
+            state.pipeline = std::make_unique<GraphicsPipeline>(win);
+            state.pipeline->setInstanced(true);
+            state.pipeline->loadVertexShader("shaders/instanced/vert.spv");
+            state.pipeline->loadFragmentShader("shaders/basic/frag.spv");
+            state.pipeline->createPipeline(pass);
+            const Vertex triangle[] = {
+                    {{-.5f,.5f,0}, {1,1,0}},
+                    {{0,-.5f,0}, {1,0,1}},
+                    {{.5f,.5f,0}, {0,1,1}},
+            };
+            const uint32_t indices[] = {0, 1, 2};
+            state.mesh.create(win.uploader, triangle, indices);
+            
+            state.indirect = std::make_unique<IndirectScene>(win);
+            uint32_t side = static_cast<uint32_t>(std::sqrt(static_cast<double>(drawCount)));
+            for (uint32_t i = 0; i < drawCount; ++i) {
+                glm::vec3 center(-2 + 4.f * (i % side + .5f) / side, -2 + 4.f * (i / side + .5f) / side, .5f);
+                float scale = 2.f / side;
+                InstanceData instance{glm::mat4(1), InstanceData::packColor(1, 1, 1)};
+                instance.transform[0] = {scale, 0, 0, 0};
+                instance.transform[1] = {0, scale, 0, 0};
+                instance.transform[3] = glm::vec4(center, 1);
+                state.indirect->add(instance, center, scale);
+            }
+            state.indirect->build(state.mesh);
+            std::cout << "indirect_compacted: " << (state.indirect->isCompacted() ? "yes" : "no") << "\n";
+        },
+        [&state] { state.indirect->draw(state.win->commandPool.currentCommandBuffer().vk, *state.pipeline); },
+        [&state] {
+            state.indirect->destroy();
+            state.mesh.destroy(state.win->deletionQueue);
+            state.pipeline->destroyPipeline();
+        },
+        VK_SUBPASS_CONTENTS_INLINE,
+        [&state] { state.indirect->cull(state.win->commandPool.currentCommandBuffer().vk, Frustum::fromViewProjection(glm::mat4(1))); }
+    });
+    
+    // cullObjectCount objects over four times the screen, frustum culled on the cpu every frame, the visible ones
+    // go through the instance batcher
+    scenes.push_back({"cpu_culled",
+        [&state](VkWindow& win, RenderPass& pass) {
+            state.win = &win;
+            state.pipeline = std::make_unique<GraphicsPipeline>(win);
+            state.pipeline->setInstanced(true);
+            state.pipeline->loadVertexShader("shaders/instanced/vert.spv");
+            state.pipeline->loadFragmentShader("shaders/basic/frag.spv");
+            state.pipeline->createPipeline(pass);
+            const Vertex triangle[] = {
+                    {{-.5f,.5f,0}, {1,1,0}},
+                    {{0,-.5f,0}, {1,0,1}},
+                    {{.5f,.5f,0}, {0,1,1}},
+            };
+            state.mesh.create(win.uploader, triangle);
+            state.batcher = std::make_unique<InstanceBatcher>(win);
+            state.batcher->create(cullObjectCount);
+            
+            state.culler = std::make_unique<FrustumCuller>(&win.jobs);
+            const FrustumCuller::Kernel kernels[] = {FrustumCuller::Kernel::Scalar, FrustumCuller::Kernel::Sse, FrustumCuller::Kernel::Avx2};
+            for (FrustumCuller::Kernel kernel: kernels) {
+                if (state.cullKernel != FrustumCuller::kernelName(kernel)) continue;
+                if (!state.culler->setKernel(kernel)) throw std::runtime_error("cpu doesn't support cull kernel '" + state.cullKernel + "'");
+            }
+            std::cout << "cull_kernel: " << FrustumCuller::kernelName(state.culler->activeKernel()) << "\n";
+            
+            uint32_t side = static_cast<uint32_t>(std::sqrt(static_cast<double>(cullObjectCount)));
+            float scale = 4.f / side;
+            state.bounds.reserve(cullObjectCount);
+            state.objects.reserve(cullObjectCount);
+            for (uint32_t i = 0; i < cullObjectCount; ++i) {
+                glm::vec3 center(-2 + 4.f * (i % side + .5f) / side, -2 + 4.f * (i / side % side + .5f) / side, .5f);
+                InstanceData instance{glm::mat4(1), InstanceData::packColor(1, 1, 1)};
+                instance.transform[0] = {scale, 0, 0, 0};
+                instance.transform[1] = {0, scale, 0, 0};
+                instance.transform[3] = glm::vec4(center, 1);
+                state.objects.push_back(instance);
+                state.bounds.add(center, scale);
+            }
+        },
+        [&state] {
+            // no camera, the vertex shader outputs clip space
+            std::span<const uint32_t> visible = state.culler->cull(state.bounds, Frustum::fromViewProjection(glm::mat4(1)));
+            std::span<InstanceData> instances = state.batcher->add(*state.pipeline, state.mesh, visible.size());
+            for (size_t i = 0; i < visible.size(); ++i) instances[i] = state.objects[visible[i]];
+            state.batcher->record(state.win->commandPool.currentCommandBuffer().vk);
+        },
+        [&state] {
+            state.batcher->destroy();
+            state.mesh.destroy(state.win->deletionQueue);
+            state.pipeline->destroyPipeline();
+        }
+    });
+    
+    // dense optimized grid meshes, vertex fetch bound. --vertex-format compares Vertex against CompactVertex
+    scenes.push_back({"mesh",
+        [&state](VkWindow& win, RenderPass& pass) {
+            state.win = &win;
+            state.pipeline = std::make_unique<GraphicsPipeline>(win);
+            state.pipeline->setInstanced(true);
+            state.pipeline->loadVertexShader("shaders/instanced/vert.spv");
+            state.pipeline->loadFragmentShader("shaders/basic/frag.spv");
+            
+            MeshData grid;
+            for (uint32_t y = 0; y < meshGridSide; ++y) {
+                for (uint32_t x = 0; x < meshGridSide; ++x) {
+                    float u = static_cast<float>(x) / (meshGridSide - 1), v = static_cast<float>(y) / (meshGridSide - 1);
+                    grid.vertices.push_back({{u - .5f, v - .5f, .5f}, {u, v, 1}});
+                }
+            }
+            for (uint32_t y = 0; y + 1 < meshGridSide; ++y) {
+                for (uint32_t x = 0; x + 1 < meshGridSide; ++x) {
+                    uint32_t i = y * meshGridSide + x;
+                    grid.indices.insert(grid.indices.end(), {i, i + 1, i + meshGridSide, i + 1, i + meshGridSide + 1, i + meshGridSide});
+                }
+            }
+            MeshOptimizer::optimize(grid);
+            
+            if (state.vertexFormat == "float") state.mesh.create(win.uploader, grid.vertices, grid.indices);
+            else if (state.vertexFormat == "compact") {
+                state.pipeline->setVertexLayout<CompactVertex>();
+                VertexEncoding::QuantizedMesh quantized = VertexEncoding::quantize(grid);
+                state.mesh.create(win.uploader, quantized.vertices, quantized.indices, quantized.decode);
+            }
+            else throw std::runtime_error("unknown vertex format '" + state.vertexFormat + "'");
+            state.pipeline->createPipeline(pass);
+            std::cout << "vertex_format: " << state.vertexFormat << "\n";
+            std::cout << "mesh_triangles: " << grid.indices.size() / 3 * meshCopiesSide * meshCopiesSide << "\n";
+            
+            state.batcher = std::make_unique<InstanceBatcher>(win);
+            state.batcher->create(meshCopiesSide * meshCopiesSide);
+        },
+        [&state] {
+            std::span<InstanceData> instances = state.batcher->add(*state.pipeline, state.mesh, meshCopiesSide * meshCopiesSide);
+            float cellSize = 2.f / meshCopiesSide;
+            for (uint32_t i = 0; i < instances.size(); ++i) {
+                glm::mat4 transform(1);
+                transform[0] = {cellSize, 0, 0, 0};
+                transform[1] = {0, cellSize, 0, 0};
+                transform[3] = {-1 + (i % meshCopiesSide + .5f) * cellSize, -1 + (i / meshCopiesSide + .5f) * cellSize, 0, 1};
+                instances[i] = {transform * state.mesh.decode, InstanceData::packColor(1, 1, 1)};
+            }
+            state.batcher->record(state.win->commandPool.currentCommandBuffer().vk);
+        },
+        [&state] {
+            state.batcher->destroy();
+            state.mesh.destroy(state.win->deletionQueue);
+            state.pipeline->destroyPipeline();
+        }
+    });
+    
+    // camera moving over a world of meshes streamed from a pack under a budget that holds only part of it
+    scenes.push_back({"streaming",
+        [&state](VkWindow& win, RenderPass& pass) {
+            state.win = &win;
+            state.pipeline = std::make_unique<GraphicsPipeline>(win);
+            state.pipeline->setInstanced(true);
+            state.pipeline->loadVertexShader("shaders/instanced/vert.spv");
+            state.pipeline->loadFragmentShader("shaders/basic/frag.spv");
+            state.pipeline->createPipeline(pass);
+            
+            // a slightly different grid per cell so every one is its own asset
+            AssetPackWriter writer;
+            const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+            for (uint32_t cell = 0; cell < streamCellsSide * streamCellsSide; ++cell) {
+                MeshData grid;
+                float tint = static_cast<float>(cell) / (streamCellsSide * streamCellsSide);
+                for (uint32_t y = 0; y < streamGridSide; ++y) {
+                    for (uint32_t x = 0; x < streamGridSide; ++x) {
+                        float u = static_cast<float>(x) / (streamGridSide - 1), v = static_cast<float>(y) / (streamGridSide - 1);
+                        grid.vertices.push_back({{u - .5f, v - .5f, .5f}, {u, v, tint}});
+                    }
+                }
+                for (uint32_t y = 0; y + 1 < streamGridSide; ++y) {
+                    for (uint32_t x = 0; x + 1 < streamGridSide; ++x) {
+                        uint32_t i = y * streamGridSide + x;
+                        grid.indices.insert(grid.indices.end(), {i, i + 1, i + streamGridSide, i + 1, i + streamGridSide + 1, i + streamGridSide});
+                    }
+                }
+                writer.addMesh("cell" + std::to_string(cell), AssetVertexFormat::Float, sizeof(Vertex), std::as_bytes(std::span(grid.vertices)),
+                               grid.indices, identity);
+            }
+            state.packPath = (std::filesystem::temp_directory_path() / "citrine_bench_streaming.pack").string();
+            writer.write(state.packPath);
+            state.pack.open(state.packPath);
+            
+            state.streamer = std::make_unique<AssetStreamer>(win);
+            state.streamed.clear();
+            for (uint32_t cell = 0; cell < streamCellsSide * streamCellsSide; ++cell) state.streamed.push_back(0);
+            VkDeviceSize budget = 0;
+            for (const AssetPackEntry& entry: state.pack.entries()) budget = std::max<VkDeviceSize>(budget, entry.size);
+            state.streamer->create(state.pack, budget * streamResidentCells);
+            for (uint32_t cell = 0; cell < state.streamed.size(); ++cell) state.streamed[cell] = state.streamer->add("cell" + std::to_string(cell));
+            state.frame = 0;
+            
+            state.batcher = std::make_unique<InstanceBatcher>(win);
+            state.batcher->create(25);
+        },
+        [&state] {
+            // camera walks the rows, the 5x5 cells around it are wanted, the nearer the more important
+            uint32_t step = state.frame++ / streamFramesPerCell;
+            int32_t cameraX = step % streamCellsSide, cameraY = step / streamCellsSide % streamCellsSide;
+            float cellSize = 2.f / 5;
+            for (int32_t dy = -2; dy <= 2; ++dy) {
+                for (int32_t dx = -2; dx <= 2; ++dx) {
+                    uint32_t x = (cameraX + dx + streamCellsSide) % streamCellsSide, y = (cameraY + dy + streamCellsSide) % streamCellsSide;
+                    StreamedMesh mesh = state.streamed[y * streamCellsSide + x];
+                    state.streamer->request(mesh, 1.f / (1 + dx * dx + dy * dy));
+                    const Mesh* resident = state.streamer->get(mesh);
+                    if (resident == nullptr) continue;
+                    
+                    glm::mat4 transform(1);
+                    transform[0] = {cellSize, 0, 0, 0};
+                    transform[1] = {0, cellSize, 0, 0};
+                    transform[3] = {dx * cellSize, dy * cellSize, 0, 1};
+                    state.batcher->add(*state.pipeline, *resident, {transform * resident->decode, InstanceData::packColor(1, 1, 1)});
+                }
+            }
+            state.streamer->update();
+            state.batcher->record(state.win->commandPool.currentCommandBuffer().vk);
+        },
+        [&state] {
+            const AssetStreamer::Stats& stats = state.streamer->statistics();
+            std::cout << "stream_budget_kib: " << stats.budget / 1024 << "\n";
+            std::cout << "stream_resident: " << stats.resident << " (" << stats.residentBytes / 1024 << " KiB)\n";
+            std::cout << "stream_loads: " << stats.loads << "\n";
+            std::cout << "stream_evictions: " << stats.evictions << "\n";
+            state.batcher->destroy();
+            state.streamer->destroy();
+            state.pack.close();
+            std::filesystem::remove(state.packPath);
+            state.pipeline->destroyPipeline();
+        }
+    });
+    
+    // drawCount small checkered quads, minified so sampling walks the mip chain. --texture-format compares RGBA8
+    // against BC1 (an eighth of the bandwidth)
+    scenes.push_back({"textured",
+        [&state](VkWindow& win, RenderPass& pass) {
+            state.win = &win;
+            state.pipeline = std::make_unique<GraphicsPipeline>(win);
+            state.pipeline->setInstanced(true);
+            state.pipeline->setVertexLayout<TexturedVertex>();
+            state.pipeline->loadVertexShader("shaders/textured/vert.spv");
+            state.pipeline->loadFragmentShader("shaders/textured/frag.spv");
+            state.pipeline->createTextureSet(1);
+            state.pipeline->createPipeline(pass);
+            
+            std::vector<uint8_t> pixels(textureSide * textureSide * 4);
+            for (uint32_t y = 0; y < textureSide; ++y) {
+                for (uint32_t x = 0; x < textureSide; ++x) {
+                    bool odd = (x / checkerSide + y / checkerSide) % 2;
+                    uint8_t* pixel = &pixels[(y * textureSide + x) * 4];
+                    pixel[0] = odd ? 230 : 40;
+                    pixel[1] = odd ? 180 : 60;
+                    pixel[2] = odd ? 40 : 120;
+                    pixel[3] = 255;
+                }
+            }
+            state.texture = std::make_unique<Texture>(win);
+            if (state.textureFormat == "rgba8") state.texture->create(pixels.data(), textureSide, textureSide);
+            else if (state.textureFormat == "bc1") {
+                std::vector<std::vector<std::byte>> levels;
+                uint32_t size = textureSide;
+                while (true) {
+                    levels.push_back(encodeBc1(pixels, size, size));
+                    if (size == 1) break;
+                    pixels = downsample(pixels, size, size);
+                    size /= 2;
+                }
+                Ktx2Image image{};
+                image.vkFormat = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+                image.width = textureSide;
+                image.height = textureSide;
+                for (const auto& level: levels) image.levels.emplace_back(level);
+                state.texture->create(image);
+            }
+            else throw std::runtime_error("unknown texture format '" + state.textureFormat + "'");
+            state.pipeline->setTexture(0, *state.texture, win.samplers.get());
+            std::cout << "texture_format: " << state.textureFormat << " (" << state.texture->mipLevels << " levels)\n";
+            
+            const TexturedVertex quad[] = {
+                    {{-.5f,-.5f,0}, {0,0}},
+                    {{.5f,-.5f,0}, {1,0}},
+                    {{.5f,.5f,0}, {1,1}},
+                    {{-.5f,.5f,0}, {0,1}},
+            };
+            const uint32_t indices[] = {0, 1, 2, 2, 3, 0};
+            state.mesh.create(win.uploader, quad, indices);
+            
+            // 100x100 quads over the screen, each about a hundredth of it
+            uint32_t side = static_cast<uint32_t>(std::sqrt(static_cast<double>(drawCount)));
+            float size = 2.f / static_cast<float>(side);
+            state.objects.clear();
+            for (uint32_t i = 0; i < drawCount; ++i) {
+                glm::mat4 transform(1);
+                transform[0] = {size, 0, 0, 0};
+                transform[1] = {0, size, 0, 0};
+                transform[3] = {-1 + size * (static_cast<float>(i % side) + .5f), -1 + size * (static_cast<float>(i / side % side) + .5f), 0, 1};
+                state.objects.push_back({transform, InstanceData::packColor(1, 1, 1)});
+            }
+            state.batcher = std::make_unique<InstanceBatcher>(win);
+            state.batcher->create(drawCount);
+        },
+        [&state] {
+            std::span<InstanceData> instances = state.batcher->add(*state.pipeline, state.mesh, drawCount);
+            std::copy(state.objects.begin(), state.objects.end(), instances.begin());
+            state.batcher->record(state.win->commandPool.currentCommandBuffer().vk);
+        },
+        [&state] {
+            state.batcher->destroy();
+            state.mesh.destroy(state.win->deletionQueue);
+            state.texture->destroy();
+            state.pipeline->destroyTextureSet();
+            state.pipeline->destroyPipeline();
+        },
+        VK_SUBPASS_CONTENTS_INLINE,
+        // mips are blitted once the upload landed, outside the render pass
+        [&state] { state.texture->prepare(state.win->commandPool.currentCommandBuffer().vk); }
+    });
+    
+    return scenes;
+}
+
+static int runBench(const BenchOptions& options) {
+    BenchState state;
+    state.cullKernel = options.cullKernel;
+    state.vertexFormat = options.vertexFormat;
+    state.textureFormat = options.textureFormat;
+    std::vector<BenchScene> scenes = createScenes(state);
+    auto scene = std::find_if(scenes.begin(), scenes.end(), [&](const BenchScene& s) { return s.name == options.scene; });
+    if (scene == scenes.end()) throw std::runtime_error("unknown scene '" + options.scene + "'");
+    
+    FrameSettings frameSettings{};
+    frameSettings.framesInFlight = options.framesInFlight;
+    frameSettings.dynamicRendering = options.dynamicRendering;
+    VkWindow win(options.extent, frameSettings);
+    bool dynamicRendering = win.device.dynamicRendering;
+    
+    RenderPass pass(win);
+    pass.createRenderPass();
+    scene->setup(win, pass);
+    win.createFramebuffers(pass.renderPass);
+    
+    std::vector<double> frameTimes;
+    frameTimes.reserve(options.frames);
+    std::vector<GpuScopeTotal> gpuScopes;
+    
+    auto prevTime = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < options.warmupFrames + options.frames; ++frame) {
+        win.startCommandBuffer();
+        {
+            CITRINE_PROFILE_SCOPE("record commands");
+            if (scene->prepare) scene->prepare();
+            pass.startRenderPass(scene->contents);
+            scene->record();
+            pass.endRenderPass();
+        }
+        win.endCommandBuffer();
+        
+        auto curTime = std::chrono::steady_clock::now();
+        if (frame >= options.warmupFrames) {
+            frameTimes.push_back(std::chrono::duration<double, std::milli>(curTime - prevTime).count());
+            // results lag maxFramesInFlight behind, which doesn't matter for averages over many frames
+            accumulateGpuScopes(win.profiler.results(), gpuScopes);
+        }
+        prevTime = curTime;
+    }
+    win.device.WaitIdle();
+    win.allocator.printStats();
+    if (!options.tracePath.empty() && !Profiler::writeChromeTrace(options.tracePath)) std::cout << "failed to write trace '" << options.tracePath << "'\n";
+    bool gpuProfiled = win.profiler.enabled;
+    std::vector<GpuScopeResult> lastGpuScopes = win.profiler.results();
+    
+    scene->teardown();
+    pass.destroyRenderPass();
+    win.Close();
+    
+    std::vector<double> sorted = frameTimes;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0;
+    for (double t: frameTimes) total += t;
+    double average = sorted.empty() ? 0 : total / static_cast<double>(sorted.size());
+    
+    std::cout << "scene: " << options.scene << "\n";
+    std::cout << "extent: " << options.extent.width << "x" << options.extent.height << "\n";
+    std::cout << "frames_in_flight: " << options.framesInFlight << "\n";
+    std::cout << "dynamic_rendering: " << (dynamicRendering ? "on" : "off") << "\n";
+    std::cout << "frames: " << sorted.size() << "\n";
+    std::cout << "avg_ms: " << average << "\n";
+    std::cout << "min_ms: " << (sorted.empty() ? 0 : sorted.front()) << "\n";
+    std::cout << "p50_ms: " << percentile(sorted, .50) << "\n";
+    std::cout << "p90_ms: " << percentile(sorted, .90) << "\n";
+    std::cout << "p95_ms: " << percentile(sorted, .95) << "\n";
+    std::cout << "p99_ms: " << percentile(sorted, .99) << "\n";
+    std::cout << "max_ms: " << (sorted.empty() ? 0 : sorted.back()) << "\n";
+    std::cout << "fps: " << (average > 0 ? 1000.0 / average : 0) << "\n";
+    if (!gpuProfiled) return 0;
+    for (const auto& scope: gpuScopes) {
+        std::string key = scope.name;
+        std::replace(key.begin(), key.end(), ' ', '_');
+        std::cout << "gpu_" << key << "_ms: " << scope.totalMilliseconds / scope.samples << "\n";
+    }
+    for (const auto& scope: lastGpuScopes) {
+        if (!scope.hasStatistics) continue;
+        std::string key = scope.name;
+        std::replace(key.begin(), key.end(), ' ', '_');
+        std::cout << "gpu_" << key << "_fs_invocations: " << scope.statistics.fragmentInvocations << "\n";
+        std::cout << "gpu_" << key << "_vs_invocations: " << scope.statistics.vertexInvocations << "\n";
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage();
+            return 0;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "citrine_bench: " << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+    
+    try {
+        return runBench(options);
+    } catch (const std::exception& e) {
+        std::cerr << "citrine_bench: " << e.what() << "\n";
+        return 1;
+    }
+}
@@ -1,26 +1,252 @@
 #include <iostream>
 #include "src/renderer/vk/VkHelper.h"
-#include "src/renderer/vk/RenderPass.h"
+#include "src/renderer/vk/RenderGraph.h"
 #include "src/renderer/vk/VkWindow.h"
 #include "src/renderer/vk/GraphicsPipeline.h"
+#include "src/renderer/vk/InstanceBatcher.h"
+#include "src/renderer/vk/IndirectScene.h"
+#include "src/renderer/vk/Texture.h"
+#include "src/renderer/RenderThread.h"
+#include "src/renderer/ObjLoader.h"
+#include "src/renderer/MeshOptimizer.h"
+#include "src/renderer/VertexEncoding.h"
+#include "src/core/FrameLimiter.h"
+#include "src/core/AssetPack.h"
 #include <glm/glm.hpp>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <charconv>
 
 
 bool iconified = true;
 int width, height;
-int main() {
+PresentPolicy presentPolicy = PresentPolicy::LowLatency;
+
+static const char* presentPolicyName(PresentPolicy policy) {
+    switch (policy) {
+        case PresentPolicy::LowLatency: return "low-latency";
+        case PresentPolicy::Throughput: return "throughput";
+        case PresentPolicy::PowerSaving: return "power-saving";
+    }
+    return "?";
+}
+
+static void printUsage() {
+    std::cout << "usage: Citrine [--frames-in-flight N] [--present low-latency|throughput|power-saving] [--fps-cap FPS] [--dynamic-rendering on|off] [--mesh FILE.obj|NAME] [--texture FILE.ktx2|NAME] [--pack FILE.pack]\n";
+}
+
+// the whole argument as a number, false on anything else
+template<typename T>
+static bool parseNumber(const std::string& value, T& number) {
+    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), number);
+    return error == std::errc() && end == value.data() + value.size();
+}
+
+static bool parseOptions(int argc, char** argv, FrameSettings& settings, double& fpsCap, std::string& meshPath, std::string& texturePath,
+                         std::string& packPath) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h" || i + 1 >= argc) return false;
+        std::string value = argv[++i];
+        
+        if (arg == "--frames-in-flight") {
+            if (!parseNumber(value, settings.framesInFlight) || settings.framesInFlight == 0) return false;
+        }
+        else if (arg == "--fps-cap") {
+            if (!parseNumber(value, fpsCap) || fpsCap < 0) return false;
+        }
+        else if (arg == "--dynamic-rendering") settings.dynamicRendering = value != "off";
+        else if (arg == "--mesh") meshPath = value;
+        else if (arg == "--texture") texturePath = value;
+        else if (arg == "--pack") packPath = value;
+        else if (arg == "--present") {
+            if (value == "low-latency") settings.presentPolicy = PresentPolicy::LowLatency;
+            else if (value == "throughput") settings.presentPolicy = PresentPolicy::Throughput;
+            else if (value == "power-saving") settings.presentPolicy = PresentPolicy::PowerSaving;
+            else return false;
+        }
+        else return false;
+    }
+    return true;
+}
+
+// obj file optimized for the vertex cache, overdraw and vertex fetch, scaled into a unit cube around the origin
+static MeshData loadMesh(const std::string& path) {
+    MeshData mesh = ObjLoader::load(path);
+    uint32_t corners = mesh.vertices.size();
+    // deduplicates first, the loader emits a vertex per face corner
+    MeshOptimizer::optimize(mesh);
+    float acmr = MeshOptimizer::averageCacheMissRatio(mesh.indices, mesh.vertices.size());
+    std::cout << path << ": " << mesh.indices.size() / 3 << " triangles, " << corners << " -> " << mesh.vertices.size()
+              << " vertices, acmr " << acmr << "\n";
+    
+    glm::vec3 min(std::numeric_limits<float>::max()), max(std::numeric_limits<float>::lowest());
+    for (const Vertex& vertex: mesh.vertices) {
+        min = glm::min(min, vertex.pos);
+        max = glm::max(max, vertex.pos);
+    }
+    glm::vec3 size = max - min;
+    float scale = 1 / std::max(std::max(size.x, size.y), std::max(size.z, 1e-6f));
+    glm::vec3 center = (min + max) * .5f;
+    // obj is y up, clip space y points down
+    for (Vertex& vertex: mesh.vertices) {
+        vertex.pos = (vertex.pos - center) * scale;
+        vertex.pos.y = -vertex.pos.y;
+        vertex.pos.z += .5f;
+    }
+    return mesh;
+}
+
+int main(int argc, char** argv) {
+    CITRINE_PROFILE_THREAD("main");
+    FrameSettings frameSettings{};
+    // 0 renders as fast as the present mode allows
+    double fpsCap = 0;
+    // drawn instead of the triangle in the instanced grid
+    std::string meshPath;
+    // ktx2 drawn on a quad in the corner
+    std::string texturePath;
+    // shaders (and meshes named by --mesh, textures named by --texture) come from the pack instead of single files, see citrine_pack
+    std::string packPath;
+    if (!parseOptions(argc, argv, frameSettings, fpsCap, meshPath, texturePath, packPath)) {
+        printUsage();
+        return 1;
+    }
+    presentPolicy = frameSettings.presentPolicy;
+    
     VkHelper::Initialize();
-    VkWindow win = VkWindow();
+    VkWindow win = VkWindow(frameSettings);
+    std::cout << "dynamic rendering: " << (win.device.dynamicRendering ? "on" : "off") << "\n";
     
-    RenderPass pass(win);
-    pass.createRenderPass();
+    AssetPack pack;
+    if (!packPath.empty()) {
+        pack.open(packPath);
+        std::cout << "asset pack: " << pack.entries().size() << " assets\n";
+    }
+    // borrowed straight from the mapping when there is a pack, the pack outlives every pipeline
+    auto loadShaders = [&pack](GraphicsPipeline& target, const char* vertexShader, const char* fragmentShader) {
+        if (pack.isOpen()) {
+            target.setVertexShader(pack.shader(vertexShader));
+            target.setFragmentShader(pack.shader(fragmentShader));
+            return;
+        }
+        target.loadVertexShader(vertexShader);
+        target.loadFragmentShader(fragmentShader);
+    };
     
     GraphicsPipeline pipeline(win);
-    pipeline.loadVertexShader("shaders/basic/basic.vert");
-    pipeline.loadFragmentShader("shaders/basic/basic.frag");
-    pipeline.createPipeline(pass.renderPass);
+    loadShaders(pipeline, "shaders/basic/vert.spv", "shaders/basic/frag.spv");
+    pipeline.createVertexBuffer();
+    
+    // grid of small triangles, all in one instanced draw
+    GraphicsPipeline instancedPipeline(win);
+    instancedPipeline.setInstanced(true);
+    loadShaders(instancedPipeline, "shaders/instanced/vert.spv", "shaders/basic/frag.spv");
+    const Vertex triangle[] = {
+            {{-.5f,.5f,0}, {1,1,0}},
+            {{0,-.5f,0}, {1,0,1}},
+            {{.5f,.5f,0}, {0,1,1}},
+    };
+    const uint32_t triangleIndices[] = {0, 1, 2};
+    Mesh triangleMesh;
+    triangleMesh.create(win.uploader, triangle, triangleIndices);
+    // loaded meshes are quantized, same shaders with the CompactVertex layout
+    GraphicsPipeline compactPipeline(win);
+    compactPipeline.setInstanced(true);
+    compactPipeline.setVertexLayout<CompactVertex>();
+    loadShaders(compactPipeline, "shaders/instanced/vert.spv", "shaders/basic/frag.spv");
+    Mesh loadedMesh;
+    bool loadedCompact = true;
+    if (pack.isOpen() && pack.find(meshPath) != nullptr) {
+        // already optimized and encoded by the packer, copied from the mapping into staging
+        AssetPack::MeshView view = pack.mesh(meshPath);
+        loadedCompact = view.header->vertexFormat == AssetVertexFormat::Compact;
+        loadedMesh.create(win.uploader, view);
+        // same unit cube fit as loadMesh, through the decode matrix. float meshes are drawn as packed
+        if (loadedCompact) {
+            glm::vec3 extent(loadedMesh.decode[0][0], loadedMesh.decode[1][1], loadedMesh.decode[2][2]);
+            float scale = .5f / std::max(std::max(extent.x, extent.y), extent.z);
+            loadedMesh.decode = glm::mat4(1);
+            loadedMesh.decode[0][0] = extent.x * scale;
+            loadedMesh.decode[1][1] = -extent.y * scale;
+            loadedMesh.decode[2][2] = extent.z * scale;
+            loadedMesh.decode[3] = {0, 0, .5f, 1};
+        }
+    }
+    else if (!meshPath.empty()) {
+        VertexEncoding::QuantizedMesh data = VertexEncoding::quantize(loadMesh(meshPath));
+        std::cout << "vertex size: " << sizeof(Vertex) << " -> " << sizeof(CompactVertex) << " bytes\n";
+        loadedMesh.create(win.uploader, data.vertices, data.indices, data.decode);
+    }
+    const Mesh& gridMesh = meshPath.empty() ? triangleMesh : loadedMesh;
+    GraphicsPipeline& gridPipeline = meshPath.empty() || !loadedCompact ? instancedPipeline : compactPipeline;
+    InstanceBatcher batcher(win);
+    batcher.create();
+    constexpr uint32_t gridSize = 32;
+    
+    // --texture: uploaded as stored (compressed formats stay compressed), sampled by a quad in the top left corner
+    bool textured = !texturePath.empty();
+    GraphicsPipeline texturedPipeline(win);
+    texturedPipeline.setInstanced(true);
+    texturedPipeline.setVertexLayout<TexturedVertex>();
+    loadShaders(texturedPipeline, "shaders/textured/vert.spv", "shaders/textured/frag.spv");
+    Texture texture(win);
+    Mesh quadMesh;
+    if (textured) {
+        if (pack.isOpen() && pack.find(texturePath) != nullptr) texture.create(Ktx2::parse(pack.texture(texturePath)));
+        else texture.load(texturePath);
+        std::cout << texturePath << ": " << texture.extent.width << "x" << texture.extent.height << ", " << texture.mipLevels
+                  << " levels, format " << texture.format << "\n";
+        texturedPipeline.createTextureSet(1);
+        texturedPipeline.setTexture(0, texture, win.samplers.get());
+        const TexturedVertex quad[] = {
+                {{-.5f,-.5f,0}, {0,0}},
+                {{.5f,-.5f,0}, {1,0}},
+                {{.5f,.5f,0}, {1,1}},
+                {{-.5f,.5f,0}, {0,1}},
+        };
+        const uint32_t quadIndices[] = {0, 1, 2, 2, 3, 0};
+        quadMesh.create(win.uploader, quad, quadIndices);
+    }
+    
+    // static field of tiny triangles, four times the screen. culled on the gpu, visible ones drawn indirectly
+    IndirectScene field(win);
+    if (pack.isOpen()) field.setCullShader(pack.shader("shaders/cull/comp.spv"));
+    bool gpuCulling = IndirectScene::isSupported(win);
+    if (gpuCulling) {
+        constexpr uint32_t fieldSize = 128;
+        for (uint32_t y = 0; y < fieldSize; ++y) {
+            for (uint32_t x = 0; x < fieldSize; ++x) {
+                float scale = .01f;
+                glm::vec3 center(-2 + 4.f * (x + .5f) / fieldSize, -2 + 4.f * (y + .5f) / fieldSize, .5f);
+                InstanceData instance{glm::mat4(1), InstanceData::packColor(.3f, .3f, .3f)};
+                instance.transform[0] = {scale, 0, 0, 0};
+                instance.transform[1] = {0, scale, 0, 0};
+                instance.transform[3] = glm::vec4(center, 1);
+                field.add(instance, center, scale);
+            }
+        }
+        field.build(triangleMesh);
+    }
+    std::cout << "gpu culling: " << (gpuCulling ? "on" : "off") << "\n";
     
-    win.createFramebuffers(pass.renderPass);
+    // single pass for now: clear the backbuffer, draw the triangle and the grid
+    RenderGraph graph(win);
+    RenderGraphImage backbuffer = graph.importBackbuffer();
+    VkClearValue clearColor = {{{0,0,0,1}}};
+    RenderGraphPass mainPass = graph.addPass("main", [&](VkCommandBuffer commandBuffer) {
+        if (pipeline.prepare()) pipeline.record(commandBuffer);
+        field.draw(commandBuffer, instancedPipeline);
+        batcher.record(commandBuffer);
+    });
+    graph.writeColor(mainPass, backbuffer, &clearColor);
+    graph.compile();
+    
+    pipeline.createPipeline(graph, mainPass);
+    instancedPipeline.createPipeline(graph, mainPass);
+    compactPipeline.createPipeline(graph, mainPass);
+    if (textured) texturedPipeline.createPipeline(graph, mainPass);
 
     glfwMakeContextCurrent(win.glfwWindow);
     iconified = glfwGetWindowAttrib(win.glfwWindow, GLFW_ICONIFIED);
@@ -32,45 +258,139 @@ int main() {
         height = h;
     });
 
-    glfwGetWindowSize(win.glfwWindow, &width, &height);
+    // F12 dumps the cpu/gpu trace of the last few thousand events per thread, P cycles the present policy
+    glfwSetKeyCallback(win.glfwWindow, [](GLFWwindow* window, int key, int scancode, int action, int mods) {
+        if (action != GLFW_PRESS) return;
+        if (key == GLFW_KEY_F12 && Profiler::writeChromeTrace("citrine_trace.json")) std::cout << "wrote citrine_trace.json\n";
+        if (key == GLFW_KEY_P) {
+            presentPolicy = static_cast<PresentPolicy>((static_cast<int>(presentPolicy) + 1) % 3);
+            std::cout << "present policy: " << presentPolicyName(presentPolicy) << "\n";
+        }
+    });
+
+    glfwGetFramebufferSize(win.glfwWindow, &width, &height);
     
     
     
+    // render thread: records and submits frame N while this thread handles events for frame N + 1
+    RenderThread renderThread;
+    renderThread.start([&](const FrameSnapshot& frame) {
+        win.setPresentPolicy(frame.presentPolicy);
+        if (!win.startCommandBuffer()) {
+            // pipeline uses dynamic viewport/scissor, it only depends on the attachment formats (i.e. the surface format).
+            // the graph recompiles by itself for the new swapchain, only a format change needs the pipeline rebuilt
+            if (win.recreateSwapChain(frame.framebufferExtent)) {
+                pipeline.destroyPipeline();
+                graph.compile();
+                pipeline.createPipeline(graph, mainPass);
+                instancedPipeline.destroyPipeline();
+                instancedPipeline.createPipeline(graph, mainPass);
+                compactPipeline.destroyPipeline();
+                compactPipeline.createPipeline(graph, mainPass);
+                if (textured) {
+                    texturedPipeline.destroyPipeline();
+                    texturedPipeline.createPipeline(graph, mainPass);
+                }
+            }
+            return;
+        }
+        {
+            CITRINE_PROFILE_SCOPE("instances");
+            // scaled down copies spinning in place, clip space so no camera is needed
+            std::span<InstanceData> instances = batcher.add(gridPipeline, gridMesh, gridSize * gridSize);
+            float cellSize = 2.f / gridSize;
+            for (uint32_t y = 0; y < gridSize; ++y) {
+                for (uint32_t x = 0; x < gridSize; ++x) {
+                    float angle = static_cast<float>(frame.time) + (x + y) * .2f;
+                    float scale = cellSize * .8f;
+                    InstanceData& instance = instances[y * gridSize + x];
+                    instance.transform = glm::mat4(1);
+                    instance.transform[0] = {std::cos(angle) * scale, std::sin(angle) * scale, 0, 0};
+                    instance.transform[1] = {-std::sin(angle) * scale, std::cos(angle) * scale, 0, 0};
+                    instance.transform[3] = {-1 + (x + .5f) * cellSize, -1 + (y + .5f) * cellSize, 0, 1};
+                    instance.transform = instance.transform * gridMesh.decode;
+                    instance.color = InstanceData::packColor(static_cast<float>(x) / gridSize, static_cast<float>(y) / gridSize, 1);
+                }
+            }
+            if (textured) {
+                glm::mat4 transform(1);
+                transform[0] = {.5f, 0, 0, 0};
+                transform[1] = {0, .5f, 0, 0};
+                transform[3] = {-.75f, -.75f, 0, 1};
+                batcher.add(texturedPipeline, quadMesh, {transform, InstanceData::packColor(1, 1, 1)});
+            }
+        }
+        {
+            CITRINE_PROFILE_SCOPE("record commands");
+            VkCommandBuffer commandBuffer = win.commandPool.currentCommandBuffer().vk;
+            // no camera, the vertex shader outputs clip space
+            field.cull(commandBuffer, Frustum::fromViewProjection(glm::mat4(1)));
+            // outside the render pass, blits the mips once the upload landed
+            if (textured) texture.prepare(commandBuffer);
+            graph.execute(commandBuffer);
+        }
+        win.endCommandBuffer();
+    });
+    
+    // paces snapshots rather than the render thread, so a capped frame still starts from fresh input
+    FrameLimiter limiter;
+    limiter.setTargetFps(fpsCap);
+    // the limiter already waited for this frame, its snapshot didn't fit into the render queue yet
+    bool framePending = false;
+    
     double prevTime = glfwGetTime();
-    int frames = 0;
-    while (!glfwWindowShouldClose(win.glfwWindow)) {
-        glfwPollEvents();
+    uint64_t prevFrames = 0;
+    uint64_t frame = 0;
+    while (!glfwWindowShouldClose(win.glfwWindow) && !renderThread.hasFailed()) {
+        bool hidden = iconified || width < 5 || height < 5;
+        // nothing to render, sleep until an event restores the window. the timeout keeps main thread jobs running
+        if (hidden) glfwWaitEventsTimeout(0.1);
+        else glfwPollEvents();
+        // jobs that have to run on the main thread (glfw calls), submitted with JobSystem::setMainThread
+        win.jobs.pumpMainThread();
         double curTime = glfwGetTime();
         if (curTime >= prevTime + 1) {
             prevTime = curTime;
-            std::cout << "fps: " << frames << "\n";
-            frames = -1;
+            uint64_t rendered = renderThread.framesRendered();
+            std::cout << "fps: " << rendered - prevFrames << "\n";
+            prevFrames = rendered;
         }
-        frames++;
         
-        if (iconified || width < 5 || height < 5) continue;
+        if (hidden) continue;
         
-        if (!win.startCommandBuffer()) {
-            pipeline.destroyPipeline();
-            pass.destroyRenderPass();
-            
-            win.recreateSwapChain();
-            
-            pass.createRenderPass();
-            pipeline.createPipeline(pass.renderPass);
-            win.createFramebuffers(pass.renderPass);
-            
-            continue;
+        if (!framePending) {
+            limiter.wait();
+            framePending = true;
         }
-        pass.startRenderPass();
-        pipeline.bindPipeline();
-        pass.endRenderPass();
-        win.endCommandBuffer();
+        FrameSnapshot snapshot{};
+        snapshot.frame = frame;
+        snapshot.time = glfwGetTime();
+        snapshot.framebufferExtent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+        snapshot.presentPolicy = presentPolicy;
+        // render thread is maxQueuedFrames behind: keep handling events and hand over a fresher snapshot next round
+        if (renderThread.submit(snapshot)) {
+            frame++;
+            framePending = false;
+        }
+        else glfwWaitEventsTimeout(0.001);
     }
+    renderThread.stop();
+    // the only device wide stall, at shutdown. everything retired below is freed by Close right away
     vkDeviceWaitIdle(win.device.device);
     
-    pass.destroyRenderPass();
+    graph.destroy();
+    batcher.destroy();
+    field.destroy();
+    triangleMesh.destroy(win.deletionQueue);
+    loadedMesh.destroy(win.deletionQueue);
+    quadMesh.destroy(win.deletionQueue);
+    texture.destroy();
+    texturedPipeline.destroyTextureSet();
+    if (textured) texturedPipeline.destroyPipeline();
+    instancedPipeline.destroyPipeline();
+    compactPipeline.destroyPipeline();
     pipeline.destroyPipeline();
+    pipeline.destroyVertexBuffer();
     win.Close();
     return 0;
 }
\ No newline at end of file
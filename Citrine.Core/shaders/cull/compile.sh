@@ -0,0 +1 @@
+glslc cull.comp -o comp.spv
\ No newline at end of file
@@ -0,0 +1 @@
+glslc instanced.vert -o vert.spv
\ No newline at end of file
@@ -0,0 +1,15 @@
+#version 450
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec3 col;
+
+// per instance (binding 1, see InstanceData)
+layout(location = 2) in mat4 transform;
+layout(location = 6) in vec4 instanceColor;
+
+layout(location = 0) out vec3 fragColor;
+
+void main() {
+    gl_Position = transform * vec4(pos, 1.0);
+    fragColor = col * instanceColor.rgb;
+}
\ No newline at end of file
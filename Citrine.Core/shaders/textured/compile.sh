@@ -0,0 +1,2 @@
+glslc textured.vert -o vert.spv
+glslc textured.frag -o frag.spv
\ No newline at end of file
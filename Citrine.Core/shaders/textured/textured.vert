@@ -0,0 +1,17 @@
+#version 450
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec2 uv;
+
+// per instance (binding 1, see InstanceData)
+layout(location = 2) in mat4 transform;
+layout(location = 6) in vec4 instanceColor;
+
+layout(location = 0) out vec2 fragUv;
+layout(location = 1) out vec4 fragColor;
+
+void main() {
+    gl_Position = transform * vec4(pos, 1.0);
+    fragUv = uv;
+    fragColor = instanceColor;
+}
\ No newline at end of file
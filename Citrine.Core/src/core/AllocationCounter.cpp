@@ -0,0 +1,55 @@
+#include "AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+#ifdef CITRINE_COUNT_ALLOCATIONS
+
+namespace {
+    thread_local uint64_t allocations = 0;
+}
+
+uint64_t AllocationCounter::threadAllocations() {
+    return allocations;
+}
+
+// nothrow variants forward to these by default. the rest is replaced too, so every new/delete pair matches
+// even when another library (e.g. a sanitizer runtime) provides its own defaults
+void* operator new(std::size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    allocations++;
+    auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a multiple of the alignment
+    size = (size + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, size == 0 ? align : size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+#else
+
+uint64_t AllocationCounter::threadAllocations() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef CITRINE_ALLOCATIONCOUNTER_H
+#define CITRINE_ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+// counts global operator new calls per thread. only active when CITRINE_COUNT_ALLOCATIONS is defined
+// (cmake does that for debug builds), otherwise operator new is untouched and the count stays 0.
+// allocations of C libraries (drivers, glfw) go through malloc and are not counted.
+struct AllocationCounter {
+    static constexpr bool enabled =
+#ifdef CITRINE_COUNT_ALLOCATIONS
+            true;
+#else
+            false;
+#endif
+
+    [[nodiscard]] static uint64_t threadAllocations();
+};
+
+#endif //CITRINE_ALLOCATIONCOUNTER_H
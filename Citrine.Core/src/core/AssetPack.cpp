@@ -0,0 +1,182 @@
+#include "AssetPack.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    uint64_t alignUp(uint64_t value) {
+        return (value + assetPackAlignment - 1) / assetPackAlignment * assetPackAlignment;
+    }
+
+    // bytes at offset lie within size, without the overflow offset + bytes has for offsets read from a file
+    bool fits(uint64_t offset, uint64_t bytes, uint64_t size) {
+        return offset <= size && bytes <= size - offset;
+    }
+}
+
+void AssetPack::open(const std::string& path) {
+    close();
+    int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) throw std::runtime_error("failed to open asset pack '" + path + "' (AssetPack.cpp)");
+    struct stat status{};
+    if (fstat(file, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(AssetPackHeader))) {
+        ::close(file);
+        throw std::runtime_error("asset pack '" + path + "' is truncated (AssetPack.cpp)");
+    }
+    mappedSize = status.st_size;
+    void* mapped = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, file, 0);
+    // the mapping keeps the file alive
+    ::close(file);
+    if (mapped == MAP_FAILED) throw std::runtime_error("failed to map asset pack '" + path + "' (AssetPack.cpp)");
+    mapping = mapped;
+    
+    header = static_cast<const AssetPackHeader*>(mapping);
+    // everything past here indexes into the mapping, so the tables have to fit before anything reads them
+    uint64_t tableEnd = sizeof(AssetPackHeader) + static_cast<uint64_t>(header->entryCount) * sizeof(AssetPackEntry);
+    bool valid = header->magic == assetPackMagic && header->version == assetPackVersion && header->fileSize == mappedSize &&
+                 tableEnd <= mappedSize && fits(header->namesOffset, header->namesSize, mappedSize);
+    if (valid) {
+        entryTable = {reinterpret_cast<const AssetPackEntry*>(header + 1), header->entryCount};
+        names = static_cast<const char*>(mapping) + header->namesOffset;
+        for (const AssetPackEntry& entry: entryTable) {
+            valid = valid && entry.offset % assetPackAlignment == 0 && fits(entry.offset, entry.size, mappedSize) &&
+                    fits(entry.nameOffset, entry.nameLength, header->namesSize);
+        }
+    }
+    if (!valid) {
+        close();
+        throw std::runtime_error("'" + path + "' is not a valid asset pack (AssetPack.cpp)");
+    }
+}
+
+void AssetPack::close() {
+    if (mapping != nullptr) munmap(mapping, mappedSize);
+    mapping = nullptr;
+    mappedSize = 0;
+    header = nullptr;
+    entryTable = {};
+    names = nullptr;
+}
+
+const AssetPackEntry* AssetPack::find(std::string_view assetName) const {
+    auto it = std::lower_bound(entryTable.begin(), entryTable.end(), assetName, [this](const AssetPackEntry& entry, std::string_view value) {
+        return name(entry) < value;
+    });
+    if (it == entryTable.end() || name(*it) != assetName) return nullptr;
+    return &*it;
+}
+
+std::span<const std::byte> AssetPack::data(const AssetPackEntry& entry) const {
+    return {static_cast<const std::byte*>(mapping) + entry.offset, entry.size};
+}
+
+std::span<const char> AssetPack::shader(std::string_view assetName) const {
+    const AssetPackEntry* entry = find(assetName);
+    if (entry == nullptr || entry->type != AssetType::Shader) throw std::runtime_error("no shader '" + std::string(assetName) + "' in the asset pack (AssetPack.cpp)");
+    std::span<const std::byte> bytes = data(*entry);
+    return {reinterpret_cast<const char*>(bytes.data()), bytes.size()};
+}
+
+AssetPack::MeshView AssetPack::mesh(std::string_view assetName) const {
+    const AssetPackEntry* entry = find(assetName);
+    if (entry == nullptr || entry->type != AssetType::Mesh) throw std::runtime_error("no mesh '" + std::string(assetName) + "' in the asset pack (AssetPack.cpp)");
+    std::span<const std::byte> bytes = data(*entry);
+    if (bytes.size() < sizeof(MeshAssetHeader)) throw std::runtime_error("mesh '" + std::string(assetName) + "' is truncated (AssetPack.cpp)");
+    
+    const auto* meshHeader = reinterpret_cast<const MeshAssetHeader*>(bytes.data());
+    // Mesh::create reads the vertices as the format's struct and anything but 2 byte indices as 4 byte ones
+    if (meshHeader->vertexStride != assetVertexStride(meshHeader->vertexFormat) || (meshHeader->indexSize != 2 && meshHeader->indexSize != 4)) {
+        throw std::runtime_error("mesh '" + std::string(assetName) + "' has an unknown vertex format or index size (AssetPack.cpp)");
+    }
+    // counts are 32 bit, so these products can't overflow
+    uint64_t vertexBytes = static_cast<uint64_t>(meshHeader->vertexCount) * meshHeader->vertexStride;
+    uint64_t indexBytes = static_cast<uint64_t>(meshHeader->indexCount) * meshHeader->indexSize;
+    if (!fits(meshHeader->vertexOffset, vertexBytes, bytes.size()) || !fits(meshHeader->indexOffset, indexBytes, bytes.size())) {
+        throw std::runtime_error("mesh '" + std::string(assetName) + "' is truncated (AssetPack.cpp)");
+    }
+    return {meshHeader, bytes.subspan(meshHeader->vertexOffset, vertexBytes), bytes.subspan(meshHeader->indexOffset, indexBytes)};
+}
+
+std::span<const std::byte> AssetPack::texture(std::string_view assetName) const {
+    const AssetPackEntry* entry = find(assetName);
+    if (entry == nullptr || entry->type != AssetType::Texture) throw std::runtime_error("no texture '" + std::string(assetName) + "' in the asset pack (AssetPack.cpp)");
+    return data(*entry);
+}
+
+void AssetPackWriter::add(std::string name, AssetType type, std::span<const std::byte> data) {
+    for (const Asset& asset: assets) {
+        if (asset.name == name) throw std::runtime_error("asset '" + name + "' added twice (AssetPack.cpp)");
+    }
+    assets.push_back({std::move(name), type, {data.begin(), data.end()}});
+}
+
+void AssetPackWriter::addMesh(std::string name, AssetVertexFormat format, uint32_t vertexStride, std::span<const std::byte> vertices,
+                              std::span<const uint32_t> indices, const float (&decode)[16]) {
+    if (vertexStride == 0 || vertexStride != assetVertexStride(format) || vertices.size() % vertexStride != 0) {
+        throw std::runtime_error("vertices of mesh '" + name + "' don't match its vertex format (AssetPack.cpp)");
+    }
+    MeshAssetHeader header{};
+    header.vertexFormat = format;
+    header.vertexStride = vertexStride;
+    header.vertexCount = vertices.size() / vertexStride;
+    header.indexCount = indices.size();
+    header.indexSize = header.vertexCount <= UINT16_MAX ? sizeof(uint16_t) : sizeof(uint32_t);
+    header.vertexOffset = alignUp(sizeof(MeshAssetHeader));
+    header.indexOffset = alignUp(header.vertexOffset + vertices.size());
+    std::memcpy(header.decode, decode, sizeof(header.decode));
+    
+    std::vector<std::byte> payload(header.indexOffset + indices.size() * header.indexSize);
+    std::memcpy(payload.data(), &header, sizeof(header));
+    std::memcpy(payload.data() + header.vertexOffset, vertices.data(), vertices.size());
+    std::byte* out = payload.data() + header.indexOffset;
+    for (uint32_t index: indices) {
+        if (header.indexSize == sizeof(uint16_t)) {
+            auto shortIndex = static_cast<uint16_t>(index);
+            std::memcpy(out, &shortIndex, sizeof(shortIndex));
+        }
+        else std::memcpy(out, &index, sizeof(index));
+        out += header.indexSize;
+    }
+    add(std::move(name), AssetType::Mesh, payload);
+}
+
+void AssetPackWriter::write(const std::string& path) const {
+    std::vector<const Asset*> sorted;
+    for (const Asset& asset: assets) sorted.push_back(&asset);
+    std::sort(sorted.begin(), sorted.end(), [](const Asset* a, const Asset* b) { return a->name < b->name; });
+    
+    AssetPackHeader header{assetPackMagic, assetPackVersion, static_cast<uint32_t>(sorted.size()), 0, 0, 0};
+    header.namesOffset = sizeof(AssetPackHeader) + sorted.size() * sizeof(AssetPackEntry);
+    std::vector<AssetPackEntry> entries;
+    for (const Asset* asset: sorted) {
+        entries.push_back({0, asset->data.size(), header.namesSize, static_cast<uint32_t>(asset->name.size()), asset->type, 0});
+        header.namesSize += asset->name.size();
+    }
+    uint64_t offset = alignUp(header.namesOffset + header.namesSize);
+    for (AssetPackEntry& entry: entries) {
+        entry.offset = offset;
+        offset = alignUp(offset + entry.size);
+    }
+    header.fileSize = offset;
+    
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) throw std::runtime_error("failed to create '" + path + "' (AssetPack.cpp)");
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(AssetPackEntry));
+    for (const Asset* asset: sorted) file.write(asset->name.data(), asset->name.size());
+    
+    const char padding[assetPackAlignment]{};
+    uint64_t written = header.namesOffset + header.namesSize;
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        file.write(padding, entries[i].offset - written);
+        file.write(reinterpret_cast<const char*>(sorted[i]->data.data()), sorted[i]->data.size());
+        written = entries[i].offset + entries[i].size;
+    }
+    file.write(padding, header.fileSize - written);
+    if (!file) throw std::runtime_error("failed to write '" + path + "' (AssetPack.cpp)");
+}
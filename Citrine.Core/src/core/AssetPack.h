@@ -0,0 +1,135 @@
+#ifndef CITRINE_ASSETPACK_H
+#define CITRINE_ASSETPACK_H
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// one file holding many assets, mapped once instead of an open/read/alloc per file. layout:
+// AssetPackHeader, AssetPackEntry[entryCount] sorted by name, the names, then every payload aligned to
+// assetPackAlignment. payloads are used in place: shader modules are created from the mapping, mesh and texture
+// payloads are copied from it straight into staging memory. written by citrine_pack (tools/Pack.cpp)
+constexpr uint32_t assetPackMagic = 0x4B415043; // "CPAK"
+constexpr uint32_t assetPackVersion = 1;
+constexpr uint64_t assetPackAlignment = 64;
+
+enum class AssetType : uint32_t {
+    Blob = 0,
+    // SPIR-V, 4 byte aligned like vkCreateShaderModule wants it
+    Shader = 1,
+    // MeshAssetHeader, then the vertices and the indices
+    Mesh = 2,
+    // KTX2 file as is, see Ktx2::parse
+    Texture = 3,
+};
+
+struct AssetPackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t namesSize;
+    uint64_t namesOffset;
+    uint64_t fileSize;
+};
+
+struct AssetPackEntry {
+    uint64_t offset;
+    uint64_t size;
+    // into the names, not null terminated
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    AssetType type;
+    uint32_t reserved;
+};
+
+enum class AssetVertexFormat : uint32_t {
+    // Vertex
+    Float = 0,
+    // CompactVertex, decode has to go into the instance transforms
+    Compact = 1,
+};
+
+// bytes per vertex of each format, 0 for formats this version doesn't know. Mesh.h checks the structs against it
+constexpr uint32_t assetVertexStride(AssetVertexFormat format) {
+    switch (format) {
+        case AssetVertexFormat::Float: return 24;
+        case AssetVertexFormat::Compact: return 12;
+    }
+    return 0;
+}
+
+struct MeshAssetHeader {
+    AssetVertexFormat vertexFormat;
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    // 2 or 4
+    uint32_t indexSize;
+    uint32_t reserved;
+    // from the start of the payload, aligned to assetPackAlignment
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    // column major like glm::mat4
+    float decode[16];
+};
+
+// read only mapping of a pack, spans it hands out stay valid until close()
+class AssetPack {
+private:
+    void* mapping = nullptr;
+    size_t mappedSize = 0;
+    const AssetPackHeader* header = nullptr;
+    std::span<const AssetPackEntry> entryTable;
+    const char* names = nullptr;
+public:
+    struct MeshView {
+        const MeshAssetHeader* header;
+        std::span<const std::byte> vertices;
+        std::span<const std::byte> indices;
+    };
+    
+    AssetPack() = default;
+    AssetPack(const AssetPack&) = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+    ~AssetPack() { close(); }
+    
+    // throws when the file is missing, truncated or not a pack of this version
+    void open(const std::string& path);
+    void close();
+    [[nodiscard]] bool isOpen() const { return mapping != nullptr; }
+    
+    [[nodiscard]] std::span<const AssetPackEntry> entries() const { return entryTable; }
+    [[nodiscard]] std::string_view name(const AssetPackEntry& entry) const { return {names + entry.nameOffset, entry.nameLength}; }
+    // nullptr when the pack doesn't have it
+    [[nodiscard]] const AssetPackEntry* find(std::string_view name) const;
+    [[nodiscard]] std::span<const std::byte> data(const AssetPackEntry& entry) const;
+    
+    // these throw when the asset is missing or of another type, mesh also when its header doesn't describe its payload
+    [[nodiscard]] std::span<const char> shader(std::string_view name) const;
+    [[nodiscard]] MeshView mesh(std::string_view name) const;
+    [[nodiscard]] std::span<const std::byte> texture(std::string_view name) const;
+};
+
+// builds a pack in memory, payloads are copied on add
+class AssetPackWriter {
+private:
+    struct Asset {
+        std::string name;
+        AssetType type;
+        std::vector<std::byte> data;
+    };
+    std::vector<Asset> assets;
+public:
+    // names are unique, adding one twice throws
+    void add(std::string name, AssetType type, std::span<const std::byte> data);
+    // MeshAssetHeader, the vertices (vertexStride bytes each) and the indices, 16 bit whenever they fit. throws when
+    // vertexStride isn't the stride of format
+    void addMesh(std::string name, AssetVertexFormat format, uint32_t vertexStride, std::span<const std::byte> vertices,
+                 std::span<const uint32_t> indices, const float (&decode)[16]);
+    void write(const std::string& path) const;
+};
+
+#endif //CITRINE_ASSETPACK_H
@@ -0,0 +1,144 @@
+#include "AssetPack.h"
+#include "Test.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    std::vector<std::byte> bytes(std::initializer_list<int> values) {
+        std::vector<std::byte> result;
+        for (int value: values) result.push_back(static_cast<std::byte>(value));
+        return result;
+    }
+
+    std::vector<char> readFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    void writeFile(const std::string& path, const std::vector<char>& data) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+    }
+
+    template<typename T>
+    void patch(std::vector<char>& data, uint64_t offset, T value) {
+        std::memcpy(data.data() + offset, &value, sizeof(value));
+    }
+
+    // writes data to path, true when open() accepts it
+    bool opens(const std::string& path, const std::vector<char>& data) {
+        writeFile(path, data);
+        AssetPack pack;
+        try {
+            pack.open(path);
+        } catch (const std::exception&) {
+            return false;
+        }
+        return true;
+    }
+}
+
+int main() {
+    std::string path = (std::filesystem::temp_directory_path() / "citrine_asset_pack_test.pack").string();
+    std::string corruptPath = path + ".corrupt";
+
+    // four compact vertices, two triangles
+    std::vector<std::byte> vertices(4 * assetVertexStride(AssetVertexFormat::Compact));
+    for (size_t i = 0; i < vertices.size(); ++i) vertices[i] = static_cast<std::byte>(i);
+    const uint32_t indices[] = {0, 1, 2, 2, 3, 0};
+    const float decode[16] = {2, 0, 0, 0, 0, 2, 0, 0, 0, 0, 2, 0, 1, 2, 3, 1};
+    std::vector<std::byte> shader = bytes({3, 2, 35, 7, 0, 0, 1, 0});
+    std::vector<std::byte> texture = bytes({0xAB, 0x4B, 0x54, 0x58});
+
+    AssetPackWriter writer;
+    writer.add("shaders/b.spv", AssetType::Shader, shader);
+    writer.addMesh("meshes/quad", AssetVertexFormat::Compact, assetVertexStride(AssetVertexFormat::Compact), vertices, indices, decode);
+    writer.add("textures/a.ktx2", AssetType::Texture, texture);
+    CITRINE_CHECK_THROWS(writer.add("shaders/b.spv", AssetType::Blob, shader));
+    CITRINE_CHECK_THROWS(writer.addMesh("meshes/wrong", AssetVertexFormat::Float, 12, vertices, indices, decode));
+    CITRINE_CHECK_THROWS(writer.addMesh("meshes/partial", AssetVertexFormat::Compact, 12, std::span(vertices).first(20), indices, decode));
+    writer.write(path);
+
+    {
+        AssetPack pack;
+        pack.open(path);
+        CITRINE_CHECK(pack.isOpen() && pack.entries().size() == 3);
+        CITRINE_CHECK(std::ranges::is_sorted(pack.entries(), {}, [&pack](const AssetPackEntry& entry) { return pack.name(entry); }));
+        for (const AssetPackEntry& entry: pack.entries()) CITRINE_CHECK(entry.offset % assetPackAlignment == 0);
+
+        std::span<const char> shaderCode = pack.shader("shaders/b.spv");
+        CITRINE_CHECK(shaderCode.size() == shader.size() && std::memcmp(shaderCode.data(), shader.data(), shader.size()) == 0);
+        CITRINE_CHECK(std::ranges::equal(pack.texture("textures/a.ktx2"), texture));
+
+        AssetPack::MeshView mesh = pack.mesh("meshes/quad");
+        CITRINE_CHECK(mesh.header->vertexFormat == AssetVertexFormat::Compact && mesh.header->vertexCount == 4);
+        CITRINE_CHECK(mesh.header->indexCount == 6 && mesh.header->indexSize == sizeof(uint16_t));
+        CITRINE_CHECK(std::ranges::equal(mesh.vertices, vertices));
+        CITRINE_CHECK(std::memcmp(mesh.header->decode, decode, sizeof(decode)) == 0);
+        bool sameIndices = mesh.indices.size() == 6 * sizeof(uint16_t);
+        for (size_t i = 0; sameIndices && i < 6; ++i) {
+            uint16_t index;
+            std::memcpy(&index, mesh.indices.data() + i * sizeof(index), sizeof(index));
+            sameIndices = index == indices[i];
+        }
+        CITRINE_CHECK(sameIndices);
+
+        CITRINE_CHECK(pack.find("missing") == nullptr);
+        CITRINE_CHECK_THROWS(pack.shader("missing"));
+        CITRINE_CHECK_THROWS(pack.mesh("shaders/b.spv"));
+        CITRINE_CHECK_THROWS(pack.texture("meshes/quad"));
+    }
+
+    // files open() has to refuse before it reads anything past the header
+    std::vector<char> file = readFile(path);
+    CITRINE_CHECK(opens(corruptPath, file));
+    std::vector<char> corrupt = file;
+    patch(corrupt, offsetof(AssetPackHeader, magic), 0u);
+    CITRINE_CHECK(!opens(corruptPath, corrupt));
+    CITRINE_CHECK(!opens(corruptPath, std::vector<char>(file.begin(), file.end() - 1)));
+    corrupt = file;
+    patch(corrupt, offsetof(AssetPackHeader, entryCount), UINT32_MAX);
+    CITRINE_CHECK(!opens(corruptPath, corrupt));
+    corrupt = file;
+    patch(corrupt, offsetof(AssetPackHeader, namesOffset), UINT64_MAX);
+    CITRINE_CHECK(!opens(corruptPath, corrupt));
+    // offset + size wraps around to a small number
+    corrupt = file;
+    patch(corrupt, sizeof(AssetPackHeader) + offsetof(AssetPackEntry, size), UINT64_MAX - assetPackAlignment + 1);
+    CITRINE_CHECK(!opens(corruptPath, corrupt));
+
+    // mesh headers mesh() has to refuse
+    uint64_t meshOffset = 0;
+    {
+        AssetPack pack;
+        pack.open(path);
+        meshOffset = pack.find("meshes/quad")->offset;
+    }
+    auto meshThrows = [&](auto field, auto value) {
+        std::vector<char> patched = file;
+        patch(patched, meshOffset + field, value);
+        writeFile(corruptPath, patched);
+        AssetPack pack;
+        pack.open(corruptPath);
+        try {
+            (void)pack.mesh("meshes/quad");
+        } catch (const std::exception&) {
+            return true;
+        }
+        return false;
+    };
+    CITRINE_CHECK(meshThrows(offsetof(MeshAssetHeader, indexSize), 3u));
+    CITRINE_CHECK(meshThrows(offsetof(MeshAssetHeader, indexSize), 0u));
+    CITRINE_CHECK(meshThrows(offsetof(MeshAssetHeader, vertexStride), 24u));
+    CITRINE_CHECK(meshThrows(offsetof(MeshAssetHeader, vertexFormat), 7u));
+    CITRINE_CHECK(meshThrows(offsetof(MeshAssetHeader, vertexCount), 100u));
+    CITRINE_CHECK(meshThrows(offsetof(MeshAssetHeader, vertexOffset), UINT64_MAX - 8));
+    CITRINE_CHECK(meshThrows(offsetof(MeshAssetHeader, indexOffset), UINT64_MAX));
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(corruptPath);
+    return citrineTestResult();
+}
@@ -0,0 +1,44 @@
+#include "FrameArena.h"
+#include <algorithm>
+
+void FrameArena::create(size_t size) {
+    capacity = size;
+    block = std::make_unique<std::byte[]>(capacity);
+    offset = 0;
+    requested = 0;
+}
+
+void FrameArena::destroy() {
+    block.reset();
+    overflowBlocks.clear();
+    capacity = 0;
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    size_t aligned = (offset + alignment - 1) & ~(alignment - 1);
+    requested += size + (aligned - offset);
+    if (aligned + size > capacity) return allocateOverflow(size, alignment);
+    
+    offset = aligned + size;
+    return block.get() + aligned;
+}
+
+void* FrameArena::allocateOverflow(size_t size, size_t alignment) {
+    // new[] of std::byte is only aligned to max_align_t, over allocate to align by hand
+    overflowBlocks.push_back(std::make_unique<std::byte[]>(size + alignment));
+    auto address = reinterpret_cast<uintptr_t>(overflowBlocks.back().get());
+    return reinterpret_cast<void*>((address + alignment - 1) & ~(uintptr_t(alignment - 1)));
+}
+
+bool FrameArena::reset() {
+    if (!overflowBlocks.empty()) {
+        // grow once to what the last frame needed (plus headroom), later frames fit again
+        size_t newCapacity = std::max(capacity * 2, requested + requested / 2);
+        overflowBlocks.clear();
+        create(newCapacity);
+        return true;
+    }
+    offset = 0;
+    requested = 0;
+    return false;
+}
@@ -0,0 +1,67 @@
+#ifndef CITRINE_FRAMEARENA_H
+#define CITRINE_FRAMEARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+#include <new>
+#include <type_traits>
+#include <initializer_list>
+
+// bump allocator for data that only lives for one frame (submit infos, barriers, draw packets, temporary arrays).
+// there is one per frame in flight, reset once the frame finished on the gpu, so the gpu may still read what a
+// frame put here until then. when a frame needs more than the block holds, the extra goes to overflow blocks
+// and the next reset grows the block to fit, so the steady state never touches the heap. single threaded.
+class FrameArena {
+private:
+    std::unique_ptr<std::byte[]> block;
+    size_t capacity = 0;
+    size_t offset = 0;
+    // bytes requested this frame including overflow, the block grows to this on reset
+    size_t requested = 0;
+    std::vector<std::unique_ptr<std::byte[]>> overflowBlocks;
+
+    void* allocateOverflow(size_t size, size_t alignment);
+public:
+    void create(size_t size);
+    void destroy();
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // value initialized, only for types that don't need destruction
+    template<typename T>
+    std::span<T> allocate(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>, "frame arena memory is never destroyed");
+        if (count == 0) return {};
+        T* data = static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        for (size_t i = 0; i < count; ++i) new (data + i) T{};
+        return {data, count};
+    }
+
+    template<typename T>
+    std::span<T> copy(std::span<const T> values) {
+        std::span<T> data = allocate<T>(values.size());
+        for (size_t i = 0; i < values.size(); ++i) data[i] = values[i];
+        return data;
+    }
+
+    template<typename T>
+    std::span<T> copy(std::initializer_list<T> values) {
+        std::span<T> data = allocate<T>(values.size());
+        size_t i = 0;
+        for (const T& value: values) data[i++] = value;
+        return data;
+    }
+
+    // true when the block grew, the one heap allocation the arena makes after create
+    bool reset();
+
+    [[nodiscard]] size_t used() const { return requested; }
+    [[nodiscard]] size_t size() const { return capacity; }
+    // this frame needed more than the block holds and went to the heap, the next reset grows the block
+    [[nodiscard]] bool overflowed() const { return !overflowBlocks.empty(); }
+};
+
+#endif //CITRINE_FRAMEARENA_H
@@ -0,0 +1,22 @@
+#include "FrameLimiter.h"
+#include <thread>
+#include "Profiler.h"
+
+void FrameLimiter::setTargetFps(double fps) {
+    period = fps > 0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / fps)) : Clock::duration{};
+    deadline = Clock::now();
+}
+
+void FrameLimiter::wait() {
+    if (!enabled()) return;
+    CITRINE_PROFILE_SCOPE("frame cap");
+    
+    Clock::time_point now = Clock::now();
+    if (deadline - now > spinThreshold) std::this_thread::sleep_for(deadline - now - spinThreshold);
+    while (Clock::now() < deadline) std::this_thread::yield();
+    
+    // keep the cadence when slightly late, start over when a whole period was missed
+    now = Clock::now();
+    deadline += period;
+    if (deadline < now) deadline = now + period;
+}
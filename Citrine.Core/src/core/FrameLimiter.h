@@ -0,0 +1,27 @@
+#ifndef CITRINE_FRAMELIMITER_H
+#define CITRINE_FRAMELIMITER_H
+
+#include <chrono>
+
+// caps how often wait() returns. sleeping alone overshoots by the os timer granularity (up to a few ms),
+// so it sleeps until spinThreshold before the deadline and spins the rest. a frame that comes in late
+// moves the schedule instead of earning a burst of catch-up frames.
+class FrameLimiter {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::duration period{};
+    Clock::time_point deadline{};
+public:
+    // covers the sleep overshoot of linux and windows with a raised timer resolution
+    Clock::duration spinThreshold = std::chrono::microseconds(1500);
+
+    // 0 turns the cap off
+    void setTargetFps(double fps);
+    [[nodiscard]] bool enabled() const { return period.count() > 0; }
+
+    // blocks until the next frame may start, returns right away when disabled
+    void wait();
+};
+
+#endif //CITRINE_FRAMELIMITER_H
@@ -0,0 +1,244 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+#include <stdexcept>
+#include <functional>
+#include <string>
+
+thread_local uint32_t JobSystem::currentThread = JobSystem::externalThread;
+
+namespace {
+    // victim selection for stealing, xorshift seeded per thread
+    uint32_t nextRandom() {
+        thread_local uint32_t state = static_cast<uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())) | 1u;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+}
+
+bool JobSystem::WorkDeque::push(Job* job) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    if (b - t >= capacity) return false;
+    buffer[b & (capacity - 1)].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+Job* JobSystem::WorkDeque::pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+    
+    if (t > b) {
+        // empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    
+    Job* job = buffer[b & (capacity - 1)].load(std::memory_order_relaxed);
+    if (t == b) {
+        // last job, race against thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+Job* JobSystem::WorkDeque::steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+    
+    Job* job = buffer[t & (capacity - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+    return job;
+}
+
+bool JobSystem::LockedQueue::push(Job* job) {
+    std::lock_guard lock(mutex);
+    if (count == ring.size()) return false;
+    ring[(head + count) % ring.size()] = job;
+    count++;
+    return true;
+}
+
+Job* JobSystem::LockedQueue::pop() {
+    std::lock_guard lock(mutex);
+    if (count == 0) return nullptr;
+    Job* job = ring[head];
+    head = (head + 1) % ring.size();
+    count--;
+    return job;
+}
+
+void JobSystem::create(uint32_t workerCount) {
+    // hardware_concurrency() may report 0, which the subtraction would wrap to a huge worker count
+    if (workerCount == 0) workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    currentThread = 0;
+    
+    uint32_t threads = workerCount + 1;
+    for (uint32_t i = 0; i < threads; ++i) deques.push_back(std::make_unique<WorkDeque>());
+    pools.resize(threads + 1);
+    for (auto& pool: pools) pool.jobs = std::make_unique<Job[]>(jobsPerThread);
+    mainThreadQueue.ring.resize(jobsPerThread);
+    injectionQueue.ring.resize(jobsPerThread);
+    
+    stopWorkers = false;
+    for (uint32_t i = 1; i < threads; ++i) workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+void JobSystem::destroy() {
+    {
+        std::lock_guard lock(sleepMutex);
+        stopWorkers = true;
+    }
+    sleepCondition.notify_all();
+    for (auto& worker: workers) worker.join();
+    workers.clear();
+    deques.clear();
+    pools.clear();
+}
+
+Job* JobSystem::allocate() {
+    bool external = currentThread == externalThread;
+    JobPool& pool = external ? pools.back() : pools[currentThread];
+    
+    std::unique_lock<std::mutex> lock;
+    if (external) lock = std::unique_lock(externalPoolMutex);
+    
+    Job* job = &pool.jobs[pool.next++ & (jobsPerThread - 1)];
+    // the ring wrapped around onto a job that is still queued or running
+    if (job->unfinished.load(std::memory_order_acquire) != 0) throw std::runtime_error("job pool exhausted (JobSystem.cpp)");
+    
+    job->function = nullptr;
+    job->parent = nullptr;
+    job->unfinished.store(1, std::memory_order_relaxed);
+    job->dependencies.store(1, std::memory_order_relaxed);
+    job->continuationCount = 0;
+    job->mainThread = false;
+    return job;
+}
+
+void JobSystem::dependsOn(Job* job, Job* dependency) {
+    if (dependency->continuationCount == Job::maxContinuations) throw std::runtime_error("too many continuations (JobSystem.cpp)");
+    dependency->continuations[dependency->continuationCount++] = job;
+    job->dependencies.fetch_add(1, std::memory_order_relaxed);
+}
+
+void JobSystem::run(Job* job) {
+    if (job->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) enqueue(job);
+}
+
+void JobSystem::enqueue(Job* job) {
+    if (job->mainThread) {
+        if (!mainThreadQueue.push(job)) throw std::runtime_error("main thread queue full (JobSystem.cpp)");
+        return;
+    }
+    
+    // counted before the push, so a thief never sees the job without the counter
+    queuedJobs.fetch_add(1);
+    if (currentThread != externalThread) {
+        if (!deques[currentThread]->push(job)) {
+            // own deque is full, run it right away instead of failing
+            queuedJobs.fetch_sub(1);
+            execute(job);
+            return;
+        }
+    } else if (!injectionQueue.push(job)) {
+        queuedJobs.fetch_sub(1);
+        throw std::runtime_error("injection queue full (JobSystem.cpp)");
+    }
+    wakeWorker();
+}
+
+void JobSystem::wakeWorker() {
+    if (sleepingWorkers.load() == 0) return;
+    // taking the lock orders this with a worker that is between its predicate check and the wait
+    { std::lock_guard lock(sleepMutex); }
+    sleepCondition.notify_one();
+}
+
+void JobSystem::execute(Job* job) {
+    job->function(*job);
+    finish(job);
+}
+
+void JobSystem::finish(Job* job) {
+    // copied before the decrement, the job slot may be reused once it is done
+    Job* parent = job->parent;
+    uint32_t continuationCount = job->continuationCount;
+    Job* continuations[Job::maxContinuations];
+    std::copy_n(job->continuations, continuationCount, continuations);
+    
+    if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    
+    for (uint32_t i = 0; i < continuationCount; ++i) run(continuations[i]);
+    if (parent) finish(parent);
+}
+
+Job* JobSystem::findJob(uint32_t thread) {
+    Job* job = nullptr;
+    if (thread == 0 && (job = mainThreadQueue.pop())) return job;
+    
+    if (thread != externalThread) job = deques[thread]->pop();
+    if (!job) job = injectionQueue.pop();
+    if (!job) {
+        uint32_t count = deques.size();
+        uint32_t start = nextRandom() % count;
+        for (uint32_t i = 0; i < count && !job; ++i) {
+            uint32_t victim = (start + i) % count;
+            if (victim != thread) job = deques[victim]->steal();
+        }
+    }
+    
+    if (job) queuedJobs.fetch_sub(1);
+    return job;
+}
+
+void JobSystem::wait(const Job* job) {
+    while (!isDone(job)) {
+        if (Job* other = findJob(currentThread)) execute(other);
+        else std::this_thread::yield();
+    }
+}
+
+bool JobSystem::helpOnce() {
+    Job* job = findJob(currentThread);
+    if (!job) return false;
+    execute(job);
+    return true;
+}
+
+void JobSystem::pumpMainThread() {
+    while (Job* job = mainThreadQueue.pop()) execute(job);
+}
+
+void JobSystem::workerLoop(uint32_t thread) {
+    currentThread = thread;
+    CITRINE_PROFILE_THREAD(("worker " + std::to_string(thread)).c_str());
+    uint32_t idleRounds = 0;
+    while (!stopWorkers.load(std::memory_order_relaxed)) {
+        if (Job* job = findJob(thread)) {
+            execute(job);
+            idleRounds = 0;
+            continue;
+        }
+        
+        // spin a little before sleeping, jobs usually come in bursts
+        if (++idleRounds < 64) {
+            std::this_thread::yield();
+            continue;
+        }
+        idleRounds = 0;
+        
+        std::unique_lock lock(sleepMutex);
+        sleepingWorkers.fetch_add(1);
+        sleepCondition.wait(lock, [this] { return stopWorkers.load() || queuedJobs.load() > 0; });
+        sleepingWorkers.fetch_sub(1);
+    }
+}
@@ -0,0 +1,155 @@
+#ifndef CITRINE_JOBSYSTEM_H
+#define CITRINE_JOBSYSTEM_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+
+// a job finishes once its own function and all of its children ran. continuations (jobs that depend on it)
+// are released at that point. jobs live in fixed per-thread rings, nothing is allocated after create().
+struct alignas(64) Job {
+    static constexpr uint32_t maxContinuations = 4;
+    static constexpr size_t payloadSize = 64;
+
+    void (*function)(Job& job) = nullptr;
+    Job* parent = nullptr;
+    // own function + unfinished children
+    std::atomic<int32_t> unfinished = 0;
+    // run() + unfinished dependencies, the job is queued when this drops to 0
+    std::atomic<int32_t> dependencies = 0;
+    uint32_t continuationCount = 0;
+    // only executed by JobSystem::pumpMainThread (glfw and other main thread only apis)
+    bool mainThread = false;
+    Job* continuations[maxContinuations]{};
+    alignas(16) unsigned char payload[payloadSize]{};
+};
+
+// work stealing scheduler shared by the whole engine. every worker (and the main thread, index 0) owns a
+// chase-lev deque: the owner pushes and pops at the bottom, idle threads steal from the top.
+// threads that are not part of the system (e.g. a render thread) submit through a locked injection queue.
+class JobSystem {
+private:
+    // chase-lev deque with a fixed capacity, see "correct and efficient work-stealing for weak memory models" (le et al.)
+    class WorkDeque {
+    private:
+        static constexpr int64_t capacity = 4096;
+        alignas(64) std::atomic<int64_t> top = 0;
+        alignas(64) std::atomic<int64_t> bottom = 0;
+        std::atomic<Job*> buffer[capacity]{};
+    public:
+        // owner only, false when full
+        bool push(Job* job);
+        // owner only
+        Job* pop();
+        // any thread
+        Job* steal();
+    };
+
+    // small locked ring for the main thread and injection queues
+    struct LockedQueue {
+        std::mutex mutex;
+        std::vector<Job*> ring;
+        size_t head = 0;
+        size_t count = 0;
+
+        bool push(Job* job);
+        Job* pop();
+    };
+
+    struct JobPool {
+        std::unique_ptr<Job[]> jobs;
+        uint32_t next = 0;
+    };
+
+    static constexpr uint32_t jobsPerThread = 4096;
+    static constexpr uint32_t externalThread = UINT32_MAX;
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkDeque>> deques;
+    // one per thread of the system, plus a locked one at the end for external threads
+    std::vector<JobPool> pools;
+    std::mutex externalPoolMutex;
+    LockedQueue mainThreadQueue;
+    LockedQueue injectionQueue;
+
+    // jobs sitting in deques or the injection queue, sleeping workers wake up when this is non zero
+    std::atomic<int32_t> queuedJobs = 0;
+    std::atomic<int32_t> sleepingWorkers = 0;
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::atomic<bool> stopWorkers = false;
+
+    static thread_local uint32_t currentThread;
+
+    Job* allocate();
+    void enqueue(Job* job);
+    void execute(Job* job);
+    void finish(Job* job);
+    Job* findJob(uint32_t thread);
+    void wakeWorker();
+    void workerLoop(uint32_t thread);
+public:
+    // the calling thread becomes the main thread (index 0)
+    void create(uint32_t workerCount = 0);
+    void destroy();
+
+    // the functor is stored inline in the job, so it has to fit into Job::payloadSize
+    template<typename F>
+    Job* createJob(F&& function, Job* parent = nullptr) {
+        using Functor = std::decay_t<F>;
+        static_assert(sizeof(Functor) <= Job::payloadSize, "job functor too large, capture by reference or pointer");
+        static_assert(alignof(Functor) <= 16, "job functor over aligned");
+
+        Job* job = allocate();
+        new (job->payload) Functor(std::forward<F>(function));
+        job->function = [](Job& self) {
+            Functor* functor = std::launder(reinterpret_cast<Functor*>(self.payload));
+            (*functor)();
+            functor->~Functor();
+        };
+        job->parent = parent;
+        if (parent) parent->unfinished.fetch_add(1, std::memory_order_relaxed);
+        return job;
+    }
+
+    // job waits for dependency to finish. both must not have been run yet
+    void dependsOn(Job* job, Job* dependency);
+    void setMainThread(Job* job) { job->mainThread = true; }
+    void run(Job* job);
+    [[nodiscard]] static bool isDone(const Job* job) { return job->unfinished.load(std::memory_order_acquire) == 0; }
+    // executes other jobs until job finished
+    void wait(const Job* job);
+    // runs one queued job on the calling thread, false when there was nothing to do
+    bool helpOnce();
+    // executes all main thread jobs, call from the main loop
+    void pumpMainThread();
+
+    // calls function(begin, end) on batches of [0, count) spread over all threads and waits for them
+    template<typename F>
+    void parallelFor(uint32_t count, uint32_t batchSize, const F& function) {
+        if (count == 0) return;
+        batchSize = std::max(1u, batchSize);
+        Job* root = createJob([] {});
+        for (uint32_t begin = 0; begin < count; begin += batchSize) {
+            uint32_t end = std::min(count, begin + batchSize);
+            run(createJob([&function, begin, end] { function(begin, end); }, root));
+        }
+        run(root);
+        wait(root);
+    }
+
+    // worker threads + the main thread
+    [[nodiscard]] uint32_t threadCount() const { return workers.size() + 1; }
+    // 0 is the main thread, UINT32_MAX for threads outside the system
+    [[nodiscard]] static uint32_t threadIndex() { return currentThread; }
+};
+
+#endif //CITRINE_JOBSYSTEM_H
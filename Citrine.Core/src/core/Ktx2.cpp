@@ -0,0 +1,80 @@
+#include "Ktx2.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    constexpr unsigned char identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    
+    struct Header {
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+        // index, the data format descriptor and key/value data aren't needed to upload the levels
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+    };
+    static_assert(sizeof(Header) == 52);
+    // followed by the 64 bit offset and length of the supercompression global data, then the level index
+    constexpr size_t levelIndexOffset = sizeof(identifier) + sizeof(Header) + 2 * sizeof(uint64_t);
+    
+    struct LevelIndex {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+    
+    // the file is only byte aligned in memory when it comes from a read instead of a mapping
+    template<typename T>
+    T read(std::span<const std::byte> data, size_t offset) {
+        T value;
+        std::memcpy(&value, data.data() + offset, sizeof(T));
+        return value;
+    }
+}
+
+Ktx2Image Ktx2::parse(std::span<const std::byte> data) {
+    if (data.size() < levelIndexOffset || std::memcmp(data.data(), identifier, sizeof(identifier)) != 0) {
+        throw std::runtime_error("not a KTX2 file (Ktx2.cpp)");
+    }
+    auto header = read<Header>(data, sizeof(identifier));
+    if (header.supercompressionScheme != 0) throw std::runtime_error("supercompressed KTX2 files are not supported (Ktx2.cpp)");
+    if (header.vkFormat == 0) throw std::runtime_error("KTX2 files without a vulkan format (Basis Universal) are not supported (Ktx2.cpp)");
+    if (header.pixelWidth == 0 || (header.faceCount != 1 && header.faceCount != 6)) throw std::runtime_error("malformed KTX2 header (Ktx2.cpp)");
+    // cube compatible images need square 2D faces
+    if (header.faceCount == 6 && (header.pixelWidth != header.pixelHeight || header.pixelDepth != 0)) throw std::runtime_error("KTX2 cube map faces are not square (Ktx2.cpp)");
+    
+    Ktx2Image image;
+    image.vkFormat = header.vkFormat;
+    image.width = header.pixelWidth;
+    image.height = std::max(header.pixelHeight, 1u);
+    image.depth = std::max(header.pixelDepth, 1u);
+    image.layers = header.layerCount;
+    image.faces = header.faceCount;
+    image.generateMips = header.levelCount == 0;
+    
+    uint32_t levelCount = std::max(header.levelCount, 1u);
+    // a chain ends at 1x1x1, more levels than that can't be created
+    if (levelCount > static_cast<uint32_t>(std::bit_width(std::max({image.width, image.height, image.depth})))) {
+        throw std::runtime_error("KTX2 file has more levels than its size allows (Ktx2.cpp)");
+    }
+    if (levelIndexOffset + levelCount * sizeof(LevelIndex) > data.size()) throw std::runtime_error("truncated KTX2 level index (Ktx2.cpp)");
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        auto level = read<LevelIndex>(data, levelIndexOffset + i * sizeof(LevelIndex));
+        if (level.byteLength == 0 || level.byteOffset > data.size() || level.byteLength > data.size() - level.byteOffset) {
+            throw std::runtime_error("KTX2 level " + std::to_string(i) + " is out of the file (Ktx2.cpp)");
+        }
+        image.levels.push_back(data.subspan(level.byteOffset, level.byteLength));
+    }
+    return image;
+}
@@ -0,0 +1,33 @@
+#ifndef CITRINE_KTX2_H
+#define CITRINE_KTX2_H
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// a KTX2 container (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html) holding payloads the gpu samples as
+// they are: BC1-7, ETC2, ASTC or plain formats, mip chain included. supercompressed (zstd, BasisLZ) and
+// VK_FORMAT_UNDEFINED (Basis Universal) files would need decoding on the cpu and are rejected
+struct Ktx2Image {
+    // a VkFormat
+    uint32_t vkFormat = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t depth = 0;
+    // 0 when it isn't an array
+    uint32_t layers = 0;
+    // 6 for cube maps
+    uint32_t faces = 1;
+    // largest first, each holds every layer and face of its level back to back. point into the parsed data
+    std::vector<std::span<const std::byte>> levels;
+    // the file only has the base level and asks for the rest to be generated
+    bool generateMips = false;
+};
+
+namespace Ktx2 {
+    // no copies, the levels stay valid as long as data does (e.g. an asset pack mapping). throws on anything malformed
+    Ktx2Image parse(std::span<const std::byte> data);
+}
+
+#endif //CITRINE_KTX2_H
@@ -0,0 +1,90 @@
+#include "Ktx2.h"
+#include "Test.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr unsigned char identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    constexpr uint32_t formatRgba8 = 37;
+    // identifier, 13 header fields, supercompression global data offset and length
+    constexpr size_t levelIndexOffset = 12 + 13 * 4 + 2 * 8;
+
+    // a file of RGBA8 levels, largest first, each filled with its level number
+    struct File {
+        uint32_t vkFormat = formatRgba8;
+        uint32_t width = 4, height = 4, depth = 0, layers = 0, faces = 1;
+        uint32_t levelCount = 3;
+        uint32_t supercompression = 0;
+
+        [[nodiscard]] std::vector<std::byte> build() const {
+            std::vector<std::byte> data(levelIndexOffset + std::max(levelCount, 1u) * 24);
+            std::memcpy(data.data(), identifier, sizeof(identifier));
+            const uint32_t header[13] = {vkFormat, 1, width, height, depth, layers, faces, levelCount, supercompression, 0, 0, 0, 0};
+            std::memcpy(data.data() + 12, header, sizeof(header));
+
+            for (uint32_t level = 0; level < std::max(levelCount, 1u); ++level) {
+                uint64_t size = static_cast<uint64_t>(std::max(width >> level, 1u)) * std::max(height >> level, 1u) * 4 * faces;
+                const uint64_t index[3] = {data.size(), size, size};
+                std::memcpy(data.data() + levelIndexOffset + level * sizeof(index), index, sizeof(index));
+                data.resize(data.size() + size, static_cast<std::byte>(level));
+            }
+            return data;
+        }
+    };
+
+    template<typename T>
+    void patch(std::vector<std::byte>& data, size_t offset, T value) {
+        std::memcpy(data.data() + offset, &value, sizeof(value));
+    }
+}
+
+int main() {
+    std::vector<std::byte> data = File{}.build();
+    Ktx2Image image = Ktx2::parse(data);
+    CITRINE_CHECK(image.vkFormat == formatRgba8 && image.width == 4 && image.height == 4 && image.depth == 1);
+    CITRINE_CHECK(image.layers == 0 && image.faces == 1 && !image.generateMips);
+    CITRINE_CHECK(image.levels.size() == 3);
+    for (size_t level = 0; level < image.levels.size(); ++level) {
+        size_t expected = (4 >> level) * (4 >> level) * 4;
+        CITRINE_CHECK(image.levels[level].size() == expected);
+        // views into data, no copies
+        CITRINE_CHECK(image.levels[level].data() >= data.data() && image.levels[level].data() + expected <= data.data() + data.size());
+        CITRINE_CHECK(image.levels[level][0] == static_cast<std::byte>(level));
+    }
+
+    // a 1D texture, a cube map and a file that asks for its mips to be generated
+    CITRINE_CHECK(Ktx2::parse(File{.height = 0, .levelCount = 3}.build()).height == 1);
+    CITRINE_CHECK(Ktx2::parse(File{.faces = 6}.build()).faces == 6);
+    Ktx2Image generated = Ktx2::parse(File{.levelCount = 0}.build());
+    CITRINE_CHECK(generated.generateMips && generated.levels.size() == 1);
+    // non square: the chain follows the larger side
+    CITRINE_CHECK(Ktx2::parse(File{.width = 8, .height = 2, .levelCount = 4}.build()).levels.size() == 4);
+
+    // 4x4 has 3 levels (4, 2, 1), a fourth can't exist
+    CITRINE_CHECK_THROWS(Ktx2::parse(File{.levelCount = 4}.build()));
+    CITRINE_CHECK_THROWS(Ktx2::parse(File{.width = 8, .height = 2, .levelCount = 5}.build()));
+    CITRINE_CHECK_THROWS(Ktx2::parse(File{.width = 0}.build()));
+    CITRINE_CHECK_THROWS(Ktx2::parse(File{.faces = 2}.build()));
+    CITRINE_CHECK_THROWS(Ktx2::parse(File{.width = 8, .faces = 6}.build()));
+    CITRINE_CHECK_THROWS(Ktx2::parse(File{.depth = 4, .faces = 6}.build()));
+    CITRINE_CHECK_THROWS(Ktx2::parse(File{.vkFormat = 0}.build()));
+    CITRINE_CHECK_THROWS(Ktx2::parse(File{.supercompression = 2}.build()));
+
+    std::vector<std::byte> corrupt = data;
+    corrupt[1] = std::byte{'Q'};
+    CITRINE_CHECK_THROWS(Ktx2::parse(corrupt));
+    CITRINE_CHECK_THROWS(Ktx2::parse(std::span(data).first(levelIndexOffset - 1)));
+    // level index cut off
+    CITRINE_CHECK_THROWS(Ktx2::parse(std::span(data).first(levelIndexOffset + 2 * 24)));
+    // level data cut off
+    CITRINE_CHECK_THROWS(Ktx2::parse(std::span(data).first(data.size() - 1)));
+    // offset + length wraps around to inside the file
+    corrupt = data;
+    patch(corrupt, levelIndexOffset + 8, UINT64_MAX - 16);
+    CITRINE_CHECK_THROWS(Ktx2::parse(corrupt));
+    corrupt = data;
+    patch(corrupt, levelIndexOffset + 8, uint64_t{0});
+    CITRINE_CHECK_THROWS(Ktx2::parse(corrupt));
+
+    return citrineTestResult();
+}
@@ -0,0 +1,144 @@
+#include "Profiler.h"
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+
+std::mutex Profiler::registryMutex;
+std::vector<std::unique_ptr<Profiler::ThreadBuffer>> Profiler::registry;
+
+namespace {
+    const auto epoch = std::chrono::steady_clock::now();
+    
+    std::atomic<uint64_t> currentFrame = 0;
+    std::atomic<uint64_t> submitTimes[64]{};
+    std::atomic<uint64_t> submitFrames[64]{};
+    
+    struct Event {
+        const char* name;
+        uint64_t begin;
+        uint64_t end;
+        uint64_t frame;
+    };
+    
+    void writeEscaped(std::ofstream& file, const std::string& text) {
+        for (char c: text) {
+            if (c == '"' || c == '\\') file << '\\';
+            file << c;
+        }
+    }
+}
+
+void Profiler::ThreadBuffer::record(const char* eventName, uint64_t begin, uint64_t end, uint64_t frame) {
+    uint64_t index = written.load(std::memory_order_relaxed);
+    Slot& slot = slots[index & (capacity - 1)];
+    slot.name.store(eventName, std::memory_order_relaxed);
+    slot.begin.store(begin, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+    slot.frame.store(frame, std::memory_order_relaxed);
+    written.store(index + 1, std::memory_order_release);
+}
+
+Profiler::ThreadBuffer& Profiler::threadBuffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer) return *buffer;
+    
+    std::lock_guard lock(registryMutex);
+    registry.push_back(std::make_unique<ThreadBuffer>());
+    buffer = registry.back().get();
+    buffer->id = registry.size();
+    buffer->name = "thread " + std::to_string(buffer->id);
+    return *buffer;
+}
+
+Profiler::ThreadBuffer& Profiler::gpuBuffer() {
+    static ThreadBuffer* buffer = [] {
+        std::lock_guard lock(registryMutex);
+        registry.push_back(std::make_unique<ThreadBuffer>());
+        registry.back()->id = 0;
+        registry.back()->name = "gpu";
+        return registry.back().get();
+    }();
+    return *buffer;
+}
+
+uint64_t Profiler::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void Profiler::setThreadName(const char* name) {
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard lock(registryMutex);
+    buffer.name = name;
+}
+
+void Profiler::setFrame(uint64_t frame) {
+    currentFrame.store(frame, std::memory_order_relaxed);
+}
+
+uint64_t Profiler::frame() {
+    return currentFrame.load(std::memory_order_relaxed);
+}
+
+void Profiler::record(const char* name, uint64_t begin, uint64_t end) {
+    threadBuffer().record(name, begin, end, frame());
+}
+
+void Profiler::markSubmit(uint64_t frame) {
+    submitTimes[frame % submitHistory].store(now(), std::memory_order_relaxed);
+    submitFrames[frame % submitHistory].store(frame, std::memory_order_release);
+}
+
+void Profiler::recordGpu(const char* name, uint64_t frame, uint64_t beginOffset, uint64_t endOffset) {
+    // the submit time got overwritten by a newer frame (results came back very late), nothing to anchor to
+    if (submitFrames[frame % submitHistory].load(std::memory_order_acquire) != frame) return;
+    uint64_t submitTime = submitTimes[frame % submitHistory].load(std::memory_order_relaxed);
+    gpuBuffer().record(name, submitTime + beginOffset, submitTime + endOffset, frame);
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) {
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open()) return false;
+    
+    file << std::fixed << std::setprecision(3);
+    file << "{\"traceEvents\":[\n";
+    bool first = true;
+    
+    std::lock_guard lock(registryMutex);
+    std::vector<Event> events;
+    for (const auto& buffer: registry) {
+        file << (first ? "" : ",\n") << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->id << R"(,"args":{"name":")";
+        writeEscaped(file, buffer->name);
+        file << "\"}}";
+        first = false;
+        
+        // copy the ring, then drop whatever the owner overwrote while we were copying
+        uint64_t written = buffer->written.load(std::memory_order_acquire);
+        uint64_t start = written > ThreadBuffer::capacity ? written - ThreadBuffer::capacity : 0;
+        events.clear();
+        for (uint64_t i = start; i < written; ++i) {
+            const ThreadBuffer::Slot& slot = buffer->slots[i & (ThreadBuffer::capacity - 1)];
+            events.push_back({slot.name.load(std::memory_order_relaxed), slot.begin.load(std::memory_order_relaxed),
+                              slot.end.load(std::memory_order_relaxed), slot.frame.load(std::memory_order_relaxed)});
+        }
+        uint64_t writtenAfter = buffer->written.load(std::memory_order_acquire);
+        // the owner may be filling slot writtenAfter right now, which is where event writtenAfter - capacity was
+        uint64_t valid = writtenAfter + 1 > ThreadBuffer::capacity ? writtenAfter + 1 - ThreadBuffer::capacity : 0;
+        size_t skip = valid > start ? std::min<size_t>(valid - start, events.size()) : 0;
+        
+        for (size_t i = skip; i < events.size(); ++i) {
+            const Event& event = events[i];
+            // chrome trace timestamps are microseconds
+            file << ",\n" << R"({"name":")";
+            writeEscaped(file, event.name);
+            file << R"(","ph":"X","pid":1,"tid":)" << buffer->id
+                 << R"(,"ts":)" << static_cast<double>(event.begin) / 1000.0
+                 << R"(,"dur":)" << static_cast<double>(event.end - event.begin) / 1000.0
+                 << R"(,"args":{"frame":)" << event.frame << "}}";
+        }
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
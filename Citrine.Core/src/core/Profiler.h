@@ -0,0 +1,92 @@
+#ifndef CITRINE_PROFILER_H
+#define CITRINE_PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// scoped cpu instrumentation. every thread records into its own fixed ring (single writer, lock free),
+// writeChromeTrace dumps all rings as chrome trace json (chrome://tracing, ui.perfetto.dev).
+// gpu scopes from GpuProfiler go to a separate "gpu" track, placed relative to the cpu time their frame was submitted.
+// the macros compile to nothing unless CITRINE_PROFILING is defined (cmake: CITRINE_PROFILING, off in release).
+class Profiler {
+private:
+    struct ThreadBuffer {
+        static constexpr uint32_t capacity = 1 << 14;
+
+        // atomics so the dumping thread can read while the owner keeps writing, relaxed stores are plain stores
+        struct Slot {
+            std::atomic<const char*> name;
+            std::atomic<uint64_t> begin;
+            std::atomic<uint64_t> end;
+            std::atomic<uint64_t> frame;
+        };
+
+        std::unique_ptr<Slot[]> slots = std::make_unique<Slot[]>(capacity);
+        // total events ever written, the ring holds the last capacity of them
+        std::atomic<uint64_t> written = 0;
+        uint32_t id = 0;
+        std::string name;
+
+        void record(const char* eventName, uint64_t begin, uint64_t end, uint64_t frame);
+    };
+
+    static constexpr uint32_t submitHistory = 64;
+
+    // thread buffers are never freed, a thread that exited still shows up in the next dump
+    static std::mutex registryMutex;
+    static std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+    static ThreadBuffer& threadBuffer();
+    static ThreadBuffer& gpuBuffer();
+public:
+    // nanoseconds since the profiler epoch (first use)
+    static uint64_t now();
+
+    static void setThreadName(const char* name);
+    // frame index stored with every event from here on
+    static void setFrame(uint64_t frame);
+    [[nodiscard]] static uint64_t frame();
+    static void record(const char* name, uint64_t begin, uint64_t end);
+
+    // remembers the cpu time of the frame's queue submission, gpu scopes of the frame are placed relative to it
+    static void markSubmit(uint64_t frame);
+    // gpu scope with begin/end in nanoseconds relative to the start of the frame's command buffer.
+    // frame thread only (the gpu track has a single writer like every other ring)
+    static void recordGpu(const char* name, uint64_t frame, uint64_t beginOffset, uint64_t endOffset);
+
+    // false when the file couldn't be written
+    static bool writeChromeTrace(const std::string& path);
+};
+
+struct ProfileScope {
+    const char* name;
+    uint64_t begin;
+
+    explicit ProfileScope(const char* scopeName) : name(scopeName), begin(Profiler::now()) {}
+    ~ProfileScope() { Profiler::record(name, begin, Profiler::now()); }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+#define CITRINE_PROFILE_CONCAT_INNER(a, b) a##b
+#define CITRINE_PROFILE_CONCAT(a, b) CITRINE_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef CITRINE_PROFILING
+#define CITRINE_PROFILE_SCOPE(name) ProfileScope CITRINE_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define CITRINE_PROFILE_THREAD(name) Profiler::setThreadName(name)
+#define CITRINE_PROFILE_FRAME(frame) Profiler::setFrame(frame)
+#define CITRINE_PROFILE_SUBMIT(frame) Profiler::markSubmit(frame)
+#define CITRINE_PROFILE_GPU(name, frame, begin, end) Profiler::recordGpu(name, frame, begin, end)
+#else
+#define CITRINE_PROFILE_SCOPE(name) ((void)0)
+#define CITRINE_PROFILE_THREAD(name) ((void)0)
+#define CITRINE_PROFILE_FRAME(frame) ((void)0)
+#define CITRINE_PROFILE_SUBMIT(frame) ((void)0)
+#define CITRINE_PROFILE_GPU(name, frame, begin, end) ((void)0)
+#endif
+
+#endif //CITRINE_PROFILER_H
@@ -0,0 +1,70 @@
+#include "ResidencyLru.h"
+
+uint32_t ResidencyLru::add(uint64_t bytes) {
+    items.push_back({bytes});
+    return items.size() - 1;
+}
+
+void ResidencyLru::beginLoad(uint32_t item) {
+    Item& entry = items[item];
+    if (entry.loading || entry.resident) return;
+    entry.loading = true;
+    loadingBytes += entry.bytes;
+    loadingCount++;
+}
+
+void ResidencyLru::endLoad(uint32_t item, bool loaded, uint64_t frame) {
+    Item& entry = items[item];
+    if (!entry.loading) return;
+    entry.loading = false;
+    loadingBytes -= entry.bytes;
+    loadingCount--;
+    if (!loaded) return;
+
+    // an older frame would make it the first victim of the next load, before anything drew it
+    entry.resident = true;
+    entry.lastUsedFrame = frame;
+    residentBytes += entry.bytes;
+    residentCount++;
+    pushFront(item);
+}
+
+void ResidencyLru::use(uint32_t item, uint64_t frame) {
+    if (!items[item].resident) return;
+    items[item].lastUsedFrame = frame;
+    unlink(item);
+    pushFront(item);
+}
+
+uint32_t ResidencyLru::evictionCandidate(uint64_t frame) const {
+    if (tail == none || items[tail].lastUsedFrame >= frame) return none;
+    return tail;
+}
+
+void ResidencyLru::evict(uint32_t item) {
+    Item& entry = items[item];
+    if (!entry.resident) return;
+    unlink(item);
+    entry.resident = false;
+    residentBytes -= entry.bytes;
+    residentCount--;
+}
+
+void ResidencyLru::unlink(uint32_t item) {
+    Item& entry = items[item];
+    if (entry.prev != none) items[entry.prev].next = entry.next;
+    else if (head == item) head = entry.next;
+    if (entry.next != none) items[entry.next].prev = entry.prev;
+    else if (tail == item) tail = entry.prev;
+    entry.prev = none;
+    entry.next = none;
+}
+
+void ResidencyLru::pushFront(uint32_t item) {
+    Item& entry = items[item];
+    entry.prev = none;
+    entry.next = head;
+    if (head != none) items[head].prev = item;
+    head = item;
+    if (tail == none) tail = item;
+}
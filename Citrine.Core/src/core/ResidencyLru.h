@@ -0,0 +1,61 @@
+#ifndef CITRINE_RESIDENCYLRU_H
+#define CITRINE_RESIDENCYLRU_H
+
+#include <cstdint>
+#include <vector>
+
+// which items are resident (or loading) under a byte budget and which of them goes first when something new has to
+// fit: the least recently used one, never one used in the current frame. only bookkeeping, the caller loads and frees
+// the actual data (AssetStreamer with meshes). frame is the caller's frame counter. single threaded.
+class ResidencyLru {
+public:
+    static constexpr uint32_t none = UINT32_MAX;
+
+private:
+    struct Item {
+        uint64_t bytes = 0;
+        uint64_t lastUsedFrame = 0;
+        bool loading = false;
+        bool resident = false;
+        // least recently used list of resident items, head is the most recent
+        uint32_t prev = none;
+        uint32_t next = none;
+    };
+
+    std::vector<Item> items;
+    uint32_t head = none;
+    uint32_t tail = none;
+    uint64_t budgetBytes = 0;
+    uint64_t residentBytes = 0;
+    uint64_t loadingBytes = 0;
+    uint32_t residentCount = 0;
+    uint32_t loadingCount = 0;
+
+    void unlink(uint32_t item);
+    void pushFront(uint32_t item);
+public:
+    // not resident, returns its index (they count up from 0)
+    uint32_t add(uint64_t bytes);
+    void setBudget(uint64_t bytes) { budgetBytes = bytes; }
+
+    // counts against the budget from now on
+    void beginLoad(uint32_t item);
+    // loaded: resident and used in frame, so nothing evicts it before it could be drawn once. otherwise it is dropped
+    void endLoad(uint32_t item, bool loaded, uint64_t frame);
+    // moves a resident item to the front
+    void use(uint32_t item, uint64_t frame);
+    // resident and loading items plus bytes stay within the budget
+    [[nodiscard]] bool fits(uint64_t bytes) const { return residentBytes + loadingBytes + bytes <= budgetBytes; }
+    // the least recently used resident item, none when nothing is resident or it was used in frame
+    [[nodiscard]] uint32_t evictionCandidate(uint64_t frame) const;
+    void evict(uint32_t item);
+
+    [[nodiscard]] bool isResident(uint32_t item) const { return items[item].resident; }
+    [[nodiscard]] uint64_t budget() const { return budgetBytes; }
+    [[nodiscard]] uint64_t resident() const { return residentBytes; }
+    [[nodiscard]] uint64_t loading() const { return loadingBytes; }
+    [[nodiscard]] uint32_t residentItems() const { return residentCount; }
+    [[nodiscard]] uint32_t loadingItems() const { return loadingCount; }
+};
+
+#endif //CITRINE_RESIDENCYLRU_H
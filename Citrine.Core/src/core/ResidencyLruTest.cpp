@@ -0,0 +1,71 @@
+#include "ResidencyLru.h"
+#include "Test.h"
+
+namespace {
+    // what AssetStreamer::makeRoom does: evict until bytes fit, false when the rest is in use this frame
+    bool makeRoom(ResidencyLru& lru, uint64_t bytes, uint64_t frame, std::vector<uint32_t>& evicted) {
+        while (!lru.fits(bytes)) {
+            uint32_t victim = lru.evictionCandidate(frame);
+            if (victim == ResidencyLru::none) return false;
+            lru.evict(victim);
+            evicted.push_back(victim);
+        }
+        return true;
+    }
+
+    void load(ResidencyLru& lru, uint32_t item, uint64_t frame) {
+        lru.beginLoad(item);
+        lru.endLoad(item, true, frame);
+    }
+}
+
+int main() {
+    ResidencyLru lru;
+    lru.setBudget(300);
+    uint32_t a = lru.add(100), b = lru.add(100), c = lru.add(100), d = lru.add(100);
+    CITRINE_CHECK(a == 0 && d == 3);
+
+    // loading bytes count against the budget, failed loads give them back and never become resident
+    lru.beginLoad(a);
+    CITRINE_CHECK(lru.loading() == 100 && lru.loadingItems() == 1 && !lru.fits(201));
+    lru.endLoad(a, false, 0);
+    CITRINE_CHECK(lru.loading() == 0 && !lru.isResident(a) && lru.evictionCandidate(1) == ResidencyLru::none);
+
+    load(lru, a, 0);
+    load(lru, b, 0);
+    load(lru, c, 1);
+    CITRINE_CHECK(lru.resident() == 300 && lru.residentItems() == 3 && lru.fits(0) && !lru.fits(1));
+
+    // a was used again, b is the least recently used now
+    lru.use(a, 1);
+    std::vector<uint32_t> evicted;
+    CITRINE_CHECK(makeRoom(lru, 100, 2, evicted));
+    CITRINE_CHECK(evicted == std::vector<uint32_t>{b} && !lru.isResident(b) && lru.resident() == 200);
+
+    // everything left was used in frame 3, nothing may go
+    lru.use(a, 3);
+    lru.use(c, 3);
+    evicted.clear();
+    CITRINE_CHECK(!makeRoom(lru, 200, 3, evicted) && evicted.empty());
+    CITRINE_CHECK(lru.resident() == 200);
+
+    // a mesh that just became resident isn't the next victim: two meshes taking turns in a budget of one used to
+    // evict each other right after loading, before either was drawn
+    ResidencyLru pair;
+    pair.setBudget(100);
+    uint32_t first = pair.add(100), second = pair.add(100);
+    load(pair, first, 5);
+    evicted.clear();
+    CITRINE_CHECK(!makeRoom(pair, 100, 5, evicted) && evicted.empty() && pair.isResident(first));
+    // not drawn in frame 6, now the other one may take its place
+    CITRINE_CHECK(makeRoom(pair, 100, 6, evicted) && evicted == std::vector<uint32_t>{first});
+    load(pair, second, 6);
+    CITRINE_CHECK(pair.isResident(second) && pair.evictionCandidate(6) == ResidencyLru::none && pair.evictionCandidate(7) == second);
+
+    // use and evict on items that aren't resident change nothing
+    pair.use(first, 7);
+    pair.evict(first);
+    CITRINE_CHECK(pair.resident() == 100 && pair.residentItems() == 1 && pair.evictionCandidate(7) == second);
+
+    return citrineTestResult();
+}
@@ -0,0 +1,60 @@
+#ifndef CITRINE_SPSCQUEUE_H
+#define CITRINE_SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// bounded lock free queue for exactly one producer and one consumer thread. values are copied into a fixed
+// ring, so nothing is allocated after construction. the consumer can block in waitForData (futex based).
+template<typename T, size_t Capacity>
+class SpscQueue {
+private:
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    // indices only ever grow, the slot is index & (Capacity - 1)
+    alignas(64) std::atomic<uint64_t> writeIndex = 0;
+    alignas(64) std::atomic<uint64_t> readIndex = 0;
+    // producer/consumer local copies of the other side's index, saves a shared cache line read per call
+    alignas(64) uint64_t cachedReadIndex = 0;
+    alignas(64) uint64_t cachedWriteIndex = 0;
+    T slots[Capacity]{};
+public:
+    // producer only, false when full
+    bool tryPush(const T& value) {
+        uint64_t write = writeIndex.load(std::memory_order_relaxed);
+        if (write - cachedReadIndex == Capacity) {
+            cachedReadIndex = readIndex.load(std::memory_order_acquire);
+            if (write - cachedReadIndex == Capacity) return false;
+        }
+        slots[write & (Capacity - 1)] = value;
+        writeIndex.store(write + 1, std::memory_order_release);
+        writeIndex.notify_one();
+        return true;
+    }
+
+    // consumer only, false when empty
+    bool tryPop(T& value) {
+        uint64_t read = readIndex.load(std::memory_order_relaxed);
+        if (read == cachedWriteIndex) {
+            cachedWriteIndex = writeIndex.load(std::memory_order_acquire);
+            if (read == cachedWriteIndex) return false;
+        }
+        value = slots[read & (Capacity - 1)];
+        readIndex.store(read + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer only, blocks until tryPop would succeed
+    void waitForData() const {
+        uint64_t read = readIndex.load(std::memory_order_relaxed);
+        writeIndex.wait(read, std::memory_order_acquire);
+    }
+
+    // approximate when called from neither side
+    [[nodiscard]] size_t size() const {
+        return writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire);
+    }
+};
+
+#endif //CITRINE_SPSCQUEUE_H
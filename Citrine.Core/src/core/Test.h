@@ -0,0 +1,35 @@
+#ifndef CITRINE_TEST_H
+#define CITRINE_TEST_H
+
+#include <iostream>
+#include <exception>
+
+// checks for the cpu unit tests (*Test.cpp, see citrine_test in CMakeLists.txt). a failed check prints where and the
+// test keeps going, main returns citrineTestResult()
+inline int citrineTestFailures = 0;
+
+#define CITRINE_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n"; \
+            citrineTestFailures++; \
+        } \
+    } while (false)
+
+// expression has to throw (validation of malformed input)
+#define CITRINE_CHECK_THROWS(expression) \
+    do { \
+        bool citrineThrown = false; \
+        try { (void)(expression); } catch (const std::exception&) { citrineThrown = true; } \
+        if (!citrineThrown) { \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": expected a throw: " #expression "\n"; \
+            citrineTestFailures++; \
+        } \
+    } while (false)
+
+inline int citrineTestResult() {
+    if (citrineTestFailures != 0) std::cerr << citrineTestFailures << " checks failed\n";
+    return citrineTestFailures == 0 ? 0 : 1;
+}
+
+#endif //CITRINE_TEST_H
@@ -0,0 +1,38 @@
+#ifndef CITRINE_FRUSTUM_H
+#define CITRINE_FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+// six planes (xyz normal pointing inside, w distance) of a view projection, vulkan clip space (depth 0..1)
+struct Frustum {
+    glm::vec4 planes[6];
+
+    // Gribb/Hartmann: each plane is a sum or difference of two rows of the matrix
+    static Frustum fromViewProjection(const glm::mat4& m) {
+        auto row = [&m](int r) { return glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]); };
+        glm::vec4 x = row(0), y = row(1), z = row(2), w = row(3);
+        
+        Frustum frustum{};
+        frustum.planes[0] = {w.x + x.x, w.y + x.y, w.z + x.z, w.w + x.w};
+        frustum.planes[1] = {w.x - x.x, w.y - x.y, w.z - x.z, w.w - x.w};
+        frustum.planes[2] = {w.x + y.x, w.y + y.y, w.z + y.z, w.w + y.w};
+        frustum.planes[3] = {w.x - y.x, w.y - y.y, w.z - y.z, w.w - y.w};
+        frustum.planes[4] = z;
+        frustum.planes[5] = {w.x - z.x, w.y - z.y, w.z - z.z, w.w - z.w};
+        // unit normals, so plane distances compare against sphere radii
+        for (glm::vec4& plane: frustum.planes) {
+            float length = glm::length(glm::vec3(plane.x, plane.y, plane.z));
+            plane = {plane.x / length, plane.y / length, plane.z / length, plane.w / length};
+        }
+        return frustum;
+    }
+
+    [[nodiscard]] bool intersectsSphere(glm::vec3 center, float radius) const {
+        for (const glm::vec4& plane: planes) {
+            if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius) return false;
+        }
+        return true;
+    }
+};
+
+#endif //CITRINE_FRUSTUM_H
@@ -0,0 +1,187 @@
+#include "FrustumCuller.h"
+#include <algorithm>
+#include <cstring>
+#include "../core/Profiler.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CITRINE_CULL_X86
+#endif
+
+void BoundsStore::reserve(uint32_t objects) {
+    if (objects <= capacity) return;
+    uint32_t newCapacity = (objects + padding - 1) / padding * padding;
+    
+    Array* arrays[] = {&centerX, &centerY, &centerZ, &radii};
+    for (Array* array: arrays) {
+        Array grown(static_cast<float*>(::operator new[](newCapacity * sizeof(float), std::align_val_t(alignment))));
+        // the padding is read by the kernels (masked off), keep it initialized
+        std::fill(grown.get(), grown.get() + newCapacity, 0.f);
+        if (count > 0) std::memcpy(grown.get(), array->get(), count * sizeof(float));
+        *array = std::move(grown);
+    }
+    capacity = newCapacity;
+}
+
+uint32_t BoundsStore::add(glm::vec3 center, float radius) {
+    if (count == capacity) reserve(std::max(capacity * 2, padding * 128));
+    set(count, center, radius);
+    return count++;
+}
+
+namespace {
+    using KernelFunction = uint32_t (*)(const BoundsStore& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* out);
+
+    uint32_t cullScalar(const BoundsStore& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* out) {
+        uint32_t visible = 0;
+        for (uint32_t i = begin; i < end; ++i) {
+            if (frustum.intersectsSphere({bounds.x()[i], bounds.y()[i], bounds.z()[i]}, bounds.radius()[i])) out[visible++] = i;
+        }
+        return visible;
+    }
+
+#ifdef CITRINE_CULL_X86
+    // lanes past end are still loaded (padding), the mask drops them
+    uint32_t emitVisible(uint32_t mask, uint32_t first, uint32_t end, uint32_t* out) {
+        if (end - first < 32) mask &= (1u << (end - first)) - 1;
+        uint32_t visible = 0;
+        while (mask != 0) {
+            out[visible++] = first + __builtin_ctz(mask);
+            mask &= mask - 1;
+        }
+        return visible;
+    }
+
+    __attribute__((target("sse2")))
+    uint32_t cullSse(const BoundsStore& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* out) {
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (int p = 0; p < 6; ++p) {
+            planeX[p] = _mm_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm_set1_ps(frustum.planes[p].w);
+        }
+        
+        uint32_t visible = 0;
+        for (uint32_t i = begin; i < end; i += 4) {
+            __m128 x = _mm_load_ps(bounds.x() + i);
+            __m128 y = _mm_load_ps(bounds.y() + i);
+            __m128 z = _mm_load_ps(bounds.z() + i);
+            __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_load_ps(bounds.radius() + i));
+            
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)), _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+            }
+            visible += emitVisible(_mm_movemask_ps(inside), i, end, out + visible);
+        }
+        return visible;
+    }
+
+    __attribute__((target("avx2,fma")))
+    uint32_t cullAvx2(const BoundsStore& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* out) {
+        __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (int p = 0; p < 6; ++p) {
+            planeX[p] = _mm256_set1_ps(frustum.planes[p].x);
+            planeY[p] = _mm256_set1_ps(frustum.planes[p].y);
+            planeZ[p] = _mm256_set1_ps(frustum.planes[p].z);
+            planeW[p] = _mm256_set1_ps(frustum.planes[p].w);
+        }
+        
+        uint32_t visible = 0;
+        for (uint32_t i = begin; i < end; i += 8) {
+            __m256 x = _mm256_load_ps(bounds.x() + i);
+            __m256 y = _mm256_load_ps(bounds.y() + i);
+            __m256 z = _mm256_load_ps(bounds.z() + i);
+            __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_load_ps(bounds.radius() + i));
+            
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                __m256 distance = _mm256_fmadd_ps(planeX[p], x, _mm256_fmadd_ps(planeY[p], y, _mm256_fmadd_ps(planeZ[p], z, planeW[p])));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+            }
+            visible += emitVisible(_mm256_movemask_ps(inside), i, end, out + visible);
+        }
+        return visible;
+    }
+#endif
+
+    KernelFunction kernelFunction(FrustumCuller::Kernel kernel) {
+        switch (kernel) {
+#ifdef CITRINE_CULL_X86
+            case FrustumCuller::Kernel::Avx2: return cullAvx2;
+            case FrustumCuller::Kernel::Sse: return cullSse;
+#endif
+            default: return cullScalar;
+        }
+    }
+}
+
+FrustumCuller::FrustumCuller(JobSystem* jobSystem, uint32_t jobSize) : jobs(jobSystem), kernel(detectKernel()) {
+    // jobs start on a multiple of 8, so every simd load is aligned
+    objectsPerJob = std::max(BoundsStore::padding, jobSize / BoundsStore::padding * BoundsStore::padding);
+}
+
+FrustumCuller::Kernel FrustumCuller::detectKernel() {
+    if (isSupported(Kernel::Avx2)) return Kernel::Avx2;
+    if (isSupported(Kernel::Sse)) return Kernel::Sse;
+    return Kernel::Scalar;
+}
+
+bool FrustumCuller::isSupported(Kernel kernel) {
+#ifdef CITRINE_CULL_X86
+    __builtin_cpu_init();
+    switch (kernel) {
+        case Kernel::Avx2: return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case Kernel::Sse: return __builtin_cpu_supports("sse2");
+        case Kernel::Scalar: return true;
+    }
+    return false;
+#else
+    return kernel == Kernel::Scalar;
+#endif
+}
+
+bool FrustumCuller::setKernel(Kernel forced) {
+    if (!isSupported(forced)) return false;
+    kernel = forced;
+    return true;
+}
+
+const char* FrustumCuller::kernelName(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar: return "scalar";
+        case Kernel::Sse: return "sse";
+        case Kernel::Avx2: return "avx2";
+    }
+    return "?";
+}
+
+std::span<const uint32_t> FrustumCuller::cull(const BoundsStore& bounds, const Frustum& frustum) {
+    CITRINE_PROFILE_SCOPE("frustum culling");
+    uint32_t count = bounds.size();
+    // every job writes at its own offset, worst case all visible
+    if (count > indexCapacity) {
+        indices = std::make_unique_for_overwrite<uint32_t[]>(count);
+        indexCapacity = count;
+    }
+    uint32_t* out = indices.get();
+    KernelFunction function = kernelFunction(kernel);
+    
+    if (jobs == nullptr || count <= objectsPerJob) return {out, function(bounds, frustum, 0, count, out)};
+    
+    uint32_t jobCount = (count + objectsPerJob - 1) / objectsPerJob;
+    jobCounts.resize(jobCount);
+    jobs->parallelFor(count, objectsPerJob, [&](uint32_t begin, uint32_t end) {
+        jobCounts[begin / objectsPerJob] = function(bounds, frustum, begin, end, out + begin);
+    });
+    
+    // close the gaps between the jobs' ranges, in order so the list stays sorted
+    uint32_t visibleCount = jobCounts[0];
+    for (uint32_t job = 1; job < jobCount; ++job) {
+        std::memmove(out + visibleCount, out + job * objectsPerJob, jobCounts[job] * sizeof(uint32_t));
+        visibleCount += jobCounts[job];
+    }
+    return {out, visibleCount};
+}
@@ -0,0 +1,83 @@
+#ifndef CITRINE_FRUSTUMCULLER_H
+#define CITRINE_FRUSTUMCULLER_H
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Frustum.h"
+#include "../core/JobSystem.h"
+
+// bounding spheres as structure of arrays (one aligned float array per component), so the culling kernels test
+// 4 or 8 objects per instruction. arrays are padded to a multiple of 8, boxes go in as their bounding sphere
+class BoundsStore {
+private:
+    struct AlignedDelete {
+        void operator()(float* data) const { ::operator delete[](data, std::align_val_t(alignment)); }
+    };
+    using Array = std::unique_ptr<float[], AlignedDelete>;
+    
+    Array centerX, centerY, centerZ, radii;
+    uint32_t count = 0;
+    uint32_t capacity = 0;
+public:
+    static constexpr size_t alignment = 32;
+    static constexpr uint32_t padding = 8;
+    
+    void reserve(uint32_t objects);
+    // index of the new sphere, stable until clear
+    uint32_t add(glm::vec3 center, float radius);
+    void set(uint32_t index, glm::vec3 center, float radius) {
+        centerX[index] = center.x;
+        centerY[index] = center.y;
+        centerZ[index] = center.z;
+        radii[index] = radius;
+    }
+    void clear() { count = 0; }
+    
+    [[nodiscard]] uint32_t size() const { return count; }
+    [[nodiscard]] const float* x() const { return centerX.get(); }
+    [[nodiscard]] const float* y() const { return centerY.get(); }
+    [[nodiscard]] const float* z() const { return centerZ.get(); }
+    [[nodiscard]] const float* radius() const { return radii.get(); }
+};
+
+// tests a BoundsStore against a frustum and writes the indices of the visible spheres. the kernel (AVX2 + FMA, SSE
+// or scalar) is picked once from what the cpu supports, big stores are split into jobs
+class FrustumCuller {
+public:
+    enum class Kernel : uint8_t {
+        Scalar,
+        Sse,
+        Avx2,
+    };
+    
+private:
+    JobSystem* jobs;
+    uint32_t objectsPerJob;
+    Kernel kernel;
+    // visible objects of each job, their indices are compacted after all jobs ran
+    std::vector<uint32_t> jobCounts;
+    // where the kernels write visible indices. grown without initializing, every index is written before it's read
+    std::unique_ptr<uint32_t[]> indices;
+    uint32_t indexCapacity = 0;
+    
+    static Kernel detectKernel();
+public:
+    // without a job system everything is culled on the calling thread
+    explicit FrustumCuller(JobSystem* jobSystem = nullptr, uint32_t jobSize = 16384);
+    
+    // indices of the visible spheres in ascending order, valid until the next cull. the storage behind it is kept,
+    // so once it held every object culling doesn't allocate
+    std::span<const uint32_t> cull(const BoundsStore& bounds, const Frustum& frustum);
+    
+    [[nodiscard]] static bool isSupported(Kernel kernel);
+    // for comparisons, false (and nothing changes) when the cpu can't run it
+    bool setKernel(Kernel forced);
+    [[nodiscard]] Kernel activeKernel() const { return kernel; }
+    [[nodiscard]] static const char* kernelName(Kernel kernel);
+};
+
+#endif //CITRINE_FRUSTUMCULLER_H
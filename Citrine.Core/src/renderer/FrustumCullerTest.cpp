@@ -0,0 +1,47 @@
+#include "FrustumCuller.h"
+#include "../core/Test.h"
+#include <algorithm>
+#include <random>
+
+// every kernel the cpu runs has to find exactly the spheres Frustum::intersectsSphere finds, in the same order,
+// single threaded and split into jobs. the count isn't a multiple of 8 so the masked tail is covered too
+int main() {
+    constexpr uint32_t count = 10003;
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(-3, 3), radius(0, .5f);
+
+    BoundsStore bounds;
+    for (uint32_t i = 0; i < count; ++i) bounds.add({position(random), position(random), position(random)}, radius(random));
+
+    // vulkan clip space is the frustum of the identity
+    Frustum frustum = Frustum::fromViewProjection(glm::mat4(1));
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (frustum.intersectsSphere({bounds.x()[i], bounds.y()[i], bounds.z()[i]}, bounds.radius()[i])) expected.push_back(i);
+    }
+    CITRINE_CHECK(!expected.empty() && expected.size() < count);
+
+    JobSystem jobs;
+    jobs.create(2);
+    const FrustumCuller::Kernel kernels[] = {FrustumCuller::Kernel::Scalar, FrustumCuller::Kernel::Sse, FrustumCuller::Kernel::Avx2};
+    for (FrustumCuller::Kernel kernel: kernels) {
+        if (!FrustumCuller::isSupported(kernel)) {
+            std::cout << FrustumCuller::kernelName(kernel) << ": not supported, skipped\n";
+            continue;
+        }
+
+        FrustumCuller single;
+        FrustumCuller split(&jobs, 256);
+        CITRINE_CHECK(single.setKernel(kernel) && split.setKernel(kernel));
+        for (FrustumCuller* culler: {&single, &split}) {
+            std::span<const uint32_t> visible = culler->cull(bounds, frustum);
+            CITRINE_CHECK(std::ranges::equal(visible, expected));
+            // again, now with the storage of the first call
+            visible = culler->cull(bounds, frustum);
+            CITRINE_CHECK(std::ranges::equal(visible, expected));
+        }
+    }
+    jobs.destroy();
+
+    return citrineTestResult();
+}
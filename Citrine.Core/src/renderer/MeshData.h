@@ -0,0 +1,14 @@
+#ifndef CITRINE_MESHDATA_H
+#define CITRINE_MESHDATA_H
+
+#include <cstdint>
+#include <vector>
+#include "vk/Vertex.h"
+
+// cpu side indexed triangle list, what Mesh::create uploads
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+#endif //CITRINE_MESHDATA_H
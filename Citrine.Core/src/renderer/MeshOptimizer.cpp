@@ -0,0 +1,268 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace {
+    // vertex as raw bits, equal keys are bitwise equal vertices
+    using VertexKey = std::array<uint32_t, sizeof(Vertex) / sizeof(uint32_t)>;
+
+    struct VertexKeyHash {
+        size_t operator()(const VertexKey& key) const {
+            // FNV-1a over the words
+            uint64_t hash = 14695981039346656037ull;
+            for (uint32_t word: key) {
+                hash ^= word;
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+    };
+
+    // fifo cache simulation through timestamps: a vertex is cached while fewer than cacheSize misses happened since its own
+    struct FifoCache {
+        std::vector<uint32_t> timestamps;
+        uint32_t time = MeshOptimizer::cacheSize + 1;
+
+        explicit FifoCache(uint32_t vertexCount) : timestamps(vertexCount, 0) {}
+
+        uint32_t access(uint32_t vertex) {
+            if (time - timestamps[vertex] <= MeshOptimizer::cacheSize) return 0;
+            timestamps[vertex] = time++;
+            return 1;
+        }
+
+        void flush() { time += MeshOptimizer::cacheSize + 1; }
+    };
+
+    // Forsyth's scoring, the cache it models is larger than the one it optimizes for
+    constexpr uint32_t scoreCacheSize = 32;
+
+    float vertexScore(int32_t cachePosition, uint32_t remainingTriangles) {
+        if (remainingTriangles == 0) return -1;
+        float score = 0;
+        // the last triangle's vertices get a fixed score, so the next one doesn't just reuse its edge
+        if (cachePosition >= 0 && cachePosition < 3) score = .75f;
+        else if (cachePosition >= 3) score = std::pow(1 - static_cast<float>(cachePosition - 3) / (scoreCacheSize - 3), 1.5f);
+        // favour vertices with few triangles left, finishing them frees the cache
+        return score + 2 * std::pow(static_cast<float>(remainingTriangles), -.5f);
+    }
+
+    glm::vec3 sub(glm::vec3 a, glm::vec3 b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+}
+
+void MeshOptimizer::deduplicate(MeshData& mesh) {
+    std::unordered_map<VertexKey, uint32_t, VertexKeyHash> unique;
+    unique.reserve(mesh.vertices.size());
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+    // first pass maps every old vertex, so indices that already share vertices keep working
+    std::vector<uint32_t> remap(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        VertexKey key;
+        std::memcpy(key.data(), &mesh.vertices[i], sizeof(Vertex));
+        auto [it, inserted] = unique.try_emplace(key, static_cast<uint32_t>(vertices.size()));
+        if (inserted) vertices.push_back(mesh.vertices[i]);
+        remap[i] = it->second;
+    }
+    for (uint32_t& index: mesh.indices) index = remap[index];
+    mesh.vertices = std::move(vertices);
+}
+
+void MeshOptimizer::optimizeVertexCache(MeshData& mesh) {
+    uint32_t triangleCount = mesh.indices.size() / 3;
+    uint32_t vertexCount = mesh.vertices.size();
+    if (triangleCount == 0) return;
+    const std::vector<uint32_t>& indices = mesh.indices;
+
+    // triangles of each vertex, the first remaining[v] entries of its range are the ones not emitted yet
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (uint32_t index: indices) remaining[index]++;
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        for (uint32_t c = 0; c < 3; ++c) adjacency[fill[indices[t * 3 + c]]++] = t;
+    }
+
+    std::vector<int32_t> cachePosition(vertexCount, -1);
+    std::vector<float> scores(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v) scores[v] = vertexScore(-1, remaining[v]);
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    for (uint32_t t = 0; t < triangleCount; ++t) triangleScores[t] = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+
+    std::array<uint32_t, scoreCacheSize + 3> cache{};
+    std::array<uint32_t, scoreCacheSize + 3> nextCache{};
+    uint32_t cacheCount = 0;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    uint32_t best = static_cast<uint32_t>(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+    // where the search for a new start continues when no cached vertex has triangles left
+    uint32_t cursor = 0;
+    for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        if (best == UINT32_MAX) {
+            while (emitted[cursor]) cursor++;
+            best = cursor;
+        }
+        emitted[best] = true;
+        
+        uint32_t nextCount = 0;
+        for (uint32_t c = 0; c < 3; ++c) {
+            uint32_t v = indices[best * 3 + c];
+            result.push_back(v);
+            nextCache[nextCount++] = v;
+            
+            // drop the triangle from the vertex's remaining ones
+            uint32_t* begin = adjacency.data() + offsets[v];
+            uint32_t* end = begin + remaining[v];
+            *std::find(begin, end, best) = *(end - 1);
+            remaining[v]--;
+        }
+        for (uint32_t i = 0; i < cacheCount; ++i) {
+            uint32_t v = cache[i];
+            if (v != nextCache[0] && v != nextCache[1] && v != nextCache[2]) nextCache[nextCount++] = v;
+        }
+        std::swap(cache, nextCache);
+        cacheCount = std::min(nextCount, scoreCacheSize);
+        
+        // vertices pushed out of the cache (past cacheCount) lose their cache score as well
+        for (uint32_t i = 0; i < nextCount; ++i) {
+            uint32_t v = cache[i];
+            cachePosition[v] = i < scoreCacheSize ? static_cast<int32_t>(i) : -1;
+            scores[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+        
+        // only triangles around cached vertices changed score, the next one comes from them
+        best = UINT32_MAX;
+        float bestScore = 0;
+        for (uint32_t i = 0; i < nextCount; ++i) {
+            uint32_t v = cache[i];
+            for (uint32_t a = offsets[v]; a < offsets[v] + remaining[v]; ++a) {
+                uint32_t t = adjacency[a];
+                float score = scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+    }
+    mesh.indices = std::move(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(MeshData& mesh, float threshold) {
+    uint32_t triangleCount = mesh.indices.size() / 3;
+    if (triangleCount == 0) return;
+    const std::vector<uint32_t>& indices = mesh.indices;
+    uint32_t vertexCount = mesh.vertices.size();
+
+    // hard boundaries: triangles that miss all three vertices start somewhere new
+    std::vector<uint32_t> hardClusters;
+    std::vector<uint8_t> misses(triangleCount);
+    FifoCache cache(vertexCount);
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        misses[t] = cache.access(indices[t * 3]) + cache.access(indices[t * 3 + 1]) + cache.access(indices[t * 3 + 2]);
+        if (t == 0 || misses[t] == 3) hardClusters.push_back(t);
+    }
+    hardClusters.push_back(triangleCount);
+
+    // soft boundaries: split a hard cluster wherever the part so far is already as cache efficient as allowed,
+    // the cache restarts there so either order of the parts stays within the threshold
+    std::vector<uint32_t> clusters;
+    FifoCache softCache(vertexCount);
+    for (size_t c = 0; c + 1 < hardClusters.size(); ++c) {
+        uint32_t begin = hardClusters[c], end = hardClusters[c + 1];
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = begin; t < end; ++t) clusterMisses += misses[t];
+        float allowed = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+        
+        softCache.flush();
+        clusters.push_back(begin);
+        uint32_t runMisses = 0, runTriangles = 0;
+        for (uint32_t t = begin; t < end; ++t) {
+            runMisses += softCache.access(indices[t * 3]) + softCache.access(indices[t * 3 + 1]) + softCache.access(indices[t * 3 + 2]);
+            runTriangles++;
+            if (t + 1 < end && static_cast<float>(runMisses) <= allowed * static_cast<float>(runTriangles)) {
+                clusters.push_back(t + 1);
+                softCache.flush();
+                runMisses = 0;
+                runTriangles = 0;
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+    uint32_t clusterCount = clusters.size() - 1;
+
+    // area weighted centroids and normals, the cluster whose normal points away from the mesh center the most draws first
+    auto position = [&](uint32_t t, uint32_t c) { return mesh.vertices[indices[t * 3 + c]].pos; };
+    std::vector<glm::vec3> clusterCentroid(clusterCount, glm::vec3(0));
+    std::vector<glm::vec3> clusterNormal(clusterCount, glm::vec3(0));
+    std::vector<float> clusterArea(clusterCount, 0);
+    glm::vec3 meshCentroid(0);
+    float meshArea = 0;
+    for (uint32_t c = 0; c < clusterCount; ++c) {
+        for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            glm::vec3 a = position(t, 0), b = position(t, 1), v = position(t, 2);
+            glm::vec3 normal = glm::cross(sub(b, a), sub(v, a));
+            float area = glm::length(normal);
+            glm::vec3 centroid = (a + b + v) * (1.f / 3);
+            clusterCentroid[c] = clusterCentroid[c] + centroid * area;
+            clusterNormal[c] = clusterNormal[c] + normal;
+            clusterArea[c] += area;
+        }
+        meshCentroid = meshCentroid + clusterCentroid[c];
+        meshArea += clusterArea[c];
+    }
+    if (meshArea > 0) meshCentroid = meshCentroid * (1 / meshArea);
+
+    std::vector<float> keys(clusterCount, 0);
+    for (uint32_t c = 0; c < clusterCount; ++c) {
+        float normalLength = glm::length(clusterNormal[c]);
+        if (clusterArea[c] <= 0 || normalLength <= 0) continue;
+        glm::vec3 centroid = clusterCentroid[c] * (1 / clusterArea[c]);
+        keys[c] = glm::dot(sub(centroid, meshCentroid), clusterNormal[c] * (1 / normalLength));
+    }
+    std::vector<uint32_t> order(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; ++c) order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) { return keys[a] > keys[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (uint32_t c: order) result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+    mesh.indices = std::move(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(MeshData& mesh) {
+    std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+    for (uint32_t& index: mesh.indices) {
+        if (remap[index] == UINT32_MAX) {
+            remap[index] = vertices.size();
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices = std::move(vertices);
+}
+
+void MeshOptimizer::optimize(MeshData& mesh) {
+    deduplicate(mesh);
+    optimizeVertexCache(mesh);
+    optimizeOverdraw(mesh);
+    optimizeVertexFetch(mesh);
+}
+
+float MeshOptimizer::averageCacheMissRatio(std::span<const uint32_t> indices, uint32_t vertexCount) {
+    if (indices.size() < 3) return 0;
+    FifoCache cache(vertexCount);
+    uint32_t misses = 0;
+    for (uint32_t index: indices) misses += cache.access(index);
+    return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
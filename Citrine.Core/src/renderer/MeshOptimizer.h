@@ -0,0 +1,30 @@
+#ifndef CITRINE_MESHOPTIMIZER_H
+#define CITRINE_MESHOPTIMIZER_H
+
+#include <cstdint>
+#include <span>
+#include "MeshData.h"
+
+// offline style passes over a MeshData, run once at load. optimize() runs them all in the order they depend on:
+// deduplicate, post transform cache order, overdraw order, then vertex fetch order
+namespace MeshOptimizer {
+    // post transform cache the statistics simulate, a conservative size for current gpus
+    constexpr uint32_t cacheSize = 16;
+    
+    // merges bitwise equal vertices and rewrites the indices to them
+    void deduplicate(MeshData& mesh);
+    // reorders triangles for the post transform vertex cache (Forsyth, "linear-speed vertex cache optimisation")
+    void optimizeVertexCache(MeshData& mesh);
+    // reorders clusters of the cache optimized order so outward facing ones come first (Sander et al., "fast triangle
+    // reordering for vertex locality and reduced overdraw"). threshold: how much worse than the input the cache
+    // efficiency of the result may get, 1.05 allows 5%
+    void optimizeOverdraw(MeshData& mesh, float threshold = 1.05f);
+    // reorders vertices by first use in the index buffer and drops unused ones
+    void optimizeVertexFetch(MeshData& mesh);
+    void optimize(MeshData& mesh);
+    
+    // transformed vertices per triangle with a fifo cache of cacheSize, 0.5 (ideal grid) to 3 (no reuse)
+    [[nodiscard]] float averageCacheMissRatio(std::span<const uint32_t> indices, uint32_t vertexCount);
+}
+
+#endif //CITRINE_MESHOPTIMIZER_H
@@ -0,0 +1,87 @@
+#include "MeshOptimizer.h"
+#include "../core/Test.h"
+#include <algorithm>
+#include <array>
+#include <random>
+
+namespace {
+    // side x side quads with a vertex per corner and shuffled triangles, like ObjLoader hands over a scanned mesh
+    MeshData shuffledGrid(uint32_t side) {
+        std::vector<std::array<glm::vec3, 3>> triangles;
+        for (uint32_t y = 0; y < side; ++y) {
+            for (uint32_t x = 0; x < side; ++x) {
+                glm::vec3 a(x, y, 0), b(x + 1, y, 0), c(x + 1, y + 1, 0), d(x, y + 1, 0);
+                triangles.push_back({a, b, c});
+                triangles.push_back({a, c, d});
+            }
+        }
+        std::shuffle(triangles.begin(), triangles.end(), std::mt19937(3));
+
+        MeshData mesh;
+        for (const auto& triangle: triangles) {
+            for (glm::vec3 position: triangle) {
+                mesh.indices.push_back(mesh.vertices.size());
+                mesh.vertices.push_back({position, glm::vec3(1)});
+            }
+        }
+        return mesh;
+    }
+
+    // corner positions per triangle, rotated to start at the smallest so reordering passes compare equal but a
+    // flipped winding doesn't
+    std::vector<std::array<float, 9>> triangles(const MeshData& mesh) {
+        std::vector<std::array<float, 9>> result;
+        for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+            std::array<std::array<float, 3>, 3> corners;
+            for (int c = 0; c < 3; ++c) {
+                glm::vec3 position = mesh.vertices[mesh.indices[i + c]].pos;
+                corners[c] = {position.x, position.y, position.z};
+            }
+            std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+            std::array<float, 9> flat;
+            for (int c = 0; c < 3; ++c) std::copy(corners[c].begin(), corners[c].end(), flat.begin() + c * 3);
+            result.push_back(flat);
+        }
+        std::ranges::sort(result);
+        return result;
+    }
+}
+
+int main() {
+    // acmr of known index streams: no reuse, full reuse and a miss on every corner once the cache evicted it
+    const uint32_t separate[] = {0, 1, 2, 3, 4, 5};
+    CITRINE_CHECK(MeshOptimizer::averageCacheMissRatio(separate, 6) == 3);
+    const uint32_t repeated[] = {0, 1, 2, 0, 1, 2};
+    CITRINE_CHECK(MeshOptimizer::averageCacheMissRatio(repeated, 3) == 1.5f);
+    std::vector<uint32_t> evicted;
+    for (uint32_t i = 0; i < (MeshOptimizer::cacheSize / 3 + 1) * 3; ++i) evicted.push_back(i);
+    evicted.insert(evicted.end(), {0, 1, 2});
+    CITRINE_CHECK(MeshOptimizer::averageCacheMissRatio(evicted, evicted.size()) == 3);
+
+    MeshData mesh = shuffledGrid(32);
+    auto before = triangles(mesh);
+    MeshData deduplicated = mesh;
+    MeshOptimizer::deduplicate(deduplicated);
+    CITRINE_CHECK(deduplicated.vertices.size() == 33 * 33);
+    float shuffledAcmr = MeshOptimizer::averageCacheMissRatio(deduplicated.indices, deduplicated.vertices.size());
+
+    MeshOptimizer::optimize(mesh);
+    float acmr = MeshOptimizer::averageCacheMissRatio(mesh.indices, mesh.vertices.size());
+    std::cout << "acmr shuffled " << shuffledAcmr << ", optimized " << acmr << "\n";
+    // a regular grid can't go below 0.5, a 16 entry fifo on a grid this wide should get well under 1
+    CITRINE_CHECK(acmr >= .5f && acmr < .9f);
+    CITRINE_CHECK(acmr < shuffledAcmr * .5f);
+    // same vertices (deduplicated, in fetch order: first use in the index buffer) and the same triangles
+    CITRINE_CHECK(mesh.vertices.size() == 33 * 33);
+    CITRINE_CHECK(mesh.indices.size() == 32 * 32 * 6);
+    CITRINE_CHECK(triangles(mesh) == before);
+    uint32_t next = 0;
+    bool fetchOrder = true;
+    for (uint32_t index: mesh.indices) {
+        if (index > next) fetchOrder = false;
+        if (index == next) next++;
+    }
+    CITRINE_CHECK(fetchOrder && next == mesh.vertices.size());
+
+    return citrineTestResult();
+}
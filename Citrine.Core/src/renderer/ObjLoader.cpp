@@ -0,0 +1,105 @@
+#include "ObjLoader.h"
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    struct Corner {
+        uint32_t position;
+        // UINT32_MAX without a normal
+        uint32_t normal;
+    };
+
+    // 1 based, negative counts back from the last element read so far
+    uint32_t resolveIndex(long index, size_t count, const std::string& path) {
+        long resolved = index < 0 ? static_cast<long>(count) + index : index - 1;
+        if (index == 0 || resolved < 0 || resolved >= static_cast<long>(count)) {
+            throw std::runtime_error("index out of range in '" + path + "' (ObjLoader.cpp)");
+        }
+        return static_cast<uint32_t>(resolved);
+    }
+
+    // "v", "v/vt", "v//vn" or "v/vt/vn"
+    Corner parseCorner(const char*& cursor, size_t positions, size_t normals, const std::string& path) {
+        char* end = nullptr;
+        Corner corner{resolveIndex(std::strtol(cursor, &end, 10), positions, path), UINT32_MAX};
+        if (end == cursor) throw std::runtime_error("malformed face in '" + path + "' (ObjLoader.cpp)");
+        cursor = end;
+        if (*cursor != '/') return corner;
+        // texture coordinate, skipped
+        std::strtol(++cursor, &end, 10);
+        cursor = end;
+        if (*cursor != '/') return corner;
+        long normal = std::strtol(++cursor, &end, 10);
+        if (end != cursor) corner.normal = resolveIndex(normal, normals, path);
+        cursor = end;
+        return corner;
+    }
+
+    const char* skipSpaces(const char* cursor) {
+        while (*cursor == ' ' || *cursor == '\t') cursor++;
+        return cursor;
+    }
+}
+
+MeshData ObjLoader::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) throw std::runtime_error("failed to open '" + path + "' (ObjLoader.cpp)");
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> colors;
+    std::vector<glm::vec3> normals;
+    std::vector<Corner> face;
+    MeshData mesh;
+
+    std::string line;
+    while (std::getline(file, line)) {
+        const char* cursor = skipSpaces(line.c_str());
+        char* end = nullptr;
+        if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            float values[6] = {0, 0, 0, 1, 1, 1};
+            uint32_t count = 0;
+            cursor += 2;
+            for (; count < 6; ++count) {
+                values[count] = std::strtof(cursor, &end);
+                if (end == cursor) break;
+                cursor = end;
+            }
+            if (count < 3) throw std::runtime_error("malformed vertex in '" + path + "' (ObjLoader.cpp)");
+            positions.emplace_back(values[0], values[1], values[2]);
+            // a vertex without color between colored ones stays white
+            if (count == 6 || !colors.empty()) {
+                colors.resize(positions.size() - 1, glm::vec3(1));
+                colors.emplace_back(values[3], values[4], values[5]);
+            }
+        } else if (cursor[0] == 'v' && cursor[1] == 'n') {
+            cursor += 2;
+            float values[3];
+            for (float& value: values) {
+                value = std::strtof(cursor, &end);
+                cursor = end;
+            }
+            normals.emplace_back(values[0], values[1], values[2]);
+        } else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t')) {
+            face.clear();
+            cursor = skipSpaces(cursor + 2);
+            while (*cursor != '\0' && *cursor != '\r' && *cursor != '#') {
+                face.push_back(parseCorner(cursor, positions.size(), normals.size(), path));
+                cursor = skipSpaces(cursor);
+            }
+            if (face.size() < 3) throw std::runtime_error("face with less than 3 vertices in '" + path + "' (ObjLoader.cpp)");
+            // fan around the first corner, fine for the convex polygons exporters write
+            for (size_t i = 1; i + 1 < face.size(); ++i) {
+                for (const Corner& corner: {face[0], face[i], face[i + 1]}) {
+                    glm::vec3 color(1);
+                    if (!colors.empty()) color = corner.position < colors.size() ? colors[corner.position] : glm::vec3(1);
+                    else if (corner.normal != UINT32_MAX) color = normals[corner.normal] * .5f + glm::vec3(.5f);
+                    mesh.indices.push_back(mesh.vertices.size());
+                    mesh.vertices.push_back({positions[corner.position], color});
+                }
+            }
+        }
+    }
+    if (mesh.indices.empty()) throw std::runtime_error("no faces in '" + path + "' (ObjLoader.cpp)");
+    return mesh;
+}
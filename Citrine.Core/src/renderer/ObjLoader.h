@@ -0,0 +1,15 @@
+#ifndef CITRINE_OBJLOADER_H
+#define CITRINE_OBJLOADER_H
+
+#include <string>
+#include "MeshData.h"
+
+// wavefront obj: positions (with the common "v x y z r g b" vertex color extension), normals and faces of any size,
+// fan triangulated. materials, texture coordinates and groups are ignored.
+// the result has one vertex per triangle corner, MeshOptimizer::deduplicate builds the real index buffer
+namespace ObjLoader {
+    // color is the vertex color, else the normal mapped to 0..1, else white
+    MeshData load(const std::string& path);
+}
+
+#endif //CITRINE_OBJLOADER_H
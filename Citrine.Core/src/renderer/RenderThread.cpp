@@ -0,0 +1,40 @@
+#include "RenderThread.h"
+#include "../core/Profiler.h"
+
+void RenderThread::start(std::function<void(const FrameSnapshot&)> render) {
+    renderFrame = std::move(render);
+    failed = false;
+    error = nullptr;
+    thread = std::thread(&RenderThread::loop, this);
+}
+
+bool RenderThread::submit(const FrameSnapshot& snapshot) {
+    return snapshots.tryPush(snapshot);
+}
+
+void RenderThread::stop() {
+    FrameSnapshot quit{};
+    quit.quit = true;
+    // a failed render thread doesn't consume anymore
+    while (!hasFailed() && !snapshots.tryPush(quit)) std::this_thread::yield();
+    if (thread.joinable()) thread.join();
+    if (error) std::rethrow_exception(error);
+}
+
+void RenderThread::loop() {
+    CITRINE_PROFILE_THREAD("render");
+    while (true) {
+        FrameSnapshot snapshot;
+        while (!snapshots.tryPop(snapshot)) snapshots.waitForData();
+        if (snapshot.quit) return;
+        
+        try {
+            renderFrame(snapshot);
+        } catch (...) {
+            error = std::current_exception();
+            failed.store(true, std::memory_order_release);
+            return;
+        }
+        renderedFrames.fetch_add(1, std::memory_order_relaxed);
+    }
+}
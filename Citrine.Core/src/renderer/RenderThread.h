@@ -0,0 +1,50 @@
+#ifndef CITRINE_RENDERTHREAD_H
+#define CITRINE_RENDERTHREAD_H
+
+#include "vk/VkHelper.h"
+#include "vk/FrameSettings.h"
+#include <atomic>
+#include <thread>
+#include <exception>
+#include <functional>
+#include "../core/SpscQueue.h"
+
+// everything the render thread needs to know about a frame, copied out of the main thread's state.
+// the render thread never reads main thread state (or calls glfw) directly.
+struct FrameSnapshot {
+    uint64_t frame = 0;
+    double time = 0;
+    VkExtent2D framebufferExtent{};
+    PresentPolicy presentPolicy = PresentPolicy::LowLatency;
+    // tells the render thread to exit, not rendered
+    bool quit = false;
+};
+
+// records and submits frames on its own thread, so vkWaitForFences/present never stall event handling.
+// the main thread hands over snapshots through a bounded lock free queue and runs at most
+// maxQueuedFrames ahead, submit() fails instead of blocking when the render thread is behind.
+class RenderThread {
+private:
+    static constexpr size_t maxQueuedFrames = 2;
+
+    SpscQueue<FrameSnapshot, maxQueuedFrames> snapshots;
+    std::thread thread;
+    std::function<void(const FrameSnapshot&)> renderFrame;
+    std::atomic<uint64_t> renderedFrames = 0;
+    std::atomic<bool> failed = false;
+    std::exception_ptr error;
+
+    void loop();
+public:
+    void start(std::function<void(const FrameSnapshot&)> render);
+    // main thread only, false when maxQueuedFrames are already waiting
+    bool submit(const FrameSnapshot& snapshot);
+    // lets the render thread finish the queued frames and joins it, rethrows an exception of the render thread
+    void stop();
+
+    [[nodiscard]] uint64_t framesRendered() const { return renderedFrames.load(std::memory_order_relaxed); }
+    // the render thread threw and stopped, call stop() to get the exception
+    [[nodiscard]] bool hasFailed() const { return failed.load(std::memory_order_acquire); }
+};
+
+#endif //CITRINE_RENDERTHREAD_H
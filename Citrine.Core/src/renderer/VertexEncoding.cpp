@@ -0,0 +1,144 @@
+#include "VertexEncoding.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CITRINE_ENCODE_SSE2
+#endif
+
+namespace {
+    // value already scaled by 32767, rounded half away from zero the way the simd path does it
+    int16_t roundSnorm16(float scaled) {
+        scaled = std::clamp(scaled, -32767.f, 32767.f);
+        int32_t magnitude = static_cast<int32_t>(std::abs(scaled) + .5f);
+        return static_cast<int16_t>(scaled < 0 ? -magnitude : magnitude);
+    }
+
+    int16_t snorm16(float value) { return roundSnorm16(value * 32767); }
+
+    uint32_t unorm8(float value) {
+        return static_cast<uint32_t>(std::clamp(value, 0.f, 1.f) * 255 + .5f);
+    }
+
+    // one vertex at a time, what the simd path has to match bit for bit. scale includes the snorm range
+    [[maybe_unused]] void quantizeScalar(const Vertex* in, CompactVertex* out, size_t count, glm::vec3 center, glm::vec3 scale) {
+        for (size_t i = 0; i < count; ++i) {
+            glm::vec3 p = (in[i].pos - center) * scale;
+            out[i].pos[0] = roundSnorm16(p.x);
+            out[i].pos[1] = roundSnorm16(p.y);
+            out[i].pos[2] = roundSnorm16(p.z);
+            out[i].pos[3] = 0;
+            out[i].col = unorm8(in[i].col.x) | unorm8(in[i].col.y) << 8 | unorm8(in[i].col.z) << 16 | 0xFFu << 24;
+        }
+    }
+
+#ifdef CITRINE_ENCODE_SSE2
+    // both loads stay inside the 24 byte vertex: pos.xyz + col.r and pos.z + col.rgb
+    void quantizeSse2(const Vertex* in, CompactVertex* out, size_t count, glm::vec3 center, glm::vec3 scale) {
+        static_assert(sizeof(Vertex) == 6 * sizeof(float));
+        // w lanes are 0, so the color channel loaded with the position encodes to 0
+        const __m128 centerLanes = _mm_setr_ps(center.x, center.y, center.z, 0);
+        const __m128 scaleLanes = _mm_setr_ps(scale.x, scale.y, scale.z, 0);
+        const __m128 snormMax = _mm_set1_ps(32767);
+        const __m128 colorScale = _mm_set1_ps(255);
+        const __m128 half = _mm_set1_ps(.5f);
+        const __m128 zero = _mm_setzero_ps();
+        for (size_t i = 0; i < count; ++i) {
+            const float* vertex = reinterpret_cast<const float*>(in + i);
+            __m128 position = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(vertex), centerLanes), scaleLanes);
+            position = _mm_min_ps(_mm_max_ps(position, _mm_sub_ps(zero, snormMax)), snormMax);
+            // round half away from zero: truncate |x| + .5 and put the sign back
+            __m128 sign = _mm_and_ps(position, _mm_set1_ps(-0.f));
+            __m128i rounded = _mm_cvttps_epi32(_mm_or_ps(_mm_add_ps(_mm_andnot_ps(_mm_set1_ps(-0.f), position), half), sign));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out[i].pos), _mm_packs_epi32(rounded, rounded));
+
+            // (pos.z, r, g, b) -> (r, g, b, pos.z), alpha is forced to 255 below
+            __m128 color = _mm_loadu_ps(vertex + 2);
+            color = _mm_shuffle_ps(color, color, _MM_SHUFFLE(0, 3, 2, 1));
+            color = _mm_min_ps(_mm_max_ps(color, zero), _mm_set1_ps(1));
+            __m128i channels = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(color, colorScale), half));
+            channels = _mm_packs_epi32(channels, channels);
+            out[i].col = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(channels, channels))) | 0xFFu << 24;
+        }
+    }
+#endif
+}
+
+VertexEncoding::QuantizedMesh VertexEncoding::quantize(const MeshData& mesh) {
+    QuantizedMesh result;
+    result.indices = mesh.indices;
+    result.vertices.resize(mesh.vertices.size());
+    if (mesh.vertices.empty()) return result;
+    
+    glm::vec3 min = mesh.vertices[0].pos, max = mesh.vertices[0].pos;
+    for (const Vertex& vertex: mesh.vertices) {
+        min = glm::min(min, vertex.pos);
+        max = glm::max(max, vertex.pos);
+    }
+    glm::vec3 center = (min + max) * .5f;
+    // flat axes still need a scale, any one works
+    glm::vec3 extent = glm::max((max - min) * .5f, glm::vec3(1e-20f));
+    glm::vec3 scale = 32767.f / extent;
+    
+#ifdef CITRINE_ENCODE_SSE2
+    quantizeSse2(mesh.vertices.data(), result.vertices.data(), mesh.vertices.size(), center, scale);
+#else
+    quantizeScalar(mesh.vertices.data(), result.vertices.data(), mesh.vertices.size(), center, scale);
+#endif
+    
+    // snorm s decodes to s / 32767, model position = center + extent * s
+    result.decode = glm::mat4(1);
+    result.decode[0][0] = extent.x;
+    result.decode[1][1] = extent.y;
+    result.decode[2][2] = extent.z;
+    result.decode[3] = glm::vec4(center, 1);
+    return result;
+}
+
+uint32_t VertexEncoding::encodeOctahedral(glm::vec3 normal) {
+    float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (length == 0) return 0;
+    float x = normal.x / length, y = normal.y / length;
+    // lower hemisphere folds over the diagonals
+    if (normal.z < 0) {
+        float foldedX = (1 - std::abs(y)) * (x >= 0 ? 1.f : -1.f);
+        float foldedY = (1 - std::abs(x)) * (y >= 0 ? 1.f : -1.f);
+        x = foldedX;
+        y = foldedY;
+    }
+    return static_cast<uint16_t>(snorm16(x)) | static_cast<uint32_t>(static_cast<uint16_t>(snorm16(y))) << 16;
+}
+
+uint16_t VertexEncoding::encodeHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = bits >> 16 & 0x8000;
+    uint32_t magnitude = bits & 0x7FFFFFFF;
+    if (magnitude > 0x7F800000) return sign | 0x7E00;
+    
+    int32_t exponent = static_cast<int32_t>(magnitude >> 23) - 127 + 15;
+    uint32_t mantissa = magnitude & 0x7FFFFF;
+    if (exponent >= 31) return sign | 0x7C00;
+    if (exponent <= 0) {
+        // subnormal half (or zero), the implicit one becomes explicit
+        if (exponent < -10) return sign;
+        mantissa |= 0x800000;
+        uint32_t shift = 14 - exponent;
+        uint32_t result = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (result & 1))) result++;
+        return sign | result;
+    }
+    uint32_t result = static_cast<uint32_t>(exponent) << 10 | mantissa >> 13;
+    uint32_t remainder = mantissa & 0x1FFF;
+    // a carry out of the mantissa bumps the exponent, up to infinity
+    if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1))) result++;
+    return sign | result;
+}
+
+uint32_t VertexEncoding::encodeHalf2(glm::vec2 value) {
+    return encodeHalf(value.x) | static_cast<uint32_t>(encodeHalf(value.y)) << 16;
+}
@@ -0,0 +1,30 @@
+#ifndef CITRINE_VERTEXENCODING_H
+#define CITRINE_VERTEXENCODING_H
+
+#include <cstdint>
+#include <vector>
+#include "MeshData.h"
+
+// import time encoders for quantized vertex formats
+namespace VertexEncoding {
+    // what Mesh::create takes for CompactVertex meshes
+    struct QuantizedMesh {
+        std::vector<CompactVertex> vertices;
+        std::vector<uint32_t> indices;
+        // snorm positions back to model space, see Mesh::decode
+        glm::mat4 decode = glm::mat4(1);
+    };
+    
+    // positions as snorm16 relative to the mesh bounds, colors as unorm8. sse2 where the target has it
+    QuantizedMesh quantize(const MeshData& mesh);
+    
+    // building blocks for layouts with normals and texture coordinates.
+    // octahedral normal as two snorm16 (VK_FORMAT_R16G16_SNORM), x in the low half
+    uint32_t encodeOctahedral(glm::vec3 normal);
+    // round to nearest even, overflow gives infinity
+    uint16_t encodeHalf(float value);
+    // VK_FORMAT_R16G16_SFLOAT, x in the low half
+    uint32_t encodeHalf2(glm::vec2 value);
+}
+
+#endif //CITRINE_VERTEXENCODING_H
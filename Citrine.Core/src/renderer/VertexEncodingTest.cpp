@@ -0,0 +1,96 @@
+#include "VertexEncoding.h"
+#include "../core/Test.h"
+#include <cmath>
+#include <random>
+
+namespace {
+    glm::vec3 decodeOctahedral(uint32_t encoded) {
+        float x = static_cast<int16_t>(encoded & 0xFFFF) / 32767.f;
+        float y = static_cast<int16_t>(encoded >> 16) / 32767.f;
+        float z = 1 - std::abs(x) - std::abs(y);
+        if (z < 0) {
+            float foldedX = (1 - std::abs(y)) * (x >= 0 ? 1.f : -1.f);
+            float foldedY = (1 - std::abs(x)) * (y >= 0 ? 1.f : -1.f);
+            x = foldedX;
+            y = foldedY;
+        }
+        return glm::normalize(glm::vec3(x, y, z));
+    }
+}
+
+int main() {
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> position(-5, 20), unit(0, 1);
+
+    // a flat mesh (every z the same) on top, its z must come back exactly
+    MeshData mesh;
+    for (int i = 0; i < 10000; ++i) mesh.vertices.push_back({{position(random), position(random), 3}, {unit(random), unit(random), unit(random)}});
+    mesh.indices = {0, 1, 2};
+    VertexEncoding::QuantizedMesh quantized = VertexEncoding::quantize(mesh);
+    CITRINE_CHECK(quantized.vertices.size() == mesh.vertices.size());
+    CITRINE_CHECK(quantized.indices == mesh.indices);
+
+    glm::vec3 min = mesh.vertices[0].pos, max = mesh.vertices[0].pos;
+    for (const Vertex& vertex: mesh.vertices) {
+        min = glm::min(min, vertex.pos);
+        max = glm::max(max, vertex.pos);
+    }
+    // half a snorm step of the bounds, plus float rounding of the decode
+    glm::vec3 tolerance = (max - min) * .5f / 32767.f * .5f * 1.01f + glm::vec3(1e-5f);
+    glm::vec3 worst(0);
+    float worstColor = 0;
+    bool alpha = true, w = true;
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        const CompactVertex& vertex = quantized.vertices[i];
+        glm::vec4 snorm(vertex.pos[0] / 32767.f, vertex.pos[1] / 32767.f, vertex.pos[2] / 32767.f, 1);
+        glm::vec4 decoded = quantized.decode * snorm;
+        worst = glm::max(worst, glm::abs(glm::vec3(decoded.x, decoded.y, decoded.z) - mesh.vertices[i].pos));
+
+        for (int channel = 0; channel < 3; ++channel) {
+            float color = (vertex.col >> channel * 8 & 0xFF) / 255.f;
+            worstColor = std::max(worstColor, std::abs(color - mesh.vertices[i].col[channel]));
+        }
+        alpha = alpha && vertex.col >> 24 == 0xFF;
+        w = w && vertex.pos[3] == 0;
+    }
+    std::cout << "worst position error " << worst.x << " " << worst.y << " " << worst.z << ", color " << worstColor << "\n";
+    CITRINE_CHECK(worst.x <= tolerance.x && worst.y <= tolerance.y && worst.z <= tolerance.z);
+    CITRINE_CHECK(worst.z == 0);
+    CITRINE_CHECK(worstColor <= .5f / 255 + 1e-6f);
+    CITRINE_CHECK(alpha && w);
+
+    // the bounds map onto the full snorm range
+    int16_t lowest = 0, highest = 0;
+    for (const CompactVertex& vertex: quantized.vertices) {
+        lowest = std::min(lowest, vertex.pos[0]);
+        highest = std::max(highest, vertex.pos[0]);
+    }
+    CITRINE_CHECK(lowest == -32767 && highest == 32767);
+
+    CITRINE_CHECK(VertexEncoding::quantize(MeshData{}).vertices.empty());
+
+    CITRINE_CHECK(VertexEncoding::encodeHalf(0) == 0);
+    CITRINE_CHECK(VertexEncoding::encodeHalf(1) == 0x3C00);
+    CITRINE_CHECK(VertexEncoding::encodeHalf(-2) == 0xC000);
+    CITRINE_CHECK(VertexEncoding::encodeHalf(65504) == 0x7BFF);
+    // halfway between the largest half and infinity rounds to even, which is infinity
+    CITRINE_CHECK(VertexEncoding::encodeHalf(65520) == 0x7C00);
+    CITRINE_CHECK(VertexEncoding::encodeHalf(std::ldexp(1.f, -24)) == 1);
+    CITRINE_CHECK(VertexEncoding::encodeHalf(std::ldexp(1.f, -26)) == 0);
+    CITRINE_CHECK(VertexEncoding::encodeHalf(NAN) == 0x7E00);
+    CITRINE_CHECK(VertexEncoding::encodeHalf2({1, -2}) == (0x3C00u | 0xC000u << 16));
+
+    // octahedral normals, both hemispheres
+    float worstAngle = 1;
+    for (int i = 0; i < 10000; ++i) {
+        glm::vec3 normal(unit(random) * 2 - 1, unit(random) * 2 - 1, unit(random) * 2 - 1);
+        if (glm::length(normal) < 1e-3f) continue;
+        normal = glm::normalize(normal);
+        glm::vec3 decoded = decodeOctahedral(VertexEncoding::encodeOctahedral(normal));
+        worstAngle = std::min(worstAngle, glm::dot(decoded, normal));
+    }
+    std::cout << "worst octahedral cosine " << worstAngle << "\n";
+    CITRINE_CHECK(worstAngle > .99999f);
+
+    return citrineTestResult();
+}
@@ -8,7 +8,7 @@ class Window {
 protected: 
     void createGlfwWindow();
 public:
-    GLFWwindow* glfwWindow;
+    GLFWwindow* glfwWindow = nullptr;
     
     virtual void Loop() const;
     virtual void Close();
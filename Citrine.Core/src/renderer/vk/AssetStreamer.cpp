@@ -0,0 +1,171 @@
+#include "AssetStreamer.h"
+#include <algorithm>
+#include <iostream>
+
+void AssetStreamer::create(const AssetPack& assetPack, VkDeviceSize budget, float deviceShare, uint32_t ioThreadCount) {
+    pack = &assetPack;
+    configuredBudget = budget;
+    deviceBudgetShare = deviceShare;
+    stats = {};
+    refreshBudget();
+    
+    stopping = false;
+    for (uint32_t i = 0; i < std::max(1u, ioThreadCount); ++i) ioThreads.emplace_back([this] { ioLoop(); });
+}
+
+void AssetStreamer::destroy() {
+    {
+        std::lock_guard lock(ioMutex);
+        stopping = true;
+        ioQueue.clear();
+    }
+    ioCondition.notify_all();
+    for (auto& thread: ioThreads) thread.join();
+    ioThreads.clear();
+    
+    // the transfer queue may still write meshes that are loading, frames in flight may still draw resident ones.
+    // the first have to land before their buffers are retired, the deletion queue takes care of the second
+    for (StreamedMesh mesh: loading) {
+        Entry& entry = entries[mesh];
+        if (entry.ioDone.load(std::memory_order_acquire) && !entry.ioFailed) win.uploader.wait(entry.mesh.uploadTicket);
+    }
+    for (Entry& entry: entries) entry.mesh.destroy(win.deletionQueue);
+    entries.clear();
+    residency = {};
+    requested.clear();
+    loading.clear();
+}
+
+StreamedMesh AssetStreamer::add(std::string_view name) {
+    const AssetPackEntry* asset = pack->find(name);
+    if (asset == nullptr || asset->type != AssetType::Mesh) throw std::runtime_error("no mesh '" + std::string(name) + "' in the asset pack (AssetStreamer.cpp)");
+    Entry& entry = entries.emplace_back();
+    entry.asset = asset;
+    residency.add(asset->size);
+    return entries.size() - 1;
+}
+
+void AssetStreamer::request(StreamedMesh mesh, float priority) {
+    Entry& entry = entries[mesh];
+    if (entry.state != State::Unloaded) return;
+    if (entry.requestFrame != frame) {
+        entry.requestFrame = frame;
+        entry.priority = priority;
+        requested.push_back(mesh);
+    }
+    else entry.priority = std::max(entry.priority, priority);
+}
+
+const Mesh* AssetStreamer::get(StreamedMesh mesh) {
+    Entry& entry = entries[mesh];
+    if (entry.state != State::Resident) return nullptr;
+    residency.use(mesh, frame);
+    return &entry.mesh;
+}
+
+void AssetStreamer::update() {
+    CITRINE_PROFILE_SCOPE("asset streaming");
+    if (configuredBudget == 0 && frame % budgetRefreshFrames == 0) refreshBudget();
+    
+    // io done and the transfer finished: drawable from the next frame on
+    for (size_t i = 0; i < loading.size();) {
+        Entry& entry = entries[loading[i]];
+        if (!entry.ioDone.load(std::memory_order_acquire) || (!entry.ioFailed && !entry.mesh.isReady(win.uploader))) {
+            ++i;
+            continue;
+        }
+        // counts as used this frame, the loads below can't evict it before it was drawn
+        residency.endLoad(loading[i], !entry.ioFailed, frame);
+        entry.state = entry.ioFailed ? State::Failed : State::Resident;
+        loading[i] = loading.back();
+        loading.pop_back();
+    }
+    
+    // most important first, a load that doesn't fit stops the rest so smaller, less important ones can't overtake it
+    std::sort(requested.begin(), requested.end(), [this](StreamedMesh a, StreamedMesh b) { return entries[a].priority > entries[b].priority; });
+    for (StreamedMesh mesh: requested) {
+        Entry& entry = entries[mesh];
+        if (loading.size() >= maxLoadsInFlight || !makeRoom(entry.asset->size)) break;
+        entry.state = State::Loading;
+        entry.ioDone.store(false, std::memory_order_relaxed);
+        entry.ioFailed = false;
+        residency.beginLoad(mesh);
+        stats.loads++;
+        loading.push_back(mesh);
+        {
+            std::lock_guard lock(ioMutex);
+            ioQueue.push_back(&entry);
+        }
+        ioCondition.notify_one();
+    }
+    requested.clear();
+    
+    // the budget may have shrunk (other processes, a smaller configured budget), give memory back
+    makeRoom(0);
+    frame++;
+}
+
+void AssetStreamer::ioLoop() {
+    while (true) {
+        Entry* entry;
+        {
+            std::unique_lock lock(ioMutex);
+            ioCondition.wait(lock, [this] { return stopping || !ioQueue.empty(); });
+            if (stopping) return;
+            entry = ioQueue.front();
+            ioQueue.pop_front();
+        }
+        
+        try {
+            // reading the mapping is the actual disk io, the uploader faults it in before it takes its lock and copies
+            // it into its staging ring
+            entry->mesh.create(win.uploader, pack->mesh(pack->name(*entry->asset)));
+        } catch (const std::exception& e) {
+            std::cout << "failed to stream '" << pack->name(*entry->asset) << "': " << e.what() << "\n";
+            entry->ioFailed = true;
+        }
+        entry->ioDone.store(true, std::memory_order_release);
+    }
+}
+
+void AssetStreamer::refreshBudget() {
+    if (configuredBudget != 0) {
+        residency.setBudget(configuredBudget);
+        return;
+    }
+    // what the device allows the process, minus what everything else of it already uses
+    VkDeviceSize deviceBudget = win.allocator.deviceLocalBudget();
+    VkDeviceSize usage = win.allocator.deviceLocalUsage();
+    VkDeviceSize own = residency.resident() + residency.loading();
+    VkDeviceSize others = usage > own ? usage - own : 0;
+    VkDeviceSize available = deviceBudget > others ? deviceBudget - others : 0;
+    residency.setBudget(static_cast<VkDeviceSize>(static_cast<double>(available) * deviceBudgetShare));
+}
+
+bool AssetStreamer::makeRoom(VkDeviceSize bytes) {
+    while (!residency.fits(bytes)) {
+        uint32_t victim = residency.evictionCandidate(frame);
+        if (victim == ResidencyLru::none) return false;
+        evict(victim);
+    }
+    return true;
+}
+
+void AssetStreamer::evict(StreamedMesh mesh) {
+    Entry& entry = entries[mesh];
+    residency.evict(mesh);
+    // the frames in flight that drew it finish first
+    entry.mesh.destroy(win.deletionQueue);
+    entry.state = State::Unloaded;
+    stats.evictions++;
+}
+
+AssetStreamer::Stats AssetStreamer::statistics() const {
+    Stats result = stats;
+    result.budget = residency.budget();
+    result.residentBytes = residency.resident();
+    result.loadingBytes = residency.loading();
+    result.resident = residency.residentItems();
+    result.loading = residency.loadingItems();
+    return result;
+}
@@ -0,0 +1,112 @@
+#ifndef CITRINE_ASSETSTREAMER_H
+#define CITRINE_ASSETSTREAMER_H
+
+#include "VkHelper.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "VkWindow.h"
+#include "Mesh.h"
+#include "../../core/AssetPack.h"
+#include "../../core/ResidencyLru.h"
+
+// mesh of an asset pack known to an AssetStreamer, returned by add
+using StreamedMesh = uint32_t;
+
+// loads and unloads meshes of an asset pack while frames run. the frame thread requests what it wants to draw with a
+// priority (screen size, inverse distance, ...) and update() hands the most important missing meshes to io threads.
+// those read them from the mapping into staging (page faults and copies stay off the frame thread) and the uploader
+// takes them to device local memory. when a load would exceed the budget, the least recently drawn meshes are
+// evicted first; meshes drawn in the current frame are never evicted.
+// everything except the io threads themselves runs on the frame thread. textures aren't streamed yet, Texture::create
+// takes them from the pack up front
+class AssetStreamer {
+public:
+    struct Stats {
+        VkDeviceSize budget = 0;
+        VkDeviceSize residentBytes = 0;
+        VkDeviceSize loadingBytes = 0;
+        uint32_t resident = 0;
+        uint32_t loading = 0;
+        uint64_t loads = 0;
+        uint64_t evictions = 0;
+    };
+
+private:
+    enum class State : uint8_t {
+        Unloaded,
+        // queued or being read by an io thread
+        Loading,
+        Resident,
+        // the io thread couldn't load it, never requested again
+        Failed,
+    };
+
+    // how often the budget follows VK_EXT_memory_budget when it comes from the device
+    static constexpr uint64_t budgetRefreshFrames = 120;
+
+    struct Entry {
+        const AssetPackEntry* asset = nullptr;
+        Mesh mesh;
+        State state = State::Unloaded;
+        // set by the io thread once the upload is queued (or failed), read by update
+        std::atomic<bool> ioDone = false;
+        bool ioFailed = false;
+        float priority = 0;
+        uint64_t requestFrame = UINT64_MAX;
+    };
+
+    VkWindow& win;
+    const AssetPack* pack = nullptr;
+    // stable addresses, io threads hold references while the frame thread adds entries
+    std::deque<Entry> entries;
+    // same indices as entries, sized by the mesh payload (what it takes in device memory give or take the header)
+    ResidencyLru residency;
+
+    // 0: share of the device budget, refreshed every budgetRefreshFrames
+    VkDeviceSize configuredBudget = 0;
+    float deviceBudgetShare = .5f;
+    uint32_t maxLoadsInFlight = 8;
+    // loads and evictions, the rest comes from residency
+    Stats stats;
+    uint64_t frame = 0;
+    std::vector<StreamedMesh> requested;
+    std::vector<StreamedMesh> loading;
+
+    std::vector<std::thread> ioThreads;
+    std::mutex ioMutex;
+    std::condition_variable ioCondition;
+    // pointers, indexing entries would race with add
+    std::deque<Entry*> ioQueue;
+    bool stopping = false;
+
+    void ioLoop();
+    void refreshBudget();
+    // evicts least recently used meshes until bytes more fit, false if the ones left are all in use this frame
+    bool makeRoom(VkDeviceSize bytes);
+    void evict(StreamedMesh mesh);
+public:
+    explicit AssetStreamer(VkWindow& window) : win(window) {}
+
+    // budget in bytes, 0 takes deviceShare of what VK_EXT_memory_budget (or the heap sizes) allows and follows it.
+    // the pack has to outlive the streamer
+    void create(const AssetPack& assetPack, VkDeviceSize budget = 0, float deviceShare = .5f, uint32_t ioThreadCount = 2);
+    void destroy();
+
+    // throws when the pack has no mesh of that name
+    StreamedMesh add(std::string_view name);
+    // the mesh is wanted this frame, higher priorities load first
+    void request(StreamedMesh mesh, float priority);
+    // nullptr until it is resident. counts as a use this frame, which keeps it from being evicted
+    const Mesh* get(StreamedMesh mesh);
+    // once per frame after its requests and gets: finishes loads, starts new ones in priority order, evicts over budget
+    void update();
+
+    [[nodiscard]] Stats statistics() const;
+};
+
+#endif //CITRINE_ASSETSTREAMER_H
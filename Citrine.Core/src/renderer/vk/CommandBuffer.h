@@ -6,11 +6,11 @@
 struct CommandBuffer {
     VkCommandBuffer vk;
     
-    void create(VkCommandPool pool, VkDevice device) {
+    void create(VkCommandPool pool, VkDevice device, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY) {
         VkCommandBufferAllocateInfo bufferAllocateInfo{};
         bufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         bufferAllocateInfo.commandPool = pool;
-        bufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        bufferAllocateInfo.level = level;
         bufferAllocateInfo.commandBufferCount = 1;
         
         VkCheck(vkAllocateCommandBuffers(device, &bufferAllocateInfo, &vk), "vkAllocateCommandBuffers (CommandBuffer.h)");
@@ -26,6 +26,15 @@ struct CommandBuffer {
         VkCheck(vkBeginCommandBuffer(vk, &beginInfo), "vkBeginCommandBuffer (CommandBuffer.h)");
     }
     
+    // secondary buffer that continues the render pass described by inheritanceInfo
+    void recordSecondary(const VkCommandBufferInheritanceInfo& inheritanceInfo) const {
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+        VkCheck(vkBeginCommandBuffer(vk, &beginInfo), "vkBeginCommandBuffer (CommandBuffer.h)");
+    }
+    
     void end() const {
         VkCheck(vkEndCommandBuffer(vk), "vkEndCommandBuffer (CommandBuffer.h)");
     }
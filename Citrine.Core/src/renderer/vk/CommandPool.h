@@ -18,8 +18,7 @@ private:
     }
     
     void createCommandBuffers(LogicalDevice& device) {
-        int count = maxFramesInFlight;
-        for (int i = 0; i < count; ++i) {
+        for (uint32_t i = 0; i < maxFramesInFlight; ++i) {
             CommandBuffer buffer{};
             buffer.create(commandPool, device.device);
             commandBuffers.push_back(buffer);
@@ -27,51 +26,43 @@ private:
     }
     
     void createSyncObjects(LogicalDevice& device) {
-        const int count = maxFramesInFlight;
-        imageAvailableSemaphores.resize(count);
-        renderFinishedSemaphores.resize(count);
-        inFlightFences.resize(count);
+        imageAvailableSemaphores.resize(maxFramesInFlight);
+        renderFinishedSemaphores.resize(maxFramesInFlight);
 
         VkSemaphoreCreateInfo semaphoreCreateInfo{};
         semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-        VkFenceCreateInfo fenceCreateInfo{};
-        fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-        fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-        for (int i = 0; i < count; ++i) {
+        for (uint32_t i = 0; i < maxFramesInFlight; ++i) {
             VkCheck(vkCreateSemaphore(device.device, &semaphoreCreateInfo, nullptr, &imageAvailableSemaphores[i]), "vkCreateSemaphore#1 (CommandPool.h)");
             VkCheck(vkCreateSemaphore(device.device, &semaphoreCreateInfo, nullptr, &renderFinishedSemaphores[i]), "vkCreateSemaphore#2 (CommandPool.h)");
-            VkCheck(vkCreateFence(device.device, &fenceCreateInfo, nullptr, &inFlightFences[i]), "vkCreateFence (CommandPool.h)");
         }
     }
 public:
-    const int maxFramesInFlight = 2;
+    // set by create, one command buffer and semaphore pair per frame in flight
+    uint32_t maxFramesInFlight = 0;
 
     VkCommandPool commandPool;
     std::vector<CommandBuffer> commandBuffers;
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
-    std::vector<VkFence> inFlightFences;
     
     uint32_t currentFrameIndex = 0;
     
     CommandBuffer& currentCommandBuffer() { return commandBuffers[currentFrameIndex]; }
     VkSemaphore& currentImageAvailableSemaphore() { return imageAvailableSemaphores[currentFrameIndex]; }
     VkSemaphore& currentRenderFinishedSemaphore() { return renderFinishedSemaphores[currentFrameIndex]; }
-    VkFence& currentInFlightFence() { return inFlightFences[currentFrameIndex]; }
     
-    void create(Queues& queues, LogicalDevice& device) {
+    void create(Queues& queues, LogicalDevice& device, uint32_t framesInFlight) {
+        maxFramesInFlight = framesInFlight;
         createCommandPool(queues, device);
         createCommandBuffers(device);
         createSyncObjects(device);
     }
     
     void destroy(LogicalDevice& device) {
-        for (int i = 0; i < maxFramesInFlight; ++i) {
+        for (uint32_t i = 0; i < maxFramesInFlight; ++i) {
             vkDestroySemaphore(device.device, imageAvailableSemaphores[i], nullptr);
             vkDestroySemaphore(device.device, renderFinishedSemaphores[i], nullptr);
-            vkDestroyFence(device.device, inFlightFences[i], nullptr);
         }
 
         vkDestroyCommandPool(device.device, commandPool, nullptr);
@@ -0,0 +1,107 @@
+#include "ComputePipeline.h"
+
+void ComputePipeline::loadShader(const std::string& path) {
+    shaderCode = VkHelper::readFile(path);
+    shader = shaderCode;
+}
+
+void ComputePipeline::setShader(std::span<const char> code) {
+    shaderCode.clear();
+    shader = code;
+}
+
+void ComputePipeline::create(uint32_t storageBuffers, uint32_t pushConstantBytes) {
+    storageBufferCount = storageBuffers;
+    pushConstantSize = pushConstantBytes;
+    VkDevice device = win.device.device;
+    
+    std::vector<VkDescriptorSetLayoutBinding> bindings(storageBuffers);
+    for (uint32_t i = 0; i < storageBuffers; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo{};
+    setLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    setLayoutCreateInfo.bindingCount = bindings.size();
+    setLayoutCreateInfo.pBindings = bindings.data();
+    VkCheck(vkCreateDescriptorSetLayout(device, &setLayoutCreateInfo, nullptr, &setLayout), "vkCreateDescriptorSetLayout (ComputePipeline.cpp)");
+    
+    if (storageBuffers > 0) {
+        VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBuffers};
+        VkDescriptorPoolCreateInfo poolCreateInfo{};
+        poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolCreateInfo.maxSets = 1;
+        poolCreateInfo.poolSizeCount = 1;
+        poolCreateInfo.pPoolSizes = &poolSize;
+        VkCheck(vkCreateDescriptorPool(device, &poolCreateInfo, nullptr, &descriptorPool), "vkCreateDescriptorPool (ComputePipeline.cpp)");
+        
+        VkDescriptorSetAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = descriptorPool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &setLayout;
+        VkCheck(vkAllocateDescriptorSets(device, &allocateInfo, &descriptorSet), "vkAllocateDescriptorSets (ComputePipeline.cpp)");
+    }
+    
+    VkPushConstantRange pushConstantRange{VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantBytes};
+    VkPipelineLayoutCreateInfo layoutCreateInfo{};
+    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    layoutCreateInfo.setLayoutCount = 1;
+    layoutCreateInfo.pSetLayouts = &setLayout;
+    layoutCreateInfo.pushConstantRangeCount = pushConstantBytes > 0 ? 1 : 0;
+    layoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+    VkCheck(vkCreatePipelineLayout(device, &layoutCreateInfo, nullptr, &pipelineLayout), "vkCreatePipelineLayout (ComputePipeline.cpp)");
+    
+    VkShaderModuleCreateInfo moduleCreateInfo{};
+    moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleCreateInfo.codeSize = shader.size();
+    moduleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(shader.data());
+    VkShaderModule shaderModule;
+    VkCheck(vkCreateShaderModule(device, &moduleCreateInfo, nullptr, &shaderModule), "vkCreateShaderModule (ComputePipeline.cpp)");
+    
+    VkComputePipelineCreateInfo pipelineCreateInfo{};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineCreateInfo.stage.module = shaderModule;
+    pipelineCreateInfo.stage.pName = "main";
+    pipelineCreateInfo.layout = pipelineLayout;
+    VkResult result = vkCreateComputePipelines(device, win.pipelineCache.cache, 1, &pipelineCreateInfo, nullptr, &pipeline);
+    vkDestroyShaderModule(device, shaderModule, nullptr);
+    VkCheck(result, "vkCreateComputePipelines (ComputePipeline.cpp)");
+}
+
+void ComputePipeline::setStorageBuffer(uint32_t binding, const Buffer& buffer) {
+    if (binding >= storageBufferCount) throw std::runtime_error("storage buffer binding out of range (ComputePipeline.cpp)");
+    
+    VkDescriptorBufferInfo bufferInfo{buffer.buffer, 0, VK_WHOLE_SIZE};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = binding;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(win.device.device, 1, &write, 0, nullptr);
+}
+
+void ComputePipeline::dispatch(VkCommandBuffer commandBuffer, uint32_t groupsX, uint32_t groupsY, uint32_t groupsZ, const void* pushConstants) const {
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    if (descriptorSet != VK_NULL_HANDLE) vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+    if (pushConstants != nullptr) vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize, pushConstants);
+    vkCmdDispatch(commandBuffer, groupsX, groupsY, groupsZ);
+}
+
+void ComputePipeline::destroy() {
+    win.deletionQueue.retirePipeline(pipeline);
+    win.deletionQueue.retirePipelineLayout(pipelineLayout);
+    win.deletionQueue.retireDescriptorPool(descriptorPool);
+    win.deletionQueue.retireDescriptorSetLayout(setLayout);
+    pipeline = VK_NULL_HANDLE;
+    pipelineLayout = VK_NULL_HANDLE;
+    descriptorPool = VK_NULL_HANDLE;
+    descriptorSet = VK_NULL_HANDLE;
+    setLayout = VK_NULL_HANDLE;
+}
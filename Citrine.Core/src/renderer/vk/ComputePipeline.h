@@ -0,0 +1,42 @@
+#ifndef CITRINE_COMPUTEPIPELINE_H
+#define CITRINE_COMPUTEPIPELINE_H
+
+#include "VkHelper.h"
+#include <vector>
+#include <string>
+#include <span>
+#include "VkWindow.h"
+
+// compute shader reading/writing storage buffers at set 0 (bindings 0..n-1), with an optional push constant block.
+// owns its layouts and one descriptor set. descriptors are written at setup only, a frame in flight may still
+// read the set
+class ComputePipeline {
+private:
+    VkWindow& win;
+    std::vector<char> shaderCode;
+    // the loaded code above or borrowed
+    std::span<const char> shader;
+    uint32_t storageBufferCount = 0;
+    uint32_t pushConstantSize = 0;
+    
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+public:
+    explicit ComputePipeline(VkWindow& window) : win(window) {}
+    
+    void loadShader(const std::string& path);
+    // borrowed (asset pack mapping), only read by create
+    void setShader(std::span<const char> code);
+    // created through the persistent pipeline cache, like graphics pipelines
+    void create(uint32_t storageBuffers, uint32_t pushConstantBytes = 0);
+    // before the first dispatch that reads it
+    void setStorageBuffer(uint32_t binding, const Buffer& buffer);
+    // outside of render passes. pushConstants has to be pushConstantBytes long
+    void dispatch(VkCommandBuffer commandBuffer, uint32_t groupsX, uint32_t groupsY = 1, uint32_t groupsZ = 1, const void* pushConstants = nullptr) const;
+    void destroy();
+};
+
+#endif //CITRINE_COMPUTEPIPELINE_H
@@ -0,0 +1,126 @@
+#include "DeletionQueue.h"
+#include "../../core/Profiler.h"
+
+void DeletionQueue::create(LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, TimelineSemaphore& frameTimeline) {
+    device = logicalDevice.device;
+    allocator = &memoryAllocator;
+    timeline = &frameTimeline;
+    // a swapchain recreation retires a few dozen handles, don't grow during it
+    entries.reserve(64);
+}
+
+void DeletionQueue::destroy() {
+    std::lock_guard lock(mutex);
+    for (auto& entry: entries) destroyEntry(entry);
+    entries.clear();
+}
+
+void DeletionQueue::setFrame(uint64_t frameNumber) {
+    std::lock_guard lock(mutex);
+    frame = frameNumber;
+}
+
+void DeletionQueue::collect() {
+    std::lock_guard lock(mutex);
+    if (entries.empty()) return;
+    CITRINE_PROFILE_SCOPE("collect deletions");
+    
+    uint64_t completed = timeline->completedValue();
+    size_t count = 0;
+    while (count < entries.size() && entries[count].frame + 1 <= completed) destroyEntry(entries[count++]);
+    entries.erase(entries.begin(), entries.begin() + static_cast<ptrdiff_t>(count));
+}
+
+void DeletionQueue::destroyEntry(Entry& entry) {
+    switch (entry.kind) {
+        case Kind::Buffer:
+            vkDestroyBuffer(device, reinterpret_cast<VkBuffer>(entry.handle), nullptr);
+            allocator->free(entry.allocation);
+            break;
+        case Kind::Image:
+            vkDestroyImage(device, reinterpret_cast<VkImage>(entry.handle), nullptr);
+            allocator->free(entry.allocation);
+            break;
+        case Kind::ImageView:
+            vkDestroyImageView(device, reinterpret_cast<VkImageView>(entry.handle), nullptr);
+            break;
+        case Kind::Framebuffer:
+            vkDestroyFramebuffer(device, reinterpret_cast<VkFramebuffer>(entry.handle), nullptr);
+            break;
+        case Kind::Pipeline:
+            vkDestroyPipeline(device, reinterpret_cast<VkPipeline>(entry.handle), nullptr);
+            break;
+        case Kind::PipelineLayout:
+            vkDestroyPipelineLayout(device, reinterpret_cast<VkPipelineLayout>(entry.handle), nullptr);
+            break;
+        case Kind::RenderPass:
+            vkDestroyRenderPass(device, reinterpret_cast<VkRenderPass>(entry.handle), nullptr);
+            break;
+        case Kind::SwapChain:
+            vkDestroySwapchainKHR(device, reinterpret_cast<VkSwapchainKHR>(entry.handle), nullptr);
+            break;
+        case Kind::Sampler:
+            vkDestroySampler(device, reinterpret_cast<VkSampler>(entry.handle), nullptr);
+            break;
+        case Kind::DescriptorPool:
+            vkDestroyDescriptorPool(device, reinterpret_cast<VkDescriptorPool>(entry.handle), nullptr);
+            break;
+        case Kind::DescriptorSetLayout:
+            vkDestroyDescriptorSetLayout(device, reinterpret_cast<VkDescriptorSetLayout>(entry.handle), nullptr);
+            break;
+        case Kind::Memory:
+            allocator->free(entry.allocation);
+            break;
+    }
+}
+
+void DeletionQueue::retireBuffer(Buffer& buffer) {
+    if (buffer.buffer != VK_NULL_HANDLE) push(Kind::Buffer, buffer.buffer, buffer.allocation);
+    buffer = {};
+}
+
+void DeletionQueue::retireImage(Image& image) {
+    if (image.image != VK_NULL_HANDLE) push(Kind::Image, image.image, image.allocation);
+    image = {};
+}
+
+void DeletionQueue::retireImageView(VkImageView view) {
+    if (view != VK_NULL_HANDLE) push(Kind::ImageView, view);
+}
+
+void DeletionQueue::retireFramebuffer(VkFramebuffer framebuffer) {
+    if (framebuffer != VK_NULL_HANDLE) push(Kind::Framebuffer, framebuffer);
+}
+
+void DeletionQueue::retirePipeline(VkPipeline pipeline) {
+    if (pipeline != VK_NULL_HANDLE) push(Kind::Pipeline, pipeline);
+}
+
+void DeletionQueue::retirePipelineLayout(VkPipelineLayout layout) {
+    if (layout != VK_NULL_HANDLE) push(Kind::PipelineLayout, layout);
+}
+
+void DeletionQueue::retireRenderPass(VkRenderPass renderPass) {
+    if (renderPass != VK_NULL_HANDLE) push(Kind::RenderPass, renderPass);
+}
+
+void DeletionQueue::retireSwapChain(VkSwapchainKHR swapChain) {
+    if (swapChain != VK_NULL_HANDLE) push(Kind::SwapChain, swapChain);
+}
+
+void DeletionQueue::retireSampler(VkSampler sampler) {
+    if (sampler != VK_NULL_HANDLE) push(Kind::Sampler, sampler);
+}
+
+void DeletionQueue::retireDescriptorPool(VkDescriptorPool pool) {
+    if (pool != VK_NULL_HANDLE) push(Kind::DescriptorPool, pool);
+}
+
+void DeletionQueue::retireDescriptorSetLayout(VkDescriptorSetLayout layout) {
+    if (layout != VK_NULL_HANDLE) push(Kind::DescriptorSetLayout, layout);
+}
+
+void DeletionQueue::retireMemory(Allocation& allocation) {
+    if (allocation.memory != VK_NULL_HANDLE) push(Kind::Memory, uint64_t{0}, allocation);
+    allocation = {};
+}
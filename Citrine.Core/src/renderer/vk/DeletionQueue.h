@@ -0,0 +1,84 @@
+#ifndef CITRINE_DELETIONQUEUE_H
+#define CITRINE_DELETIONQUEUE_H
+
+#include "VkHelper.h"
+#include <vector>
+#include <mutex>
+#include "LogicalDevice.h"
+#include "MemoryAllocator.h"
+#include "TimelineSemaphore.h"
+
+// destroys gpu resources once the last frame that could use them finished, so nothing has to idle the device.
+// retired objects are tagged with the current frame (see setFrame) and freed by collect() after the frame
+// timeline passed it. retiring is thread safe, collect runs on the frame thread.
+class DeletionQueue {
+private:
+    enum class Kind : uint8_t {
+        Buffer,
+        Image,
+        ImageView,
+        Framebuffer,
+        Pipeline,
+        PipelineLayout,
+        RenderPass,
+        SwapChain,
+        Sampler,
+        DescriptorPool,
+        DescriptorSetLayout,
+        Memory,
+    };
+    
+    struct Entry {
+        uint64_t frame;
+        Kind kind;
+        // non dispatchable handle, 64 bit on every platform
+        uint64_t handle;
+        Allocation allocation;
+    };
+    
+    VkDevice device = VK_NULL_HANDLE;
+    MemoryAllocator* allocator = nullptr;
+    TimelineSemaphore* timeline = nullptr;
+    std::mutex mutex;
+    // ordered by frame, setFrame only moves forward
+    std::vector<Entry> entries;
+    uint64_t frame = 0;
+    
+    template<typename T>
+    void push(Kind kind, T handle, const Allocation& allocation = {}) {
+        std::lock_guard lock(mutex);
+        entries.push_back({frame, kind, reinterpret_cast<uint64_t>(handle), allocation});
+    }
+    void destroyEntry(Entry& entry);
+public:
+    // timeline is the frame timeline: frame N signals N + 1
+    void create(LogicalDevice& logicalDevice, MemoryAllocator& memoryAllocator, TimelineSemaphore& frameTimeline);
+    // frees everything regardless of the gpu, the device has to be idle
+    void destroy();
+    
+    // frame currently recorded (or the next one between frames), objects retired from now on are tagged with it
+    void setFrame(uint64_t frameNumber);
+    // non blocking, frees what the finished frames left behind
+    void collect();
+    
+    void retireBuffer(Buffer& buffer);
+    void retireImage(Image& image);
+    void retireImageView(VkImageView view);
+    void retireFramebuffer(VkFramebuffer framebuffer);
+    void retirePipeline(VkPipeline pipeline);
+    void retirePipelineLayout(VkPipelineLayout layout);
+    void retireRenderPass(VkRenderPass renderPass);
+    void retireSwapChain(VkSwapchainKHR swapChain);
+    void retireSampler(VkSampler sampler);
+    // frees the sets allocated from it as well
+    void retireDescriptorPool(VkDescriptorPool pool);
+    void retireDescriptorSetLayout(VkDescriptorSetLayout layout);
+    void retireMemory(Allocation& allocation);
+    
+    [[nodiscard]] size_t size() {
+        std::lock_guard lock(mutex);
+        return entries.size();
+    }
+};
+
+#endif //CITRINE_DELETIONQUEUE_H
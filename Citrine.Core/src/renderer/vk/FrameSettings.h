@@ -0,0 +1,26 @@
+#ifndef CITRINE_FRAMESETTINGS_H
+#define CITRINE_FRAMESETTINGS_H
+
+#include <cstdint>
+
+// which present mode the swapchain picks, each falls back to FIFO (the only mode every driver has)
+enum class PresentPolicy {
+    // MAILBOX, then IMMEDIATE: newest frame on the next vblank, no tearing when mailbox exists
+    LowLatency,
+    // IMMEDIATE, then MAILBOX: never waits on vblank, may tear
+    Throughput,
+    // FIFO: v-synced, the gpu idles between vblanks
+    PowerSaving,
+};
+
+// frame pacing configuration of a VkWindow, fixed for the lifetime of the window except the present policy
+struct FrameSettings {
+    // frames the cpu may record ahead of the gpu. 1 gives the lowest input latency, 2+ keeps both busy
+    uint32_t framesInFlight = 2;
+    PresentPolicy presentPolicy = PresentPolicy::LowLatency;
+    // begin passes with vkCmdBeginRendering where the device supports it (no render pass/framebuffer objects).
+    // false always uses render pass objects
+    bool dynamicRendering = true;
+};
+
+#endif //CITRINE_FRAMESETTINGS_H
@@ -0,0 +1,163 @@
+#include "GpuProfiler.h"
+#include "../../core/Profiler.h"
+#include <iostream>
+#include <string>
+
+void GpuProfiler::create(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice, uint32_t queueFamily, uint32_t framesInFlight) {
+    device = logicalDevice.device;
+    timestampPeriod = physicalDevice.physicalDeviceProperties.limits.timestampPeriod;
+    
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice.physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice.physicalDevice, &familyCount, families.data());
+    
+    uint32_t validBits = families[queueFamily].timestampValidBits;
+    if (validBits == 0) {
+        std::cout << "gpu profiler disabled, queue family " << queueFamily << " has no timestamp support\n";
+        return;
+    }
+    timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+    // the logical device enables every supported feature
+    statisticsSupported = physicalDevice.physicalDeviceFeatures.pipelineStatisticsQuery;
+    
+    frames.resize(framesInFlight);
+    for (auto& frame: frames) {
+        VkQueryPoolCreateInfo timestampCreateInfo{};
+        timestampCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        timestampCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        timestampCreateInfo.queryCount = maxScopes * 2;
+        VkCheck(vkCreateQueryPool(device, &timestampCreateInfo, nullptr, &frame.timestamps), "vkCreateQueryPool#1 (GpuProfiler.cpp)");
+        
+        if (statisticsSupported) {
+            VkQueryPoolCreateInfo statisticsCreateInfo{};
+            statisticsCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            statisticsCreateInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            statisticsCreateInfo.queryCount = maxStatisticsScopes;
+            statisticsCreateInfo.pipelineStatistics = statisticFlags;
+            VkCheck(vkCreateQueryPool(device, &statisticsCreateInfo, nullptr, &frame.statistics), "vkCreateQueryPool#2 (GpuProfiler.cpp)");
+        }
+        frame.scopes.reserve(maxScopes);
+    }
+    timestampData.resize(maxScopes * 2);
+    lastResults.reserve(maxScopes);
+    enabled = true;
+}
+
+void GpuProfiler::destroy() {
+    for (auto& frame: frames) {
+        vkDestroyQueryPool(device, frame.timestamps, nullptr);
+        if (frame.statistics != VK_NULL_HANDLE) vkDestroyQueryPool(device, frame.statistics, nullptr);
+    }
+    frames.clear();
+    enabled = false;
+}
+
+void GpuProfiler::collect(FrameQueries& frame) {
+    uint32_t queryCount = frame.scopes.size() * 2;
+    if (queryCount == 0) return;
+    
+    // the frame's timeline value was waited on, so everything is available. VK_NOT_READY only if a scope was never ended
+    VkResult result = vkGetQueryPoolResults(device, frame.timestamps, 0, queryCount, queryCount * sizeof(uint64_t), timestampData.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result == VK_NOT_READY) return;
+    VkCheck(result, "vkGetQueryPoolResults#1 (GpuProfiler.cpp)");
+    
+    PipelineStatistics statistics[maxStatisticsScopes];
+    if (frame.statisticsUsed > 0) {
+        result = vkGetQueryPoolResults(device, frame.statistics, 0, frame.statisticsUsed, sizeof(statistics), statistics, sizeof(PipelineStatistics), VK_QUERY_RESULT_64_BIT);
+        if (result == VK_NOT_READY) return;
+        VkCheck(result, "vkGetQueryPoolResults#2 (GpuProfiler.cpp)");
+    }
+    
+    lastResults.clear();
+    for (uint32_t i = 0; i < frame.scopes.size(); ++i) {
+        const Scope& scope = frame.scopes[i];
+        uint64_t begin = timestampData[i * 2] & timestampMask;
+        uint64_t end = timestampData[i * 2 + 1] & timestampMask;
+        
+        GpuScopeResult scopeResult{};
+        scopeResult.name = scope.name;
+        scopeResult.depth = scope.depth;
+        // timestampPeriod is nanoseconds per tick, the mask handles wrap around of narrow counters
+        scopeResult.milliseconds = static_cast<double>((end - begin) & timestampMask) * timestampPeriod / 1e6;
+        if (scope.statisticsQuery != UINT32_MAX) {
+            scopeResult.hasStatistics = true;
+            scopeResult.statistics = statistics[scope.statisticsQuery];
+        }
+        lastResults.push_back(scopeResult);
+        
+#ifdef CITRINE_PROFILING
+        // offsets from the start of the frame's command buffer (scope 0), the cpu trace anchors them at the submit
+        uint64_t frameBegin = timestampData[0] & timestampMask;
+        auto toNanoseconds = [&](uint64_t ticks) { return static_cast<uint64_t>(static_cast<double>((ticks - frameBegin) & timestampMask) * timestampPeriod); };
+        CITRINE_PROFILE_GPU(scope.name, frame.frameNumber, toNanoseconds(begin), toNanoseconds(end));
+#endif
+    }
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber) {
+    if (!enabled) return;
+    
+    current = &frames[frameIndex];
+    if (current->submitted) collect(*current);
+    
+    current->scopes.clear();
+    current->statisticsUsed = 0;
+    current->submitted = false;
+    current->frameNumber = frameNumber;
+    depth = 0;
+    statisticsActive = false;
+    
+    // queries have to be reset outside of a render pass before use, the start of the frame is the only such place
+    vkCmdResetQueryPool(commandBuffer, current->timestamps, 0, maxScopes * 2);
+    if (current->statistics != VK_NULL_HANDLE) vkCmdResetQueryPool(commandBuffer, current->statistics, 0, maxStatisticsScopes);
+    
+    frameScope = beginScope(commandBuffer, "frame");
+}
+
+void GpuProfiler::endFrame(VkCommandBuffer commandBuffer) {
+    if (!enabled || !current) return;
+    endScope(commandBuffer, frameScope);
+    current->submitted = true;
+    current = nullptr;
+}
+
+uint32_t GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name, bool statistics) {
+    if (!enabled || !current || current->scopes.size() == maxScopes) return UINT32_MAX;
+    
+    uint32_t scope = current->scopes.size();
+    uint32_t statisticsQuery = UINT32_MAX;
+    if (statistics && statisticsSupported && !statisticsActive && current->statisticsUsed < maxStatisticsScopes) {
+        statisticsQuery = current->statisticsUsed++;
+        statisticsActive = true;
+        vkCmdBeginQuery(commandBuffer, current->statistics, statisticsQuery, 0);
+    }
+    
+    current->scopes.push_back({name, depth++, statisticsQuery});
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, current->timestamps, scope * 2);
+    return scope;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+    if (!enabled || !current || scope == UINT32_MAX) return;
+    
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, current->timestamps, scope * 2 + 1);
+    uint32_t statisticsQuery = current->scopes[scope].statisticsQuery;
+    if (statisticsQuery != UINT32_MAX) {
+        vkCmdEndQuery(commandBuffer, current->statistics, statisticsQuery);
+        statisticsActive = false;
+    }
+    depth--;
+}
+
+void GpuProfiler::printResults() const {
+    for (const auto& result: lastResults) {
+        std::cout << std::string(result.depth * 2, ' ') << result.name << ": " << result.milliseconds << "ms";
+        if (result.hasStatistics) {
+            std::cout << " (vertices " << result.statistics.inputVertices << ", primitives " << result.statistics.inputPrimitives
+                      << ", vs " << result.statistics.vertexInvocations << ", clipped " << result.statistics.clippingPrimitives
+                      << ", fs " << result.statistics.fragmentInvocations << ")";
+        }
+        std::cout << "\n";
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef CITRINE_GPUPROFILER_H
+#define CITRINE_GPUPROFILER_H
+
+#include "VkHelper.h"
+#include <vector>
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+
+// subset of VK_QUERY_PIPELINE_STATISTIC_*, in bit order (the order vkGetQueryPoolResults writes them)
+struct PipelineStatistics {
+    uint64_t inputVertices = 0;
+    uint64_t inputPrimitives = 0;
+    uint64_t vertexInvocations = 0;
+    uint64_t clippingPrimitives = 0;
+    uint64_t fragmentInvocations = 0;
+};
+
+struct GpuScopeResult {
+    const char* name = nullptr;
+    uint32_t depth = 0;
+    double milliseconds = 0;
+    bool hasStatistics = false;
+    PipelineStatistics statistics{};
+};
+
+// named gpu time scopes per frame, from timestamp queries (and optionally pipeline statistics queries).
+// every frame in flight owns its query pools, they are read back when the frame slot comes around again,
+// i.e. after its timeline value was waited on, so reading never stalls. frame thread only.
+class GpuProfiler {
+private:
+    static constexpr uint32_t maxScopes = 64;
+    static constexpr uint32_t maxStatisticsScopes = 8;
+    static constexpr VkQueryPipelineStatisticFlags statisticFlags =
+            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+    struct Scope {
+        const char* name;
+        uint32_t depth;
+        // statistics query index or UINT32_MAX
+        uint32_t statisticsQuery;
+    };
+
+    struct FrameQueries {
+        VkQueryPool timestamps = VK_NULL_HANDLE;
+        VkQueryPool statistics = VK_NULL_HANDLE;
+        std::vector<Scope> scopes;
+        uint32_t statisticsUsed = 0;
+        uint64_t frameNumber = 0;
+        bool submitted = false;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    double timestampPeriod = 1;
+    uint64_t timestampMask = ~0ull;
+    bool statisticsSupported = false;
+
+    std::vector<FrameQueries> frames;
+    FrameQueries* current = nullptr;
+    uint32_t depth = 0;
+    // only one statistics query of a pool can be active at a time, nested requests get timestamps only
+    bool statisticsActive = false;
+    uint32_t frameScope = UINT32_MAX;
+
+    std::vector<uint64_t> timestampData;
+    std::vector<GpuScopeResult> lastResults;
+
+    void collect(FrameQueries& frame);
+public:
+    bool enabled = false;
+
+    void create(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice, uint32_t queueFamily, uint32_t framesInFlight);
+    void destroy();
+
+    // call right after the command buffer of the frame slot began, reads back the slot's previous results.
+    // frameNumber correlates the results with the cpu trace
+    void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber);
+    // call before the command buffer ends
+    void endFrame(VkCommandBuffer commandBuffer);
+
+    // scopes nest. statistics scopes have to begin and end on the same side of a render pass boundary and must
+    // not contain vkCmdExecuteCommands (no inheritedQueries). name is kept as is, pass a literal.
+    // returns UINT32_MAX when out of queries
+    uint32_t beginScope(VkCommandBuffer commandBuffer, const char* name, bool statistics = false);
+    void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+    // scopes of the most recently completed frame, in begin order
+    [[nodiscard]] const std::vector<GpuScopeResult>& results() const { return lastResults; }
+    void printResults() const;
+};
+
+#endif //CITRINE_GPUPROFILER_H
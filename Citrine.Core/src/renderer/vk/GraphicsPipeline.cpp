@@ -1,200 +1,201 @@
 #include "GraphicsPipeline.h"
 
 
-std::vector<char> GraphicsPipeline::readFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::ate | std::ios::binary);
-    if (!file.is_open()) throw std::runtime_error("failed to open file '" + filename + "'");
-    
-    size_t size = file.tellg();
-    std::vector<char> buffer(size);
-    
-    file.seekg(0);
-    file.read(buffer.data(), (std::streamsize) size);
-    
-    file.close();
-    return buffer;
-}
-
 void GraphicsPipeline::loadVertexShader(const std::string& path) {
-    vertexShaderCode = readFile(path);
+    vertexShaderCode = VkHelper::readFile(path);
+    vertexShader = vertexShaderCode;
 }
 
 void GraphicsPipeline::loadFragmentShader(const std::string& path) {
-    fragmentShaderCode = readFile(path);
+    fragmentShaderCode = VkHelper::readFile(path);
+    fragmentShader = fragmentShaderCode;
 }
 
-VkShaderModule GraphicsPipeline::createShaderModule(const std::vector<char>& src) const {
-    VkShaderModuleCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    createInfo.codeSize = src.size();
-    createInfo.pCode = reinterpret_cast<const uint32_t*>(src.data());
+void GraphicsPipeline::setVertexShader(std::span<const char> code) {
+    vertexShaderCode.clear();
+    vertexShader = code;
+}
 
-    VkShaderModule shaderModule;
-    VkCheck(vkCreateShaderModule(win.device.device, &createInfo, nullptr, &shaderModule), "vkCreateShaderModule (GraphicsPipeline.cpp)")
-    return shaderModule;
+void GraphicsPipeline::setFragmentShader(std::span<const char> code) {
+    fragmentShaderCode.clear();
+    fragmentShader = code;
 }
 
-void GraphicsPipeline::createPipeline(VkRenderPass renderPass) {
-    
-    
-    VkBufferCreateInfo bufferCreateInfo{};
-    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferCreateInfo.size = sizeof(vertices[0]) * vertices.size();
-    bufferCreateInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    VkCheck(vkCreateBuffer(win.device.device, &bufferCreateInfo, nullptr, &vertexBuffer), "dasd");
-
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(win.device.device, vertexBuffer, &memRequirements);
-    
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    
-    VkCheck(vkAllocateMemory(win.device.device, &allocInfo, nullptr, &vertexBufferMem), "amogus");
-    vkBindBufferMemory(win.device.device, vertexBuffer, vertexBufferMem, 0);
-    
-    void* data;
-    vkMapMemory(win.device.device, vertexBufferMem, 0, bufferCreateInfo.size, 0, &data);
-    memcpy(data, vertices.data(), bufferCreateInfo.size);
-    vkUnmapMemory(win.device.device, vertexBufferMem);
-    
-    
-    
-    
-    
-    vertexShader = createShaderModule(vertexShaderCode);
-    fragmentShader = createShaderModule(fragmentShaderCode);
-    
-    VkPipelineShaderStageCreateInfo vertCreateInfo{};
-    vertCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertCreateInfo.module = vertexShader;
-    vertCreateInfo.pName = "main";
-
-    VkPipelineShaderStageCreateInfo fragCreateInfo{};
-    fragCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragCreateInfo.module = fragmentShader;
-    fragCreateInfo.pName = "main";
-    
-    auto binding = Vertex::getBindingDescription();
-    auto attributes = Vertex::getAttributeDescriptions();
-    
-    VkPipelineVertexInputStateCreateInfo vertInputCreateInfo{};
-    vertInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertInputCreateInfo.vertexBindingDescriptionCount = 1;
-    vertInputCreateInfo.pVertexBindingDescriptions = &binding;
-    vertInputCreateInfo.vertexAttributeDescriptionCount = attributes.size();
-    vertInputCreateInfo.pVertexAttributeDescriptions = attributes.data();
-    
-    VkPipelineInputAssemblyStateCreateInfo inputAsmCreateInfo{};
-    inputAsmCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    inputAsmCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    inputAsmCreateInfo.primitiveRestartEnable = false;
-    
-    VkViewport viewport{};
-    viewport.x = 0;
-    viewport.y = 0;
-    viewport.width = static_cast<float>(win.swapChain.swapExtent.width);
-    viewport.height = static_cast<float>(win.swapChain.swapExtent.height);
-    viewport.minDepth = 0;
-    viewport.maxDepth = 1;
-    
-    VkRect2D scissor{};
-    scissor.offset = {0,0};
-    scissor.extent = win.swapChain.swapExtent;
-    
-    VkPipelineViewportStateCreateInfo viewportCreateInfo{};
-    viewportCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportCreateInfo.viewportCount = 1;
-    viewportCreateInfo.pViewports = &viewport;
-    viewportCreateInfo.scissorCount = 1;
-    viewportCreateInfo.pScissors = &scissor;
-    
-    VkPipelineRasterizationStateCreateInfo rasterizerCreateInfo{};
-    rasterizerCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    rasterizerCreateInfo.depthClampEnable = false;
-    rasterizerCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
-    rasterizerCreateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
-    rasterizerCreateInfo.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    rasterizerCreateInfo.depthBiasEnable = false;
-    
-    VkPipelineMultisampleStateCreateInfo multisampleCreateInfo{};
-    multisampleCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    multisampleCreateInfo.sampleShadingEnable = false;
-    multisampleCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+void GraphicsPipeline::createVertexBuffer() {
+    const Vertex vertices[] = {
+            {{-.5f,.5f,0}, {1,1,0}},
+            {{0,-.5f,0}, {1,0,1}},
+            {{.5f,.5f,0}, {0,1,1}},
+    };
+    const uint32_t indices[] = {0, 1, 2};
+    mesh.create(win.uploader, vertices, indices);
+}
 
-    //VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo{};
-    
-    VkPipelineColorBlendAttachmentState colorBlendCreateInfo{};
-    colorBlendCreateInfo.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    colorBlendCreateInfo.blendEnable = false;
-    colorBlendCreateInfo.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-    colorBlendCreateInfo.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    colorBlendCreateInfo.colorBlendOp = VK_BLEND_OP_ADD;
-    colorBlendCreateInfo.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-    colorBlendCreateInfo.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-    colorBlendCreateInfo.alphaBlendOp = VK_BLEND_OP_ADD;
-    
-    VkPipelineColorBlendStateCreateInfo colorBlendingCreateInfo{};
-    colorBlendingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    colorBlendingCreateInfo.logicOpEnable = false;
-    colorBlendingCreateInfo.attachmentCount = 1;
-    colorBlendingCreateInfo.pAttachments = &colorBlendCreateInfo;
-    
-    VkPipelineLayoutCreateInfo layoutCreateInfo{};
-    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+void GraphicsPipeline::destroyVertexBuffer() {
+    mesh.destroy(win.deletionQueue);
+}
 
-    VkCheck(vkCreatePipelineLayout(win.device.device, &layoutCreateInfo, nullptr, &pipelineLayout), "vkCreatePipelineLayout (GraphicsPipeline.cpp)");
+void GraphicsPipeline::createTextureSet(uint32_t count) {
+    description.textureCount = count;
+    textures.assign(count, nullptr);
+    VkDevice device = win.device.device;
+    
+    VkDescriptorPoolSize poolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, count};
+    VkDescriptorPoolCreateInfo poolCreateInfo{};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolCreateInfo.maxSets = 1;
+    poolCreateInfo.poolSizeCount = 1;
+    poolCreateInfo.pPoolSizes = &poolSize;
+    VkCheck(vkCreateDescriptorPool(device, &poolCreateInfo, nullptr, &descriptorPool), "vkCreateDescriptorPool (GraphicsPipeline.cpp)");
+    
+    // the registry's layout, the pipelines it builds for this texture count are compatible with the set
+    VkDescriptorSetLayout setLayout = win.pipelines.textureSetLayout(count);
+    VkDescriptorSetAllocateInfo allocateInfo{};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocateInfo.descriptorPool = descriptorPool;
+    allocateInfo.descriptorSetCount = 1;
+    allocateInfo.pSetLayouts = &setLayout;
+    VkCheck(vkAllocateDescriptorSets(device, &allocateInfo, &descriptorSet), "vkAllocateDescriptorSets (GraphicsPipeline.cpp)");
+}
 
-    VkPipelineShaderStageCreateInfo stages[] = {vertCreateInfo, fragCreateInfo};
-    
-    VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
-    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineCreateInfo.stageCount = 2;
-    pipelineCreateInfo.pStages = stages;
-    pipelineCreateInfo.pVertexInputState = &vertInputCreateInfo;
-    pipelineCreateInfo.pInputAssemblyState = &inputAsmCreateInfo;
-    pipelineCreateInfo.pViewportState = &viewportCreateInfo;
-    pipelineCreateInfo.pRasterizationState = &rasterizerCreateInfo;
-    pipelineCreateInfo.pMultisampleState = &multisampleCreateInfo;
-    pipelineCreateInfo.pDepthStencilState = nullptr;
-    pipelineCreateInfo.pColorBlendState = &colorBlendingCreateInfo;
-    pipelineCreateInfo.pDynamicState = nullptr;
-    
-    pipelineCreateInfo.layout = pipelineLayout;
-    pipelineCreateInfo.renderPass = renderPass;
-    pipelineCreateInfo.subpass = 0;
+void GraphicsPipeline::destroyTextureSet() {
+    win.deletionQueue.retireDescriptorPool(descriptorPool);
+    descriptorPool = VK_NULL_HANDLE;
+    descriptorSet = VK_NULL_HANDLE;
+    textures.clear();
+}
 
-    VkCheck(vkCreateGraphicsPipelines(win.device.device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nullptr, &graphicsPipeline), "vkCreateGraphicsPipelines (GraphicsPipeline.cs)");
-   
-    vkDestroyShaderModule(win.device.device, vertexShader, nullptr);
-    vkDestroyShaderModule(win.device.device, fragmentShader, nullptr);
-    currentRenderPass = renderPass;
+void GraphicsPipeline::setTexture(uint32_t binding, const Texture& texture, VkSampler sampler) {
+    if (binding >= textures.size()) throw std::runtime_error("texture binding out of range (GraphicsPipeline.cpp)");
+    textures[binding] = &texture;
+    
+    VkDescriptorImageInfo imageInfo{sampler, texture.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = descriptorSet;
+    write.dstBinding = binding;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &imageInfo;
+    vkUpdateDescriptorSets(win.device.device, 1, &write, 0, nullptr);
 }
 
-void GraphicsPipeline::destroyPipeline() {
-    vkDestroyBuffer(win.device.device, vertexBuffer, nullptr);
-    vkFreeMemory(win.device.device, vertexBufferMem, nullptr);
-    
+void GraphicsPipeline::createPipeline(const RenderPass& renderPass, bool async) {
+    description.renderPass = renderPass.renderPass;
+    description.renderPassKey = renderPass.compatibilityKey;
+    if (renderPass.dynamicRendering) description.colorFormats.assign(1, renderPass.colorFormat);
+    else description.colorFormats.clear();
+    description.depthFormat = VK_FORMAT_UNDEFINED;
+    acquirePipeline(async);
+    currentRenderPass = &renderPass;
+}
+
+void GraphicsPipeline::createPipeline(VkRenderPass renderPass, uint64_t compatibilityKey, bool async) {
+    description.renderPass = renderPass;
+    description.renderPassKey = compatibilityKey;
+    description.colorFormats.clear();
+    description.depthFormat = VK_FORMAT_UNDEFINED;
+    acquirePipeline(async);
+}
+
+void GraphicsPipeline::createPipeline(const RenderGraph& graph, RenderGraphPass pass, bool async) {
+    description.renderPass = graph.renderPass(pass);
+    description.renderPassKey = graph.compatibilityKey(pass);
+    // render pass objects already carry the formats, keep the description equal to RenderPass' so the pipeline is shared
+    if (description.renderPass == VK_NULL_HANDLE) {
+        description.colorFormats = graph.colorFormats(pass);
+        description.depthFormat = graph.depthFormat(pass);
+    } else {
+        description.colorFormats.clear();
+        description.depthFormat = VK_FORMAT_UNDEFINED;
+    }
+    acquirePipeline(async);
+    currentGraph = &graph;
+    currentGraphPass = pass;
+}
+
+void GraphicsPipeline::acquirePipeline(bool async) {
+    description.vertexShaderCode = vertexShader;
+    description.fragmentShaderCode = fragmentShader;
+    
+    description.bindings.assign(1, vertexBinding);
+    description.attributes = vertexAttributes;
+    if (instanced) {
+        auto instanceAttributes = InstanceData::getAttributeDescriptions();
+        description.bindings.push_back(InstanceData::getBindingDescription());
+        description.attributes.insert(description.attributes.end(), instanceAttributes.begin(), instanceAttributes.end());
+    }
+    
+    // identical descriptions share one VkPipeline, created through the persistent pipeline cache
+    PipelineEntry entry = async ? win.pipelines.acquireAsync(description, pipelineKey) : win.pipelines.acquire(description, pipelineKey);
+    graphicsPipeline = entry.pipeline;
+    pipelineLayout = entry.layout;
+    currentRenderPass = nullptr;
+    currentGraph = nullptr;
+}
+
+bool GraphicsPipeline::resolvePipeline() {
+    if (graphicsPipeline != VK_NULL_HANDLE) return true;
     
-    vkDestroyPipeline(win.device.device, graphicsPipeline, nullptr);
-    vkDestroyPipelineLayout(win.device.device, pipelineLayout, nullptr);
+    PipelineEntry entry{};
+    if (!win.pipelines.tryGet(pipelineKey, entry)) return false;
+    graphicsPipeline = entry.pipeline;
+    pipelineLayout = entry.layout;
+    return true;
+}
+
+void GraphicsPipeline::destroyPipeline() {
+    win.pipelines.release(pipelineKey);
+    graphicsPipeline = VK_NULL_HANDLE;
+    pipelineLayout = VK_NULL_HANDLE;
 }
 
 void GraphicsPipeline::bindPipeline() {
-    vkCmdBindPipeline(win.commandPool.currentCommandBuffer().vk, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+    prepare();
+    record(win.commandPool.currentCommandBuffer().vk);
+}
+
+bool GraphicsPipeline::prepare() {
+    drawPipeline = VK_NULL_HANDLE;
+    
+    // vertex data is still in flight on the transfer queue, skip the draw instead of waiting for it
+    if (!mesh.isReady(win.uploader)) return false;
+    for (const Texture* texture: textures) {
+        if (texture == nullptr || !texture->isReady()) return false;
+    }
+    
+    // pipeline still compiling: draw with the fallback if there is a ready one, otherwise skip
+    if (resolvePipeline()) {
+        drawPipeline = graphicsPipeline;
+        drawLayout = pipelineLayout;
+        drawSet = descriptorSet;
+    }
+    else if (fallback != nullptr && fallback->resolvePipeline()) {
+        drawPipeline = fallback->graphicsPipeline;
+        drawLayout = fallback->pipelineLayout;
+        drawSet = fallback->descriptorSet;
+    }
+    return drawPipeline != VK_NULL_HANDLE;
+}
+
+void GraphicsPipeline::record(VkCommandBuffer commandBuffer) const {
+    if (drawPipeline == VK_NULL_HANDLE) return;
     
-    VkBuffer vbo[] = {vertexBuffer};
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(win.commandPool.currentCommandBuffer().vk, 0, 1, vbo, offsets);
-    vkCmdDraw(win.commandPool.currentCommandBuffer().vk, vertices.size(), 1, 0, 0);
+    bind(commandBuffer);
+    mesh.bind(commandBuffer);
+    mesh.draw(commandBuffer);
+}
+
+void GraphicsPipeline::bind(VkCommandBuffer commandBuffer) const {
+    if (drawPipeline == VK_NULL_HANDLE) return;
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawPipeline);
+    if (drawSet != VK_NULL_HANDLE) vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, drawLayout, 0, 1, &drawSet, 0, nullptr);
 }
 
 void GraphicsPipeline::recreatePipeline() {
     destroyPipeline();
-    createPipeline(currentRenderPass);
+    if (currentRenderPass != nullptr) createPipeline(*currentRenderPass);
+    else if (currentGraph != nullptr) createPipeline(*currentGraph, currentGraphPass);
+    else createPipeline(description.renderPass, description.renderPassKey);
 }
 
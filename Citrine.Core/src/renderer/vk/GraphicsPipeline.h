@@ -7,81 +7,97 @@
 #include <vulkan/vulkan.h>
 #include "VkWindow.h"
 #include "VkHelper.h"
-#include <array>
-#include <glm/glm.hpp>
-
-struct Vertex {
-    glm::vec3 pos;
-    glm::vec3 col;
-
-    static VkVertexInputBindingDescription getBindingDescription() {
-        VkVertexInputBindingDescription description{};
-        description.binding = 0;
-        description.stride = sizeof(Vertex);
-        description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-        return description;
-    }
-
-    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 2> description{};
-
-        description[0].binding = 0;
-        description[0].location = 0;
-        description[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-        description[0].offset = offsetof(Vertex, pos);
-
-        description[1].binding = 0;
-        description[1].location = 1;
-        description[1].format = VK_FORMAT_R32G32B32_SFLOAT;
-        description[1].offset = offsetof(Vertex, col);
-
-        return description;
-    }
-};
+#include "RenderPass.h"
+#include "RenderGraph.h"
+#include "PipelineRegistry.h"
+#include "Vertex.h"
+#include "Mesh.h"
+#include "Texture.h"
 
 class GraphicsPipeline {
 private:
     std::vector<char> vertexShaderCode;
     std::vector<char> fragmentShaderCode;
+    // what the pipeline is created from, the loaded code above or borrowed (asset pack mapping)
+    std::span<const char> vertexShader;
+    std::span<const char> fragmentShader;
     std::vector<char> geometryShaderCode;
     std::vector<char> tesselationShaderCode;
     VkWindow& win;
-    VkRenderPass currentRenderPass;
+    // what recreatePipeline creates the pipeline for again, the raw render pass overload keeps it in description
+    const RenderPass* currentRenderPass = nullptr;
+    const RenderGraph* currentGraph = nullptr;
+    RenderGraphPass currentGraphPass = 0;
     
-    VkShaderModule vertexShader;
-    VkShaderModule fragmentShader;
-    VkPipelineLayout pipelineLayout;
+    PipelineDescription description;
+    uint64_t pipelineKey = 0;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
     
-    VkPipeline graphicsPipeline;
+    VkPipeline graphicsPipeline = VK_NULL_HANDLE;
+    // bound instead while the own pipeline is still compiling, must use the same vertex layout
+    GraphicsPipeline* fallback = nullptr;
+    VkPipeline drawPipeline = VK_NULL_HANDLE;
+    // layout and texture set that go with drawPipeline
+    VkPipelineLayout drawLayout = VK_NULL_HANDLE;
+    VkDescriptorSet drawSet = VK_NULL_HANDLE;
+    // second vertex binding with InstanceData, drawn through InstanceBatcher
+    bool instanced = false;
+    // binding 0, see setVertexLayout
+    VkVertexInputBindingDescription vertexBinding{};
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes;
     
-    VkBuffer vertexBuffer;
-    VkDeviceMemory vertexBufferMem;
-
-    std::vector<Vertex> vertices = {
-            {{-.5f,.5f,0}, {1,1,0}},
-            {{0,-.5f,0}, {1,0,1}},
-            {{.5f,.5f,0}, {0,1,1}},
-    };
+    // what record draws, indexed
+    Mesh mesh;
     
-    [[nodiscard]] VkShaderModule createShaderModule(const std::vector<char>& src) const;
-    static std::vector<char> readFile(const std::string& filename);
-public:
-    explicit GraphicsPipeline(VkWindow& window) : win(window) {}
+    // set 0, see createTextureSet. written at setup only, frames in flight may still read it
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    std::vector<const Texture*> textures;
     
-    [[nodiscard]] uint32_t findMemoryType(uint32_t filter, VkMemoryPropertyFlags flags) const {
-        VkPhysicalDeviceMemoryProperties memProperties;
-        vkGetPhysicalDeviceMemoryProperties(win.physicalDevice.physicalDevice, &memProperties);
-
-        for (int i = 0; i < memProperties.memoryTypeCount; ++i) {
-            if ((filter & (1<<i)) && (memProperties.memoryTypes[i].propertyFlags & flags) == flags) return i;
-        }
-        throw std::runtime_error("failed to find suitable memory type");
-    }
+    // acquires the pipeline for the render target already set in description
+    void acquirePipeline(bool async);
+    bool resolvePipeline();
+public:
+    explicit GraphicsPipeline(VkWindow& window) : win(window) { setVertexLayout<Vertex>(); }
     
     void loadVertexShader(const std::string& path);
     void loadFragmentShader(const std::string& path);
-    void createPipeline(VkRenderPass renderPass);
+    // borrowed, has to outlive the pipeline (recreatePipeline builds from it again)
+    void setVertexShader(std::span<const char> code);
+    void setFragmentShader(std::span<const char> code);
+    void createVertexBuffer();
+    void destroyVertexBuffer();
+    // async: compiled as a job, draws go to the fallback (or are skipped) until it is ready
+    void createPipeline(const RenderPass& renderPass, bool async = false);
+    // for render pass objects owned by someone else, compatibilityKey as in PipelineDescription::renderPassKey
+    void createPipeline(VkRenderPass renderPass, uint64_t compatibilityKey, bool async = false);
+    // for a compiled graph pass, works with and without dynamic rendering
+    void createPipeline(const RenderGraph& graph, RenderGraphPass pass, bool async = false);
+    void setFallback(GraphicsPipeline* pipeline) { fallback = pipeline; }
+    // before createPipeline. the vertex shader has to read InstanceData (shaders/instanced)
+    void setInstanced(bool enabled) { instanced = enabled; }
+    [[nodiscard]] bool isInstanced() const { return instanced; }
+    // before createPipeline, the vertex type of the meshes drawn with it (anything with a VertexLayout), Vertex by default
+    template<typename V>
+    void setVertexLayout() {
+        vertexBinding = V::Layout::binding(0);
+        auto attributes = V::Layout::attributes(0);
+        vertexAttributes.assign(attributes.begin(), attributes.end());
+    }
+    // before createPipeline: the fragment shader samples count textures (set 0, bindings 0..count - 1)
+    void createTextureSet(uint32_t count);
+    void destroyTextureSet();
+    // after createTextureSet, the texture has to outlive the pipeline. draws are skipped until every texture is ready
+    // (Texture::prepare). sampler from win.samplers
+    void setTexture(uint32_t binding, const Texture& texture, VkSampler sampler);
+    [[nodiscard]] bool isReady() { return resolvePipeline(); }
     void bindPipeline();
+    // resolves what to draw this frame (own pipeline, fallback or nothing), call on the frame thread before record
+    bool prepare();
+    // binds and draws into any command buffer (primary or secondary), read only so recording threads can share it
+    void record(VkCommandBuffer commandBuffer) const;
+    // only binds what prepare resolved, the caller binds vertex buffers and draws
+    void bind(VkCommandBuffer commandBuffer) const;
     void destroyPipeline();
     void recreatePipeline();
 };
@@ -0,0 +1,101 @@
+#include "IndirectScene.h"
+
+void IndirectScene::add(const InstanceData& instance, glm::vec3 center, float radius) {
+    objects.push_back({glm::vec4(center, radius), 0, 0, 0, 0});
+    instances.push_back(instance);
+}
+
+void IndirectScene::build(const Mesh& sceneMesh) {
+    if (!sceneMesh.isIndexed()) throw std::runtime_error("indirect scenes draw indexed meshes only (IndirectScene.cpp)");
+    releaseBuffers();
+    mesh = &sceneMesh;
+    builtCount = objects.size();
+    if (builtCount == 0) return;
+    
+    for (Object& object: objects) object.indexCount = mesh->indexCount;
+    // the count buffer variant takes a single maxDrawCount, beyond the limit draw() splits into several calls
+    compact = win.device.drawIndirectCount && builtCount <= win.physicalDevice.physicalDeviceProperties.limits.maxDrawIndirectCount;
+    
+    objectBuffer = win.uploader.createDeviceBuffer(objects.size() * sizeof(Object), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    instanceBuffer = win.uploader.createDeviceBuffer(instances.size() * sizeof(InstanceData), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+    win.uploader.upload(objectBuffer, 0, objects.data(), objects.size() * sizeof(Object));
+    uploadTicket = win.uploader.upload(instanceBuffer, 0, instances.data(), instances.size() * sizeof(InstanceData));
+    
+    drawCommands = win.allocator.createBuffer(builtCount * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    drawCount = win.allocator.createBuffer(sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    
+    // the descriptor set can't change under frames in flight, a rebuild gets a new one
+    if (cullShader.empty()) cullPipeline.loadShader("shaders/cull/comp.spv");
+    else cullPipeline.setShader(cullShader);
+    cullPipeline.create(3, sizeof(CullConstants));
+    cullPipeline.setStorageBuffer(0, objectBuffer);
+    cullPipeline.setStorageBuffer(1, drawCommands);
+    cullPipeline.setStorageBuffer(2, drawCount);
+}
+
+void IndirectScene::cull(VkCommandBuffer commandBuffer, const Frustum& frustum) {
+    culled = false;
+    if (builtCount == 0 || !mesh->isReady(win.uploader) || !win.uploader.isComplete(uploadTicket)) return;
+    CITRINE_PROFILE_SCOPE("gpu culling");
+    uint32_t scope = win.profiler.beginScope(commandBuffer, "cull");
+    
+    // the previous frame's draws read the commands this frame overwrites
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+    
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    if (compact) {
+        vkCmdFillBuffer(commandBuffer, drawCount.buffer, 0, sizeof(uint32_t), 0);
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+    
+    CullConstants constants{};
+    for (uint32_t i = 0; i < 6; ++i) constants.planes[i] = frustum.planes[i];
+    constants.objectCount = builtCount;
+    constants.compact = compact;
+    cullPipeline.dispatch(commandBuffer, (builtCount + groupSize - 1) / groupSize, 1, 1, &constants);
+    
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    win.profiler.endScope(commandBuffer, scope);
+    culled = true;
+}
+
+void IndirectScene::draw(VkCommandBuffer commandBuffer, GraphicsPipeline& pipeline) {
+    if (!culled || !pipeline.prepare()) return;
+    pipeline.bind(commandBuffer);
+    mesh->bind(commandBuffer);
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, InstanceData::binding, 1, &instanceBuffer.buffer, &offset);
+    
+    uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    if (compact) {
+        win.device.cmdDrawIndexedIndirectCount(commandBuffer, drawCommands.buffer, 0, drawCount.buffer, 0, builtCount, stride);
+        return;
+    }
+    // maxDrawIndirectCount is 1 without multiDrawIndirect, only then the draw calls scale with the object count
+    uint32_t maxDraws = win.physicalDevice.physicalDeviceProperties.limits.maxDrawIndirectCount;
+    for (uint32_t first = 0; first < builtCount; first += maxDraws) {
+        vkCmdDrawIndexedIndirect(commandBuffer, drawCommands.buffer, static_cast<VkDeviceSize>(first) * stride, std::min(maxDraws, builtCount - first), stride);
+    }
+}
+
+void IndirectScene::releaseBuffers() {
+    if (builtCount > 0) cullPipeline.destroy();
+    win.deletionQueue.retireBuffer(objectBuffer);
+    win.deletionQueue.retireBuffer(instanceBuffer);
+    win.deletionQueue.retireBuffer(drawCommands);
+    win.deletionQueue.retireBuffer(drawCount);
+    builtCount = 0;
+    culled = false;
+}
+
+void IndirectScene::destroy() {
+    releaseBuffers();
+    objects.clear();
+    instances.clear();
+    mesh = nullptr;
+}
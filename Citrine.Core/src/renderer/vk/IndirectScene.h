@@ -0,0 +1,81 @@
+#ifndef CITRINE_INDIRECTSCENE_H
+#define CITRINE_INDIRECTSCENE_H
+
+#include "VkHelper.h"
+#include <vector>
+#include <glm/glm.hpp>
+#include "VkWindow.h"
+#include "ComputePipeline.h"
+#include "GraphicsPipeline.h"
+#include "Mesh.h"
+#include "../Frustum.h"
+
+// static objects of one mesh, culled and turned into draws on the gpu. cull() runs shaders/cull over every object's
+// bounding sphere and compacts the visible ones into VkDrawIndexedIndirectCommands, draw() issues them all with one
+// vkCmdDrawIndexedIndirectCount (or vkCmdDrawIndexedIndirect over every object, culled ones drawn with 0 instances).
+// firstInstance of each command is the object index, so the instanced pipeline reads the object's InstanceData.
+// per frame the cpu only pushes the frustum, whatever the object count
+class IndirectScene {
+private:
+    // std430 layout of shaders/cull
+    struct Object {
+        glm::vec4 sphere;
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t pad;
+    };
+    
+    struct CullConstants {
+        glm::vec4 planes[6];
+        uint32_t objectCount;
+        uint32_t compact;
+    };
+    
+    static constexpr uint32_t groupSize = 64;
+    
+    VkWindow& win;
+    ComputePipeline cullPipeline;
+    // shaders/cull/comp.spv is read at build when empty
+    std::span<const char> cullShader;
+    const Mesh* mesh = nullptr;
+    std::vector<Object> objects;
+    std::vector<InstanceData> instances;
+    
+    // uploaded by build
+    Buffer objectBuffer;
+    Buffer instanceBuffer;
+    uint64_t uploadTicket = 0;
+    // written by the cull shader every frame, read by the draws of the same frame
+    Buffer drawCommands;
+    Buffer drawCount;
+    uint32_t builtCount = 0;
+    bool compact = false;
+    // cull() recorded commands for draw() this frame
+    bool culled = false;
+    
+    void releaseBuffers();
+public:
+    explicit IndirectScene(VkWindow& window) : win(window), cullPipeline(window) {}
+    
+    // object indices go into firstInstance
+    [[nodiscard]] static bool isSupported(const VkWindow& window) { return window.device.features.drawIndirectFirstInstance; }
+    
+    // borrowed cull shader code (asset pack), before build
+    void setCullShader(std::span<const char> code) { cullShader = code; }
+    // world space bounding sphere, the whole mesh is drawn for the object
+    void add(const InstanceData& instance, glm::vec3 center, float radius);
+    // uploads the objects added so far, the scene draws them until the next build. mesh has to be indexed
+    void build(const Mesh& sceneMesh);
+    // outside of render passes, before draw
+    void cull(VkCommandBuffer commandBuffer, const Frustum& frustum);
+    // inside the render pass, pipeline has to be instanced
+    void draw(VkCommandBuffer commandBuffer, GraphicsPipeline& pipeline);
+    void destroy();
+    
+    [[nodiscard]] uint32_t objectCount() const { return builtCount; }
+    // culled objects still cost a draw slot
+    [[nodiscard]] bool isCompacted() const { return compact; }
+};
+
+#endif //CITRINE_INDIRECTSCENE_H
@@ -0,0 +1,105 @@
+#include "InstanceBatcher.h"
+#include <cstring>
+
+void InstanceBatcher::create(uint32_t initialInstances) {
+    instanceBuffers.resize(win.framesInFlight());
+    for (auto& buffer: instanceBuffers) reserve(buffer, initialInstances);
+}
+
+void InstanceBatcher::destroy() {
+    for (auto& buffer: instanceBuffers) win.deletionQueue.retireBuffer(buffer);
+    instanceBuffers.clear();
+    clear();
+}
+
+void InstanceBatcher::reserve(Buffer& buffer, uint32_t instances) {
+    VkDeviceSize size = static_cast<VkDeviceSize>(instances) * sizeof(InstanceData);
+    if (buffer.size >= size) return;
+    
+    // the frame that last read it may still be in flight
+    win.deletionQueue.retireBuffer(buffer);
+    // device local too where the driver exposes such memory (resizable bar), the gpu reads it once per instance
+    // non coherent memory works as well, record flushes what it wrote
+    buffer = win.allocator.createBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+InstanceBatcher::Batch& InstanceBatcher::findBatch(GraphicsPipeline& pipeline, const Mesh& mesh) {
+    // objects usually come in runs of the same mesh
+    if (lastBatch < batches.size() && batches[lastBatch].pipeline == &pipeline && batches[lastBatch].mesh == &mesh) return batches[lastBatch];
+    
+    // a handful of meshes per pipeline, a linear search beats hashing here
+    uint32_t insertAt = batches.size();
+    for (uint32_t i = 0; i < batches.size(); ++i) {
+        if (batches[i].pipeline != &pipeline) continue;
+        if (batches[i].mesh == &mesh) {
+            lastBatch = i;
+            return batches[i];
+        }
+        insertAt = i + 1;
+    }
+    
+    batches.insert(batches.begin() + insertAt, Batch{&pipeline, &mesh, {}});
+    lastBatch = insertAt;
+    return batches[insertAt];
+}
+
+void InstanceBatcher::add(GraphicsPipeline& pipeline, const Mesh& mesh, const InstanceData& instance) {
+    findBatch(pipeline, mesh).instances.push_back(instance);
+}
+
+std::span<InstanceData> InstanceBatcher::add(GraphicsPipeline& pipeline, const Mesh& mesh, uint32_t count) {
+    std::vector<InstanceData>& instances = findBatch(pipeline, mesh).instances;
+    size_t first = instances.size();
+    instances.resize(first + count);
+    return {instances.data() + first, count};
+}
+
+void InstanceBatcher::record(VkCommandBuffer commandBuffer) {
+    CITRINE_PROFILE_SCOPE("instance batches");
+    drawCount = 0;
+    instanceCount = 0;
+    
+    uint32_t total = 0;
+    for (const Batch& batch: batches) total += batch.instances.size();
+    if (total == 0) return;
+    
+    Buffer& buffer = instanceBuffers[win.commandPool.currentFrameIndex];
+    // only grows when this frame doesn't fit, then doubled so a slowly growing count doesn't reallocate every frame
+    uint32_t capacity = buffer.size / sizeof(InstanceData);
+    if (total > capacity) reserve(buffer, std::max(total, capacity * 2));
+    auto* mapped = static_cast<InstanceData*>(buffer.allocation.mapped);
+    
+    // instance rate attributes start at firstInstance, so one binding of the whole buffer serves every batch
+    VkDeviceSize offset = 0;
+    vkCmdBindVertexBuffers(commandBuffer, InstanceData::binding, 1, &buffer.buffer, &offset);
+    
+    uint32_t firstInstance = 0;
+    const GraphicsPipeline* boundPipeline = nullptr;
+    bool pipelineReady = false;
+    for (Batch& batch: batches) {
+        uint32_t count = batch.instances.size();
+        if (count == 0) continue;
+        std::memcpy(mapped + firstInstance, batch.instances.data(), count * sizeof(InstanceData));
+        batch.instances.clear();
+        
+        if (batch.pipeline != boundPipeline) {
+            boundPipeline = batch.pipeline;
+            pipelineReady = batch.pipeline->prepare();
+            if (pipelineReady) batch.pipeline->bind(commandBuffer);
+        }
+        if (pipelineReady && batch.mesh->isReady(win.uploader)) {
+            batch.mesh->bind(commandBuffer);
+            batch.mesh->draw(commandBuffer, count, firstInstance);
+            drawCount++;
+            instanceCount += count;
+        }
+        firstInstance += count;
+    }
+    // before the frame is submitted, so the gpu sees the instances
+    win.allocator.flush(buffer.allocation, 0, static_cast<VkDeviceSize>(firstInstance) * sizeof(InstanceData));
+}
+
+void InstanceBatcher::clear() {
+    batches.clear();
+    lastBatch = UINT32_MAX;
+}
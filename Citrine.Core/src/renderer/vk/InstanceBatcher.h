@@ -0,0 +1,55 @@
+#ifndef CITRINE_INSTANCEBATCHER_H
+#define CITRINE_INSTANCEBATCHER_H
+
+#include "VkHelper.h"
+#include <vector>
+#include <span>
+#include "VkWindow.h"
+#include "GraphicsPipeline.h"
+#include "Mesh.h"
+
+// merges every instance of the same pipeline + mesh submitted during a frame into one instanced draw.
+// record() packs the batches back to back into a persistently mapped buffer of the frame slot (InstanceData,
+// binding 1) which is bound once, each batch is drawn with its firstInstance. batches live across frames so
+// their storage only grows while the scene does. frame thread only.
+class InstanceBatcher {
+private:
+    struct Batch {
+        GraphicsPipeline* pipeline;
+        const Mesh* mesh;
+        std::vector<InstanceData> instances;
+    };
+
+    VkWindow& win;
+    // per frame in flight, host visible
+    std::vector<Buffer> instanceBuffers;
+    // grouped by pipeline so pipelines are bound once per frame
+    std::vector<Batch> batches;
+    uint32_t lastBatch = UINT32_MAX;
+
+    uint32_t drawCount = 0;
+    uint32_t instanceCount = 0;
+
+    Batch& findBatch(GraphicsPipeline& pipeline, const Mesh& mesh);
+    void reserve(Buffer& buffer, uint32_t instances);
+public:
+    explicit InstanceBatcher(VkWindow& window) : win(window) {}
+
+    void create(uint32_t initialInstances = 1024);
+    void destroy();
+
+    // pipeline has to be instanced (GraphicsPipeline::setInstanced)
+    void add(GraphicsPipeline& pipeline, const Mesh& mesh, const InstanceData& instance);
+    // count uninitialized instances of one batch, valid until the next add
+    std::span<InstanceData> add(GraphicsPipeline& pipeline, const Mesh& mesh, uint32_t count);
+    // one draw per non empty batch, then empties them for the next frame. inside a render pass (or graph pass)
+    void record(VkCommandBuffer commandBuffer);
+    // forgets all batches, call before destroying meshes or pipelines that were added
+    void clear();
+
+    // of the last record
+    [[nodiscard]] uint32_t draws() const { return drawCount; }
+    [[nodiscard]] uint32_t instances() const { return instanceCount; }
+};
+
+#endif //CITRINE_INSTANCEBATCHER_H
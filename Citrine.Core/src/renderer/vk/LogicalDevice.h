@@ -5,10 +5,14 @@
 #include <optional>
 #include <vector>
 #include <set>
+#include <string>
+#include <cstring>
+#include <stdexcept>
 
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphics;
     std::optional<uint32_t> present;
+    std::optional<uint32_t> transfer;
 };
 
 struct LogicalDevice {
@@ -22,15 +26,39 @@ private:
         int i = 0;
         for (const auto &family: queueFamilies) {
             if (family.queueFlags & VK_QUEUE_GRAPHICS_BIT) vkQueueFamilyIndices.graphics = i;
+            if (surface == VK_NULL_HANDLE) {
+                i++;
+                continue;
+            }
             VkBool32 presentSupport = false;
             vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice, i, surface, &presentSupport);
             if (presentSupport) vkQueueFamilyIndices.present = i;
             i++;
         }
+        
+        // headless: nothing is presented, graphics queue stands in for the present queue
+        if (surface == VK_NULL_HANDLE) vkQueueFamilyIndices.present = vkQueueFamilyIndices.graphics;
+        
+        // prefer a dedicated DMA family (transfer only), then any non graphics family that can transfer, then graphics
+        i = 0;
+        int bestScore = -1;
+        for (const auto &family: queueFamilies) {
+            int score = -1;
+            if (family.queueFlags & VK_QUEUE_TRANSFER_BIT) score = 1;
+            if (score >= 0 && !(family.queueFlags & VK_QUEUE_GRAPHICS_BIT)) score = 2;
+            if (score >= 0 && !(family.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) score = 3;
+            if (score > bestScore) {
+                bestScore = score;
+                vkQueueFamilyIndices.transfer = i;
+            }
+            i++;
+        }
+        if (bestScore <= 1) vkQueueFamilyIndices.transfer = vkQueueFamilyIndices.graphics;
+        transferGranularity = queueFamilies[vkQueueFamilyIndices.transfer.value()].minImageTransferGranularity;
     }
     
     void populateQueueCreateInfo(std::vector<VkDeviceQueueCreateInfo>& createInfo) {
-        std::set<uint32_t> uniqueQueueFamilies = {vkQueueFamilyIndices.graphics.value(), vkQueueFamilyIndices.present.value()};
+        std::set<uint32_t> uniqueQueueFamilies = {vkQueueFamilyIndices.graphics.value(), vkQueueFamilyIndices.present.value(), vkQueueFamilyIndices.transfer.value()};
         const float priority = 1;
 
         for (uint32_t family: uniqueQueueFamilies) {
@@ -42,24 +70,117 @@ private:
             createInfo.push_back(queueCreateInfo);
         }
     }
+    
+    // core since 1.3, 1.2 devices may have the extension (its dependencies are core in 1.2). optional, RenderPass falls back to render pass objects
+    void enableDynamicRendering(VkPhysicalDevice physicalDevice, std::vector<const char*>& extensions) {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        if (properties.apiVersion < VK_API_VERSION_1_3) {
+            uint32_t extensionCount = 0;
+            vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+            std::vector<VkExtensionProperties> available(extensionCount);
+            vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, available.data());
+            for (const auto& extension: available)
+                if (strcmp(extension.extensionName, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) == 0) dynamicRenderingKhr = true;
+            if (!dynamicRenderingKhr) return;
+        }
+        
+        VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures{};
+        dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &dynamicRenderingFeatures;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+        dynamicRendering = dynamicRenderingFeatures.dynamicRendering;
+        if (dynamicRendering && dynamicRenderingKhr) extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    }
+    
+    // vkCmdDrawIndexedIndirectCount: an optional feature of 1.2, without it indirect draws use a fixed draw count
+    void enableDrawIndirectCount(VkPhysicalDevice physicalDevice) {
+        VkPhysicalDeviceVulkan12Features features12{};
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &features12;
+        vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+        drawIndirectCount = features12.drawIndirectCount;
+    }
+    
+    // VK_EXT_memory_budget: what the process may use per heap right now. optional, budgets fall back to the heap sizes
+    void enableMemoryBudget(VkPhysicalDevice physicalDevice, std::vector<const char*>& extensions) {
+        uint32_t extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> available(extensionCount);
+        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, available.data());
+        for (const auto& extension: available) {
+            if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) != 0) continue;
+            extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            memoryBudget = true;
+            return;
+        }
+    }
+    
+    void loadDrawIndirectCountFunctions() {
+        if (!drawIndirectCount) return;
+        cmdDrawIndexedIndirectCount = (PFN_vkCmdDrawIndexedIndirectCount) vkGetDeviceProcAddr(device, "vkCmdDrawIndexedIndirectCount");
+        if (!cmdDrawIndexedIndirectCount) throw std::runtime_error("missing draw indirect count entry point (LogicalDevice.h)");
+    }
+    
+    void loadDynamicRenderingFunctions() {
+        if (!dynamicRendering) return;
+        std::string suffix = dynamicRenderingKhr ? "KHR" : "";
+        cmdBeginRendering = (PFN_vkCmdBeginRendering) vkGetDeviceProcAddr(device, ("vkCmdBeginRendering" + suffix).c_str());
+        cmdEndRendering = (PFN_vkCmdEndRendering) vkGetDeviceProcAddr(device, ("vkCmdEndRendering" + suffix).c_str());
+        if (!cmdBeginRendering || !cmdEndRendering) throw std::runtime_error("missing dynamic rendering entry points (LogicalDevice.h)");
+    }
 public:
     QueueFamilyIndices vkQueueFamilyIndices{};
+    // image copies on the transfer family start and end on multiples of it (texel blocks), 0 allows whole levels only
+    VkExtent3D transferGranularity{1, 1, 1};
     VkDevice device{};
+    // render passes begin on image views (vkCmdBeginRendering), no VkRenderPass/VkFramebuffer objects
+    bool dynamicRendering = false;
+    bool dynamicRenderingKhr = false;
+    PFN_vkCmdBeginRendering cmdBeginRendering = nullptr;
+    PFN_vkCmdEndRendering cmdEndRendering = nullptr;
+    // the gpu decides how many indirect draws to run (vkCmdDrawIndexedIndirectCount)
+    bool drawIndirectCount = false;
+    PFN_vkCmdDrawIndexedIndirectCount cmdDrawIndexedIndirectCount = nullptr;
+    // heap budgets through vkGetPhysicalDeviceMemoryProperties2 (MemoryAllocator::deviceLocalBudget)
+    bool memoryBudget = false;
+    // enabled core features, all the device supports
+    VkPhysicalDeviceFeatures features{};
     
-    void create(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const std::vector<const char*>& vkRequiredValidationLayers, const std::vector<const char*>& vkRequiredDeviceExtensions) {
+    // allowDynamicRendering: use dynamic rendering when the device supports it
+    void create(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, const std::vector<const char*>& vkRequiredValidationLayers, const std::vector<const char*>& vkRequiredDeviceExtensions, bool allowDynamicRendering = true) {
         findQueueFamilyIndices(physicalDevice, surface);
-        VkPhysicalDeviceFeatures physicalDeviceFeatures{};
-        vkGetPhysicalDeviceFeatures(physicalDevice, &physicalDeviceFeatures);
+        vkGetPhysicalDeviceFeatures(physicalDevice, &features);
         
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfo;
         populateQueueCreateInfo(queueCreateInfo);
         
+        std::vector<const char*> extensions = vkRequiredDeviceExtensions;
+        // PhysicalDevice only picks 1.2 devices, timeline semaphores are a required feature there
+        enableDrawIndirectCount(physicalDevice);
+        VkPhysicalDeviceVulkan12Features features12{};
+        features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        features12.timelineSemaphore = true;
+        features12.drawIndirectCount = drawIndirectCount;
+        
+        enableMemoryBudget(physicalDevice, extensions);
+        if (allowDynamicRendering) enableDynamicRendering(physicalDevice, extensions);
+        VkPhysicalDeviceDynamicRenderingFeatures dynamicRenderingFeatures{};
+        dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+        dynamicRenderingFeatures.dynamicRendering = true;
+        if (dynamicRendering) features12.pNext = &dynamicRenderingFeatures;
+        
         VkDeviceCreateInfo createInfo{};
+        createInfo.pNext = &features12;
 
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfo.size());
         createInfo.pQueueCreateInfos = queueCreateInfo.data();
-        createInfo.pEnabledFeatures = &physicalDeviceFeatures;
+        createInfo.pEnabledFeatures = &features;
 
         createInfo.enabledLayerCount = 0;
         if (enableVkValidationLayers) {
@@ -67,10 +188,12 @@ public:
             createInfo.ppEnabledLayerNames = vkRequiredValidationLayers.data();
         }
 
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(vkRequiredDeviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = vkRequiredDeviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
 
         VkCheck(vkCreateDevice(physicalDevice, &createInfo, nullptr, &device), "vkCreateDevice (LogicalDevice.h)");
+        loadDynamicRenderingFunctions();
+        loadDrawIndirectCountFunctions();
     }
     
     void WaitIdle() const {
@@ -0,0 +1,390 @@
+#include "MemoryAllocator.h"
+#include <algorithm>
+#include <bit>
+
+void MemoryAllocator::create(PhysicalDevice& physical, LogicalDevice& logicalDevice) {
+    device = logicalDevice.device;
+    physicalDevice = physical.physicalDevice;
+    memoryBudget = logicalDevice.memoryBudget;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+    bufferImageGranularity = physical.physicalDeviceProperties.limits.bufferImageGranularity;
+    nonCoherentAtomSize = std::max<VkDeviceSize>(physical.physicalDeviceProperties.limits.nonCoherentAtomSize, 1);
+    maxAllocationCount = physical.physicalDeviceProperties.limits.maxMemoryAllocationCount;
+
+    heapStats.resize(memoryProperties.memoryHeapCount);
+    for (int i = 0; i < memoryProperties.memoryHeapCount; ++i) heapStats[i].heapSize = memoryProperties.memoryHeaps[i].size;
+}
+
+void MemoryAllocator::destroy() {
+    uint32_t leaked = 0;
+    for (auto& pool: pools) {
+        for (auto& block: pool.blocks) {
+            if (block.memory == VK_NULL_HANDLE) continue;
+            leaked += block.allocationCount;
+            vkFreeMemory(device, block.memory, nullptr);
+        }
+    }
+    pools.clear();
+    if (leaked != 0) std::cout << "memory allocator destroyed with " << leaked << " live sub-allocations\n";
+}
+
+uint32_t MemoryAllocator::findMemoryType(uint32_t filter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred) const {
+    VkMemoryPropertyFlags wanted = required | preferred;
+    for (int i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+        if ((filter & (1<<i)) && (memoryProperties.memoryTypes[i].propertyFlags & wanted) == wanted) return i;
+    }
+    for (int i = 0; i < memoryProperties.memoryTypeCount; ++i) {
+        if ((filter & (1<<i)) && (memoryProperties.memoryTypes[i].propertyFlags & required) == required) return i;
+    }
+    throw std::runtime_error("failed to find suitable memory type");
+}
+
+VkDeviceSize MemoryAllocator::blockSizeFor(uint32_t memoryType) const {
+    // small heaps (integrated gpus, BAR memory) get smaller blocks so one block doesn't eat the heap
+    VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryType].heapIndex].size;
+    VkDeviceSize size = std::bit_floor(std::max<VkDeviceSize>(heapSize / 8, 1024 * 1024));
+    return std::min(size, defaultBlockSize);
+}
+
+bool MemoryAllocator::isHostVisible(uint32_t memoryType) const {
+    return memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+}
+
+bool MemoryAllocator::isCoherent(uint32_t memoryType) const {
+    return memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+}
+
+uint32_t MemoryAllocator::poolIndex(uint32_t memoryType, AllocationKind kind) {
+    // nodes are at least minNodeSize aligned, so with a small granularity linear and optimal resources can never share a page
+    if (bufferImageGranularity <= minNodeSize) kind = AllocationKind::Linear;
+
+    for (uint32_t i = 0; i < pools.size(); ++i)
+        if (pools[i].memoryType == memoryType && pools[i].kind == kind) return i;
+
+    Pool pool{};
+    pool.memoryType = memoryType;
+    pool.kind = kind;
+    pools.push_back(pool);
+    return pools.size() - 1;
+}
+
+VkDeviceMemory MemoryAllocator::allocateDeviceMemory(uint32_t memoryType, VkDeviceSize size, void** mapped, const VkMemoryDedicatedAllocateInfo* dedicatedInfo) {
+    if (deviceAllocationCount >= maxAllocationCount) throw std::runtime_error("maxMemoryAllocationCount reached (MemoryAllocator.cpp)");
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = dedicatedInfo;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryType;
+
+    VkDeviceMemory memory;
+    VkCheck(vkAllocateMemory(device, &allocInfo, nullptr, &memory), "vkAllocateMemory (MemoryAllocator.cpp)");
+    deviceAllocationCount++;
+
+    *mapped = nullptr;
+    if (isHostVisible(memoryType)) VkCheck(vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, mapped), "vkMapMemory (MemoryAllocator.cpp)");
+    return memory;
+}
+
+void MemoryAllocator::freeDeviceMemory(uint32_t memoryType, VkDeviceMemory memory, bool mapped) {
+    if (mapped) vkUnmapMemory(device, memory);
+    vkFreeMemory(device, memory, nullptr);
+    deviceAllocationCount--;
+}
+
+bool MemoryAllocator::allocateFromBlock(Block& block, uint8_t order, VkDeviceSize& offset) {
+    if (order > block.maxOrder) return false;
+
+    uint8_t current = order;
+    while (current <= block.maxOrder && block.freeLists[current].empty()) current++;
+    if (current > block.maxOrder) return false;
+
+    offset = *block.freeLists[current].begin();
+    block.freeLists[current].erase(block.freeLists[current].begin());
+
+    // split down, the upper halves become free buddies
+    while (current > order) {
+        current--;
+        block.freeLists[current].insert(offset + (minNodeSize << current));
+    }
+    return true;
+}
+
+void MemoryAllocator::freeInBlock(Block& block, uint8_t order, VkDeviceSize offset) {
+    while (order < block.maxOrder) {
+        VkDeviceSize buddy = offset ^ (minNodeSize << order);
+        auto it = block.freeLists[order].find(buddy);
+        if (it == block.freeLists[order].end()) break;
+
+        block.freeLists[order].erase(it);
+        offset = std::min(offset, buddy);
+        order++;
+    }
+    block.freeLists[order].insert(offset);
+}
+
+Allocation MemoryAllocator::allocateDedicated(uint32_t memoryType, VkDeviceSize size, VkImage image, VkBuffer buffer) {
+    // lets the driver place the memory for that one resource (compression metadata, alignment)
+    VkMemoryDedicatedAllocateInfo dedicatedInfo{};
+    dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedInfo.image = image;
+    dedicatedInfo.buffer = buffer;
+    bool forResource = image != VK_NULL_HANDLE || buffer != VK_NULL_HANDLE;
+    
+    Allocation allocation{};
+    allocation.memory = allocateDeviceMemory(memoryType, size, &allocation.mapped, forResource ? &dedicatedInfo : nullptr);
+    allocation.size = size;
+    allocation.memoryType = memoryType;
+    allocation.dedicated = true;
+
+    HeapStats& heap = heapStats[memoryProperties.memoryTypes[memoryType].heapIndex];
+    heap.dedicatedCount++;
+    heap.dedicatedBytes += size;
+    heap.usedBytes += size;
+    heap.allocationCount++;
+    return allocation;
+}
+
+Allocation MemoryAllocator::allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, AllocationKind kind, bool dedicated,
+                                     VkImage image, VkBuffer buffer) {
+    std::lock_guard lock(mutex);
+
+    uint32_t memoryType = findMemoryType(requirements.memoryTypeBits, required, preferred);
+    VkDeviceSize blockSize = blockSizeFor(memoryType);
+    // buddy nodes are aligned to their size, so rounding up to the alignment satisfies it
+    VkDeviceSize nodeSize = std::bit_ceil(std::max({requirements.size, requirements.alignment, minNodeSize}));
+
+    if (dedicated || nodeSize > blockSize / 2 || (kind == AllocationKind::Optimal && requirements.size >= dedicatedImageSize))
+        return allocateDedicated(memoryType, requirements.size, image, buffer);
+
+    uint8_t order = std::countr_zero(nodeSize) - minNodeOrder;
+    uint32_t p = poolIndex(memoryType, kind);
+    Pool& pool = pools[p];
+
+    VkDeviceSize offset = 0;
+    uint32_t b = 0;
+    for (; b < pool.blocks.size(); ++b) {
+        if (pool.blocks[b].memory != VK_NULL_HANDLE && allocateFromBlock(pool.blocks[b], order, offset)) break;
+    }
+
+    HeapStats& heap = heapStats[memoryProperties.memoryTypes[memoryType].heapIndex];
+    if (b == pool.blocks.size()) {
+        // reuse a slot of a released block to keep block indices of live allocations stable
+        b = 0;
+        while (b < pool.blocks.size() && pool.blocks[b].memory != VK_NULL_HANDLE) b++;
+        if (b == pool.blocks.size()) pool.blocks.emplace_back();
+
+        Block& block = pool.blocks[b];
+        block.memory = allocateDeviceMemory(memoryType, blockSize, &block.mapped);
+        block.size = blockSize;
+        block.maxOrder = std::countr_zero(blockSize) - minNodeOrder;
+        block.freeLists.assign(block.maxOrder + 1, std::set<VkDeviceSize>());
+        block.freeLists[block.maxOrder].insert(0);
+
+        heap.blockCount++;
+        heap.blockBytes += blockSize;
+        allocateFromBlock(block, order, offset);
+    }
+
+    Block& block = pool.blocks[b];
+    block.allocationCount++;
+    block.usedBytes += nodeSize;
+    heap.usedBytes += nodeSize;
+    heap.allocationCount++;
+
+    Allocation allocation{};
+    allocation.memory = block.memory;
+    allocation.offset = offset;
+    allocation.size = requirements.size;
+    allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + offset : nullptr;
+    allocation.memoryType = memoryType;
+    allocation.pool = p;
+    allocation.block = b;
+    allocation.order = order;
+    return allocation;
+}
+
+void MemoryAllocator::free(Allocation& allocation) {
+    if (allocation.memory == VK_NULL_HANDLE) return;
+    std::lock_guard lock(mutex);
+
+    HeapStats& heap = heapStats[memoryProperties.memoryTypes[allocation.memoryType].heapIndex];
+    heap.allocationCount--;
+
+    if (allocation.dedicated) {
+        freeDeviceMemory(allocation.memoryType, allocation.memory, allocation.mapped != nullptr);
+        heap.dedicatedCount--;
+        heap.dedicatedBytes -= allocation.size;
+        heap.usedBytes -= allocation.size;
+        allocation = {};
+        return;
+    }
+
+    Pool& pool = pools[allocation.pool];
+    Block& block = pool.blocks[allocation.block];
+    VkDeviceSize nodeSize = minNodeSize << allocation.order;
+    freeInBlock(block, allocation.order, allocation.offset);
+    block.allocationCount--;
+    block.usedBytes -= nodeSize;
+    heap.usedBytes -= nodeSize;
+
+    // keep one empty block per pool around so alloc/free patterns don't thrash vkAllocateMemory
+    if (block.allocationCount == 0) {
+        bool hasOtherEmpty = false;
+        for (uint32_t i = 0; i < pool.blocks.size(); ++i) {
+            if (i != allocation.block && pool.blocks[i].memory != VK_NULL_HANDLE && pool.blocks[i].allocationCount == 0) hasOtherEmpty = true;
+        }
+        if (hasOtherEmpty) {
+            freeDeviceMemory(pool.memoryType, block.memory, block.mapped != nullptr);
+            heap.blockCount--;
+            heap.blockBytes -= block.size;
+            block = {};
+        }
+    }
+    allocation = {};
+}
+
+VkMappedMemoryRange MemoryAllocator::mappedRange(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) const {
+    VkDeviceSize memorySize = allocation.dedicated ? allocation.size : blockSizeFor(allocation.memoryType);
+    VkDeviceSize begin = allocation.offset + offset;
+    VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+    
+    VkMappedMemoryRange range{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = allocation.memory;
+    range.offset = begin / nonCoherentAtomSize * nonCoherentAtomSize;
+    end = (end + nonCoherentAtomSize - 1) / nonCoherentAtomSize * nonCoherentAtomSize;
+    // the spec allows a size that isn't a multiple of the atom only when the range ends with the memory
+    range.size = end >= memorySize ? VK_WHOLE_SIZE : end - range.offset;
+    return range;
+}
+
+void MemoryAllocator::flush(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) const {
+    if (allocation.mapped == nullptr || isCoherent(allocation.memoryType) || size == 0) return;
+    VkMappedMemoryRange range = mappedRange(allocation, offset, size);
+    VkCheck(vkFlushMappedMemoryRanges(device, 1, &range), "vkFlushMappedMemoryRanges (MemoryAllocator.cpp)");
+}
+
+void MemoryAllocator::invalidate(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) const {
+    if (allocation.mapped == nullptr || isCoherent(allocation.memoryType) || size == 0) return;
+    VkMappedMemoryRange range = mappedRange(allocation, offset, size);
+    VkCheck(vkInvalidateMappedMemoryRanges(device, 1, &range), "vkInvalidateMappedMemoryRanges (MemoryAllocator.cpp)");
+}
+
+Buffer MemoryAllocator::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, std::span<const uint32_t> queueFamilies) {
+    Buffer buffer{};
+    buffer.size = size;
+
+    VkBufferCreateInfo bufferCreateInfo{};
+    bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCreateInfo.size = size;
+    bufferCreateInfo.usage = usage;
+    bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (queueFamilies.size() > 1) {
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferCreateInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+        bufferCreateInfo.pQueueFamilyIndices = queueFamilies.data();
+    }
+    VkCheck(vkCreateBuffer(device, &bufferCreateInfo, nullptr, &buffer.buffer), "vkCreateBuffer (MemoryAllocator.cpp)");
+
+    VkMemoryDedicatedRequirements dedicatedRequirements{};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    VkMemoryRequirements2 memRequirements{};
+    memRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    memRequirements.pNext = &dedicatedRequirements;
+    VkBufferMemoryRequirementsInfo2 requirementsInfo{};
+    requirementsInfo.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+    requirementsInfo.buffer = buffer.buffer;
+    vkGetBufferMemoryRequirements2(device, &requirementsInfo, &memRequirements);
+    bool dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+    buffer.allocation = allocate(memRequirements.memoryRequirements, required, preferred, AllocationKind::Linear, dedicated, VK_NULL_HANDLE, buffer.buffer);
+    VkCheck(vkBindBufferMemory(device, buffer.buffer, buffer.allocation.memory, buffer.allocation.offset), "vkBindBufferMemory (MemoryAllocator.cpp)");
+    return buffer;
+}
+
+void MemoryAllocator::destroyBuffer(Buffer& buffer) {
+    vkDestroyBuffer(device, buffer.buffer, nullptr);
+    free(buffer.allocation);
+    buffer = {};
+}
+
+Image MemoryAllocator::createImage(const VkImageCreateInfo& createInfo, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, bool dedicated) {
+    Image image{};
+    VkCheck(vkCreateImage(device, &createInfo, nullptr, &image.image), "vkCreateImage (MemoryAllocator.cpp)");
+
+    VkMemoryDedicatedRequirements dedicatedRequirements{};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    VkMemoryRequirements2 memRequirements{};
+    memRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    memRequirements.pNext = &dedicatedRequirements;
+    VkImageMemoryRequirementsInfo2 requirementsInfo{};
+    requirementsInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+    requirementsInfo.image = image.image;
+    vkGetImageMemoryRequirements2(device, &requirementsInfo, &memRequirements);
+    // render targets usually prefer their own memory
+    dedicated = dedicated || dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+    AllocationKind kind = createInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? AllocationKind::Optimal : AllocationKind::Linear;
+    image.allocation = allocate(memRequirements.memoryRequirements, required, preferred, kind, dedicated, image.image);
+    VkCheck(vkBindImageMemory(device, image.image, image.allocation.memory, image.allocation.offset), "vkBindImageMemory (MemoryAllocator.cpp)");
+    return image;
+}
+
+void MemoryAllocator::destroyImage(Image& image) {
+    vkDestroyImage(device, image.image, nullptr);
+    free(image.allocation);
+    image = {};
+}
+
+std::vector<HeapStats> MemoryAllocator::stats() {
+    std::lock_guard lock(mutex);
+    return heapStats;
+}
+
+void MemoryAllocator::printStats() {
+    std::vector<HeapStats> heaps = stats();
+    for (int i = 0; i < heaps.size(); ++i) {
+        const HeapStats& heap = heaps[i];
+        if (heap.blockCount == 0 && heap.dedicatedCount == 0) continue;
+        std::cout << "heap " << i << ": " << (heap.usedBytes / 1024) << "kb used, "
+                  << heap.blockCount << " blocks (" << (heap.blockBytes / 1024 / 1024) << "mb), "
+                  << heap.dedicatedCount << " dedicated (" << (heap.dedicatedBytes / 1024 / 1024) << "mb), "
+                  << heap.allocationCount << " allocations, heap " << (heap.heapSize / 1024 / 1024) << "mb\n";
+    }
+}
+
+VkPhysicalDeviceMemoryBudgetPropertiesEXT MemoryAllocator::queryBudget() const {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    properties.pNext = &budget;
+    vkGetPhysicalDeviceMemoryProperties2(physicalDevice, &properties);
+    return budget;
+}
+
+VkDeviceSize MemoryAllocator::deviceLocalBudget() {
+    if (!memoryBudget) return PhysicalDevice::deviceLocalMemory(physicalDevice);
+    
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = queryBudget();
+    VkDeviceSize total = 0;
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+        if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) total += budget.heapBudget[i];
+    }
+    return total;
+}
+
+VkDeviceSize MemoryAllocator::deviceLocalUsage() {
+    VkDeviceSize total = 0;
+    if (memoryBudget) {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = queryBudget();
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+            if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) total += budget.heapUsage[i];
+        }
+        return total;
+    }
+    std::lock_guard lock(mutex);
+    for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+        if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) total += heapStats[i].blockBytes + heapStats[i].dedicatedBytes;
+    }
+    return total;
+}
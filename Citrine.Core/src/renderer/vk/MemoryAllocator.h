@@ -0,0 +1,139 @@
+#ifndef CITRINE_MEMORYALLOCATOR_H
+#define CITRINE_MEMORYALLOCATOR_H
+
+#include "VkHelper.h"
+#include <iostream>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <span>
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+
+// buffers and linear images vs optimal tiling images, kept in separate pools when bufferImageGranularity requires it
+enum class AllocationKind : uint8_t {
+    Linear,
+    Optimal,
+};
+
+struct Allocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    // persistently mapped pointer (offset already applied), nullptr if memory is not host visible
+    void* mapped = nullptr;
+    uint32_t memoryType = 0;
+    uint32_t pool = 0;
+    uint32_t block = 0;
+    uint8_t order = 0;
+    bool dedicated = false;
+};
+
+struct Buffer {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    Allocation allocation;
+};
+
+struct Image {
+    VkImage image = VK_NULL_HANDLE;
+    Allocation allocation;
+};
+
+struct HeapStats {
+    VkDeviceSize heapSize = 0;
+    VkDeviceSize blockBytes = 0;
+    VkDeviceSize dedicatedBytes = 0;
+    VkDeviceSize usedBytes = 0;
+    uint32_t blockCount = 0;
+    uint32_t dedicatedCount = 0;
+    uint32_t allocationCount = 0;
+};
+
+// device memory sub-allocator. owns large blocks per memory type and hands out ranges of them through a buddy scheme,
+// big resources get dedicated allocations. every buffer/image of the renderer goes through it.
+class MemoryAllocator {
+private:
+    static constexpr VkDeviceSize minNodeSize = 256;
+    static constexpr uint8_t minNodeOrder = 8;
+    static constexpr VkDeviceSize defaultBlockSize = 64ull * 1024 * 1024;
+    static constexpr VkDeviceSize dedicatedImageSize = 16ull * 1024 * 1024;
+
+    struct Block {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        VkDeviceSize size = 0;
+        uint8_t maxOrder = 0;
+        uint32_t allocationCount = 0;
+        VkDeviceSize usedBytes = 0;
+        // free node offsets per order, order 0 nodes are minNodeSize bytes
+        std::vector<std::set<VkDeviceSize>> freeLists;
+    };
+
+    struct Pool {
+        uint32_t memoryType = 0;
+        AllocationKind kind = AllocationKind::Linear;
+        std::vector<Block> blocks;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    bool memoryBudget = false;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    VkDeviceSize bufferImageGranularity = 1;
+    // flushed/invalidated ranges of non coherent memory are aligned to it
+    VkDeviceSize nonCoherentAtomSize = 1;
+    uint32_t maxAllocationCount = 0;
+    uint32_t deviceAllocationCount = 0;
+
+    std::vector<Pool> pools;
+    std::vector<HeapStats> heapStats;
+    std::mutex mutex;
+
+    [[nodiscard]] VkDeviceSize blockSizeFor(uint32_t memoryType) const;
+    [[nodiscard]] bool isHostVisible(uint32_t memoryType) const;
+    uint32_t poolIndex(uint32_t memoryType, AllocationKind kind);
+    // dedicatedInfo: chained VkMemoryDedicatedAllocateInfo, nullptr for blocks
+    VkDeviceMemory allocateDeviceMemory(uint32_t memoryType, VkDeviceSize size, void** mapped, const VkMemoryDedicatedAllocateInfo* dedicatedInfo = nullptr);
+    void freeDeviceMemory(uint32_t memoryType, VkDeviceMemory memory, bool mapped);
+    bool allocateFromBlock(Block& block, uint8_t order, VkDeviceSize& offset);
+    void freeInBlock(Block& block, uint8_t order, VkDeviceSize offset);
+    Allocation allocateDedicated(uint32_t memoryType, VkDeviceSize size, VkImage image, VkBuffer buffer);
+    [[nodiscard]] bool isCoherent(uint32_t memoryType) const;
+    // range of the allocation's VkDeviceMemory, aligned out to nonCoherentAtomSize without leaving the memory
+    [[nodiscard]] VkMappedMemoryRange mappedRange(const Allocation& allocation, VkDeviceSize offset, VkDeviceSize size) const;
+    [[nodiscard]] VkPhysicalDeviceMemoryBudgetPropertiesEXT queryBudget() const;
+
+public:
+    void create(PhysicalDevice& physical, LogicalDevice& logicalDevice);
+    void destroy();
+
+    [[nodiscard]] uint32_t findMemoryType(uint32_t filter, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0) const;
+    [[nodiscard]] const VkPhysicalDeviceMemoryProperties& properties() const { return memoryProperties; }
+
+    // dedicated allocations are made for image or buffer (when given), as VK_KHR_dedicated_allocation describes
+    Allocation allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred, AllocationKind kind, bool dedicated = false,
+                        VkImage image = VK_NULL_HANDLE, VkBuffer buffer = VK_NULL_HANDLE);
+    void free(Allocation& allocation);
+    // host writes to / gpu writes from mapped memory that may not be coherent, no-ops on coherent memory.
+    // offset and size are relative to the allocation
+    void flush(const Allocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+    void invalidate(const Allocation& allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+
+    // more than one distinct queue family makes the buffer concurrently shared between them
+    Buffer createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0, std::span<const uint32_t> queueFamilies = {});
+    void destroyBuffer(Buffer& buffer);
+    Image createImage(const VkImageCreateInfo& createInfo, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred = 0, bool dedicated = false);
+    void destroyImage(Image& image);
+
+    // usage per memory heap, indexed like VkPhysicalDeviceMemoryProperties::memoryHeaps
+    std::vector<HeapStats> stats();
+    void printStats();
+    // device local bytes the process may use right now: the heap budgets of VK_EXT_memory_budget (they move as other
+    // processes allocate), the heap sizes without it
+    VkDeviceSize deviceLocalBudget();
+    // device local bytes in use, by this process as the driver reports it or by this allocator without the extension
+    VkDeviceSize deviceLocalUsage();
+};
+
+#endif //CITRINE_MEMORYALLOCATOR_H
@@ -0,0 +1,96 @@
+#ifndef CITRINE_MESH_H
+#define CITRINE_MESH_H
+
+#include "VkHelper.h"
+#include <span>
+#include <vector>
+#include <cstring>
+#include "Vertex.h"
+#include "Uploader.h"
+#include "DeletionQueue.h"
+#include "../../core/AssetPack.h"
+
+// vertices (and optionally indices, stored as 16 bit when the vertex count allows) uploaded once into device local
+// buffers, drawn by any pipeline with the same vertex layout (Vertex, CompactVertex or TexturedVertex, see GraphicsPipeline::setVertexLayout)
+struct Mesh {
+    Buffer vertexBuffer{};
+    // empty for non indexed meshes
+    Buffer indexBuffer{};
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+    uint64_t uploadTicket = 0;
+    // maps quantized positions back into model space, instance transforms drawing the mesh have to include it
+    glm::mat4 decode = glm::mat4(1);
+
+    void create(Uploader& uploader, std::span<const Vertex> vertices, std::span<const uint32_t> indices = {}) {
+        create(uploader, vertices.data(), vertices.size_bytes(), vertices.size(), indices);
+    }
+
+    void create(Uploader& uploader, std::span<const TexturedVertex> vertices, std::span<const uint32_t> indices = {}) {
+        create(uploader, vertices.data(), vertices.size_bytes(), vertices.size(), indices);
+    }
+
+    void create(Uploader& uploader, std::span<const CompactVertex> vertices, std::span<const uint32_t> indices, const glm::mat4& decodeMatrix) {
+        create(uploader, vertices.data(), vertices.size_bytes(), vertices.size(), indices);
+        decode = decodeMatrix;
+    }
+
+    // vertices of any layout as raw bytes
+    void create(Uploader& uploader, const void* vertices, VkDeviceSize size, size_t count, std::span<const uint32_t> indices) {
+        // half the index bandwidth when every index fits, upload copies into staging so the temporary is fine
+        if (count <= UINT16_MAX && !indices.empty()) {
+            std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+            create(uploader, vertices, size, count, shortIndices.data(), shortIndices.size(), VK_INDEX_TYPE_UINT16);
+        }
+        else create(uploader, vertices, size, count, indices.data(), indices.size(), VK_INDEX_TYPE_UINT32);
+    }
+
+    // straight from the pack mapping into staging, the packer already picked the index type
+    void create(Uploader& uploader, const AssetPack::MeshView& mesh) {
+        static_assert(sizeof(Vertex) == assetVertexStride(AssetVertexFormat::Float) && sizeof(CompactVertex) == assetVertexStride(AssetVertexFormat::Compact));
+        create(uploader, mesh.vertices.data(), mesh.vertices.size(), mesh.header->vertexCount, mesh.indices.data(), mesh.header->indexCount,
+               mesh.header->indexSize == sizeof(uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+        std::memcpy(&decode, mesh.header->decode, sizeof(decode));
+    }
+
+    void create(Uploader& uploader, const void* vertices, VkDeviceSize size, size_t count, const void* indices, size_t indicesCount, VkIndexType type) {
+        vertexBuffer = uploader.createDeviceBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+        uploadTicket = uploader.upload(vertexBuffer, 0, vertices, size);
+        vertexCount = count;
+        decode = glm::mat4(1);
+        
+        indexCount = indicesCount;
+        indexType = type;
+        if (indexCount == 0) return;
+        VkDeviceSize indexSize = indexCount * (type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t));
+        indexBuffer = uploader.createDeviceBuffer(indexSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+        // tickets complete in order, the later one covers both
+        uploadTicket = uploader.upload(indexBuffer, 0, indices, indexSize);
+    }
+
+    // still on the transfer queue until this is true, draws skip the mesh instead of waiting
+    [[nodiscard]] bool isReady(Uploader& uploader) const { return uploader.isComplete(uploadTicket); }
+    [[nodiscard]] bool isIndexed() const { return indexCount > 0; }
+
+    // vertex binding 0 and the index buffer
+    void bind(VkCommandBuffer commandBuffer) const {
+        VkDeviceSize offset = 0;
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer.buffer, &offset);
+        if (isIndexed()) vkCmdBindIndexBuffer(commandBuffer, indexBuffer.buffer, 0, indexType);
+    }
+
+    void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const {
+        if (isIndexed()) vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, firstInstance);
+        else vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
+    }
+
+    void destroy(DeletionQueue& deletionQueue) {
+        deletionQueue.retireBuffer(vertexBuffer);
+        deletionQueue.retireBuffer(indexBuffer);
+        vertexCount = 0;
+        indexCount = 0;
+    }
+};
+
+#endif //CITRINE_MESH_H
@@ -0,0 +1,87 @@
+#include "ParallelRecorder.h"
+
+void ParallelRecorder::create(uint32_t sliceCount) {
+    if (sliceCount == 0) sliceCount = win.jobs.threadCount();
+    
+    VkCommandPoolCreateInfo poolCreateInfo{};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolCreateInfo.queueFamilyIndex = win.device.vkQueueFamilyIndices.graphics.value();
+    
+    sliceFrames.resize(sliceCount);
+    for (auto& frames: sliceFrames) {
+        frames.resize(win.commandPool.maxFramesInFlight);
+        for (auto& frame: frames) VkCheck(vkCreateCommandPool(win.device.device, &poolCreateInfo, nullptr, &frame.pool), "vkCreateCommandPool (ParallelRecorder.cpp)");
+    }
+}
+
+void ParallelRecorder::destroy() {
+    for (auto& frames: sliceFrames)
+        for (auto& frame: frames) vkDestroyCommandPool(win.device.device, frame.pool, nullptr);
+    sliceFrames.clear();
+}
+
+void ParallelRecorder::beginFrame() {
+    // the frame that used this slot before finished (VkWindow waited on its timeline value), nothing recorded from these pools is executing anymore
+    for (auto& frames: sliceFrames) {
+        SliceFrame& frame = frames[win.commandPool.currentFrameIndex];
+        vkResetCommandPool(win.device.device, frame.pool, 0);
+        frame.used = 0;
+    }
+}
+
+CommandBuffer& ParallelRecorder::nextSecondary(uint32_t slice) {
+    SliceFrame& frame = sliceFrames[slice][win.commandPool.currentFrameIndex];
+    if (frame.used == frame.secondaries.size()) {
+        CommandBuffer buffer{};
+        buffer.create(frame.pool, win.device.device, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+        frame.secondaries.push_back(buffer);
+    }
+    return frame.secondaries[frame.used++];
+}
+
+void ParallelRecorder::recordSlice(uint32_t slice, const RenderPass& pass, uint32_t begin, uint32_t end, RecordFunction function, void* context) {
+    CITRINE_PROFILE_SCOPE("record slice");
+    CommandBuffer& commandBuffer = nextSecondary(slice);
+    
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = pass.renderPass;
+    inheritanceInfo.subpass = 0;
+    
+    // dynamic rendering: no render pass or framebuffer, the secondary inherits the attachment formats instead
+    VkCommandBufferInheritanceRenderingInfo renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachmentFormats = &pass.colorFormat;
+    renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    if (pass.dynamicRendering) inheritanceInfo.pNext = &renderingInfo;
+    else inheritanceInfo.framebuffer = win.swapChain.swapChainFramebuffers[win.swapChain.currentImageIndex];
+    
+    commandBuffer.recordSecondary(inheritanceInfo);
+    pass.setDynamicState(commandBuffer.vk);
+    function(context, commandBuffer.vk, begin, end);
+    commandBuffer.end();
+    
+    recorded[slice] = commandBuffer.vk;
+}
+
+void ParallelRecorder::record(const RenderPass& renderPass, uint32_t count, RecordFunction function, void* context) {
+    if (count == 0) return;
+    
+    uint32_t slices = sliceCount();
+    uint32_t batchSize = (count + slices - 1) / slices;
+    // slices that get no work stay null
+    recorded = win.frameArena().allocate<VkCommandBuffer>(slices);
+    
+    // the calling thread records slices as well while it waits
+    win.jobs.parallelFor(count, batchSize, [&](uint32_t begin, uint32_t end) {
+        recordSlice(begin / batchSize, renderPass, begin, end, function, context);
+    });
+    
+    // keep the draw list order: slices are executed in order
+    uint32_t executeCount = 0;
+    for (VkCommandBuffer commandBuffer: recorded) 
+        if (commandBuffer != VK_NULL_HANDLE) recorded[executeCount++] = commandBuffer;
+    if (executeCount != 0) vkCmdExecuteCommands(win.commandPool.currentCommandBuffer().vk, executeCount, recorded.data());
+}
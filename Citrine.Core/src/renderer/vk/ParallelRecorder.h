@@ -0,0 +1,55 @@
+#ifndef CITRINE_PARALLELRECORDER_H
+#define CITRINE_PARALLELRECORDER_H
+
+#include "VkHelper.h"
+#include <vector>
+#include <span>
+#include "VkWindow.h"
+#include "RenderPass.h"
+
+// records slices of a draw list as jobs into secondary command buffers, which are then executed inside
+// the current render pass. every slice owns one command pool per frame in flight, reset as a whole.
+// the render pass has to be started with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS (with dynamic rendering
+// RenderPass turns that into VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT).
+class ParallelRecorder {
+public:
+    // records items [begin, end) of the draw list into commandBuffer
+    using RecordFunction = void(*)(void* context, VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end);
+
+private:
+    struct SliceFrame {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<CommandBuffer> secondaries;
+        uint32_t used = 0;
+    };
+
+    VkWindow& win;
+    // [slice][frame in flight]. pools are bound to slices, not threads, so any job thread can record a slice
+    std::vector<std::vector<SliceFrame>> sliceFrames;
+    // one per slice, from the frame arena for the duration of a record()
+    std::span<VkCommandBuffer> recorded;
+
+    CommandBuffer& nextSecondary(uint32_t slice);
+    void recordSlice(uint32_t slice, const RenderPass& pass, uint32_t begin, uint32_t end, RecordFunction function, void* context);
+public:
+    explicit ParallelRecorder(VkWindow& window) : win(window) {}
+
+    // sliceCount defaults to one slice per job system thread
+    void create(uint32_t sliceCount = 0);
+    void destroy();
+
+    // resets this frame's pools, call after VkWindow::startCommandBuffer
+    void beginFrame();
+    void record(const RenderPass& renderPass, uint32_t count, RecordFunction function, void* context);
+
+    template<typename F>
+    void record(const RenderPass& renderPass, uint32_t count, F& function) {
+        record(renderPass, count, [](void* context, VkCommandBuffer commandBuffer, uint32_t begin, uint32_t end) {
+            (*static_cast<F*>(context))(commandBuffer, begin, end);
+        }, &function);
+    }
+
+    [[nodiscard]] uint32_t sliceCount() const { return sliceFrames.size(); }
+};
+
+#endif //CITRINE_PARALLELRECORDER_H
@@ -7,7 +7,7 @@
 struct PhysicalDevice {
 private:
     void chooseDevice(const std::vector<VkPhysicalDevice>& devices) {
-        VkPhysicalDevice bestDevice = devices[0];
+        VkPhysicalDevice bestDevice = VK_NULL_HANDLE;
         uint32_t bestDevicePoints = 0;
 
         for (const auto &device: devices) {
@@ -16,24 +16,25 @@ private:
             VkPhysicalDeviceFeatures deviceFeatures;
             vkGetPhysicalDeviceProperties(device, &deviceProperties);
             vkGetPhysicalDeviceFeatures(device, &deviceFeatures);
+            // timeline semaphores and the allocator's *2 queries are core there, nothing loads their extension variants
+            if (deviceProperties.apiVersion < VK_API_VERSION_1_2) {
+                std::cout << "skipped GPU " << deviceProperties.deviceName << ", vulkan 1." << VK_API_VERSION_MINOR(deviceProperties.apiVersion) << " (1.2 required)\n";
+                continue;
+            }
 
             if (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU) currentPoints += 1000;
             if (deviceFeatures.geometryShader) currentPoints += 1000;
             
             // add points from memory size
-            VkPhysicalDeviceMemoryProperties memoryProperties;
-            vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
-            uint64_t memory = 0;
-            for (int i = 0; i < memoryProperties.memoryHeapCount; ++i) 
-                if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
-                    memory += memoryProperties.memoryHeaps[i].size;
+            uint64_t memory = deviceLocalMemory(device);
             currentPoints += memory >> 22;
 
             std::cout << "found GPU " << deviceProperties.deviceName << ", mem:" << (memory / 1024 / 1024) << "mb\n";
-            if (currentPoints <= bestDevicePoints) continue;
+            if (bestDevice != VK_NULL_HANDLE && currentPoints <= bestDevicePoints) continue;
             bestDevice = device;
             bestDevicePoints = currentPoints;
         }
+        if (bestDevice == VK_NULL_HANDLE) throw std::runtime_error("no GPUs with vulkan 1.2 found (PhysicalDevice.h)");
         
         physicalDevice = bestDevice;
         vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
@@ -46,6 +47,17 @@ public:
     VkPhysicalDeviceProperties physicalDeviceProperties;
     VkPhysicalDeviceFeatures physicalDeviceFeatures;
     
+    // sum of the device local heaps
+    static uint64_t deviceLocalMemory(VkPhysicalDevice device) {
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+        uint64_t memory = 0;
+        for (int i = 0; i < memoryProperties.memoryHeapCount; ++i) 
+            if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                memory += memoryProperties.memoryHeaps[i].size;
+        return memory;
+    }
+    
     void create(VkInstance instance) {
         uint32_t deviceCount = 0;
         vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
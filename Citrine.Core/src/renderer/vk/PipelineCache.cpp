@@ -0,0 +1,80 @@
+#include "PipelineCache.h"
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+std::vector<char> PipelineCache::readCacheFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) return {};
+
+    size_t size = file.tellg();
+    std::vector<char> buffer(size);
+
+    file.seekg(0);
+    file.read(buffer.data(), (std::streamsize) size);
+    if (!file) return {};
+    return buffer;
+}
+
+bool PipelineCache::isCompatible(const std::vector<char>& data) const {
+    // VkPipelineCacheHeaderVersionOne: headerSize, headerVersion, vendorID, deviceID, pipelineCacheUUID
+    constexpr size_t headerSize = 16 + VK_UUID_SIZE;
+    if (data.size() < headerSize) return false;
+
+    uint32_t header[4];
+    memcpy(header, data.data(), sizeof(header));
+    if (header[0] < headerSize || header[0] > data.size()) return false;
+    if (header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) return false;
+    if (header[2] != deviceProperties.vendorID || header[3] != deviceProperties.deviceID) return false;
+    return memcmp(data.data() + 16, deviceProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+void PipelineCache::create(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice, const std::string& cachePath) {
+    device = logicalDevice.device;
+    deviceProperties = physicalDevice.physicalDeviceProperties;
+    path = cachePath;
+
+    std::vector<char> data = readCacheFile(path);
+    if (!data.empty() && !isCompatible(data)) {
+        std::cout << "pipeline cache '" << path << "' was made for another device or driver, ignoring it\n";
+        data.clear();
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData = data.empty() ? nullptr : data.data();
+    VkCheck(vkCreatePipelineCache(device, &createInfo, nullptr, &cache), "vkCreatePipelineCache (PipelineCache.cpp)");
+
+    if (!data.empty()) std::cout << "loaded pipeline cache '" << path << "' (" << data.size() / 1024 << "kb)\n";
+}
+
+void PipelineCache::save() const {
+    size_t size = 0;
+    VkCheck(vkGetPipelineCacheData(device, cache, &size, nullptr), "vkGetPipelineCacheData#1 (PipelineCache.cpp)");
+    std::vector<char> data(size);
+    VkCheck(vkGetPipelineCacheData(device, cache, &size, data.data()), "vkGetPipelineCacheData#2 (PipelineCache.cpp)");
+
+    // write next to the target and rename, so a crash mid-write never leaves a truncated cache behind
+    std::string tmpPath = path + ".tmp";
+    std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cout << "failed to write pipeline cache '" << tmpPath << "'\n";
+        return;
+    }
+    file.write(data.data(), (std::streamsize) size);
+    file.close();
+    // a full disk shows up here, the old cache stays and the partial one goes
+    if (!file) {
+        std::cout << "failed to write pipeline cache '" << tmpPath << "'\n";
+        std::remove(tmpPath.c_str());
+        return;
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) std::cout << "failed to replace pipeline cache '" << path << "'\n";
+}
+
+void PipelineCache::destroy() {
+    save();
+    vkDestroyPipelineCache(device, cache, nullptr);
+}
@@ -0,0 +1,29 @@
+#ifndef CITRINE_PIPELINECACHE_H
+#define CITRINE_PIPELINECACHE_H
+
+#include "VkHelper.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+
+// VkPipelineCache persisted on disk. the file is only used when its header matches the current device
+// (vendor, device and pipelineCacheUUID), otherwise the cache starts empty and is overwritten on save.
+class PipelineCache {
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    VkPhysicalDeviceProperties deviceProperties{};
+    std::string path;
+
+    [[nodiscard]] bool isCompatible(const std::vector<char>& data) const;
+    static std::vector<char> readCacheFile(const std::string& filename);
+public:
+    VkPipelineCache cache = VK_NULL_HANDLE;
+
+    void create(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice, const std::string& cachePath = "pipeline_cache.bin");
+    void save() const;
+    void destroy();
+};
+
+#endif //CITRINE_PIPELINECACHE_H
@@ -0,0 +1,436 @@
+#include "PipelineRegistry.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+namespace {
+    // FNV-1a, good enough for pipeline keys (a handful to a few thousand entries)
+    struct Hasher {
+        uint64_t value = 14695981039346656037ull;
+
+        void bytes(const void* data, size_t size) {
+            auto p = static_cast<const unsigned char*>(data);
+            for (size_t i = 0; i < size; ++i) {
+                value ^= p[i];
+                value *= 1099511628211ull;
+            }
+        }
+
+        void add(uint64_t v) { bytes(&v, sizeof(v)); }
+    };
+}
+
+uint64_t PipelineDescription::hash() const {
+    Hasher h;
+    h.add(vertexShaderCode.size());
+    h.bytes(vertexShaderCode.data(), vertexShaderCode.size());
+    h.add(fragmentShaderCode.size());
+    h.bytes(fragmentShaderCode.data(), fragmentShaderCode.size());
+
+    h.add(bindings.size());
+    for (const auto& binding: bindings) {
+        h.add(binding.binding);
+        h.add(binding.stride);
+        h.add(binding.inputRate);
+    }
+    h.add(attributes.size());
+    for (const auto& attribute: attributes) {
+        h.add(attribute.location);
+        h.add(attribute.binding);
+        h.add(attribute.format);
+        h.add(attribute.offset);
+    }
+    h.add(textureCount);
+
+    h.add(topology);
+    h.add(polygonMode);
+    h.add(cullMode);
+    h.add(frontFace);
+    h.add(samples);
+    h.add(depthTest);
+    h.add(depthWrite);
+    h.add(depthCompareOp);
+
+    h.add(blend.blendEnable);
+    h.add(blend.srcColorBlendFactor);
+    h.add(blend.dstColorBlendFactor);
+    h.add(blend.colorBlendOp);
+    h.add(blend.srcAlphaBlendFactor);
+    h.add(blend.dstAlphaBlendFactor);
+    h.add(blend.alphaBlendOp);
+    h.add(blend.colorWriteMask);
+
+    h.add(renderPassKey);
+    h.add(subpass);
+    // pipelines for dynamic rendering can't be used inside render pass objects and the other way around
+    h.add(colorFormats.size());
+    for (VkFormat format: colorFormats) h.add(format);
+    h.add(depthFormat);
+    return h.value;
+}
+
+bool PipelineDescription::operator==(const PipelineDescription& other) const {
+    auto sameBinding = [](const VkVertexInputBindingDescription& a, const VkVertexInputBindingDescription& b) {
+        return a.binding == b.binding && a.stride == b.stride && a.inputRate == b.inputRate;
+    };
+    auto sameAttribute = [](const VkVertexInputAttributeDescription& a, const VkVertexInputAttributeDescription& b) {
+        return a.location == b.location && a.binding == b.binding && a.format == b.format && a.offset == b.offset;
+    };
+    return std::ranges::equal(vertexShaderCode, other.vertexShaderCode) && std::ranges::equal(fragmentShaderCode, other.fragmentShaderCode)
+           && std::ranges::equal(bindings, other.bindings, sameBinding) && std::ranges::equal(attributes, other.attributes, sameAttribute)
+           && textureCount == other.textureCount
+           && topology == other.topology && polygonMode == other.polygonMode && cullMode == other.cullMode && frontFace == other.frontFace
+           && samples == other.samples && depthTest == other.depthTest && depthWrite == other.depthWrite && depthCompareOp == other.depthCompareOp
+           && std::memcmp(&blend, &other.blend, sizeof(blend)) == 0
+           && renderPassKey == other.renderPassKey && subpass == other.subpass && colorFormats == other.colorFormats && depthFormat == other.depthFormat;
+}
+
+void PipelineRegistry::Registered::setDescription(const PipelineDescription& source) {
+    description = source;
+    vertexShaderCode.assign(source.vertexShaderCode.begin(), source.vertexShaderCode.end());
+    fragmentShaderCode.assign(source.fragmentShaderCode.begin(), source.fragmentShaderCode.end());
+    description.vertexShaderCode = vertexShaderCode;
+    description.fragmentShaderCode = fragmentShaderCode;
+}
+
+void PipelineRegistry::create(LogicalDevice& logicalDevice, PipelineCache& pipelineCache, JobSystem& jobSystem, DeletionQueue& deletions) {
+    device = logicalDevice.device;
+    cache = pipelineCache.cache;
+    jobs = &jobSystem;
+    deletionQueue = &deletions;
+}
+
+void PipelineRegistry::destroy() {
+    // compile jobs reference the registry, let them run out (and help, the workers may be busy elsewhere)
+    while (compilesInFlight.load() > 0) {
+        if (!jobs->helpOnce()) std::this_thread::yield();
+    }
+
+    for (auto& [key, registered]: pipelines) {
+        const PipelineEntry& entry = registered.entry;
+        if (registered.tombstone || entry.pending || entry.failed) continue;
+        vkDestroyPipeline(device, entry.pipeline, nullptr);
+        vkDestroyPipelineLayout(device, entry.layout, nullptr);
+    }
+    pipelines.clear();
+    tombstones = 0;
+    
+    for (auto& [count, layout]: textureSetLayouts) vkDestroyDescriptorSetLayout(device, layout, nullptr);
+    textureSetLayouts.clear();
+}
+
+VkDescriptorSetLayout PipelineRegistry::textureSetLayout(uint32_t textureCount) const {
+    std::lock_guard lock(layoutMutex);
+    auto it = textureSetLayouts.find(textureCount);
+    if (it != textureSetLayouts.end()) return it->second;
+    
+    std::vector<VkDescriptorSetLayoutBinding> bindings(textureCount);
+    for (uint32_t i = 0; i < textureCount; ++i) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    createInfo.bindingCount = bindings.size();
+    createInfo.pBindings = bindings.data();
+    VkDescriptorSetLayout layout;
+    VkCheck(vkCreateDescriptorSetLayout(device, &createInfo, nullptr, &layout), "vkCreateDescriptorSetLayout (PipelineRegistry.cpp)");
+    textureSetLayouts.emplace(textureCount, layout);
+    return layout;
+}
+
+VkShaderModule PipelineRegistry::createShaderModule(std::span<const char> src) const {
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = src.size();
+    createInfo.pCode = reinterpret_cast<const uint32_t*>(src.data());
+
+    VkShaderModule shaderModule;
+    VkCheck(vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule), "vkCreateShaderModule (PipelineRegistry.cpp)")
+    return shaderModule;
+}
+
+PipelineEntry PipelineRegistry::build(const PipelineDescription& description) const {
+    // VkCheck throws, whatever was created before a failing call goes with the guard. the layout is kept on success
+    struct Created {
+        VkDevice device;
+        VkShaderModule vertexShader = VK_NULL_HANDLE;
+        VkShaderModule fragmentShader = VK_NULL_HANDLE;
+        VkPipelineLayout layout = VK_NULL_HANDLE;
+
+        ~Created() {
+            vkDestroyShaderModule(device, vertexShader, nullptr);
+            vkDestroyShaderModule(device, fragmentShader, nullptr);
+            vkDestroyPipelineLayout(device, layout, nullptr);
+        }
+    } created{device};
+    VkShaderModule vertexShader = created.vertexShader = createShaderModule(description.vertexShaderCode);
+    VkShaderModule fragmentShader = created.fragmentShader = createShaderModule(description.fragmentShaderCode);
+
+    VkPipelineShaderStageCreateInfo vertCreateInfo{};
+    vertCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vertCreateInfo.module = vertexShader;
+    vertCreateInfo.pName = "main";
+
+    VkPipelineShaderStageCreateInfo fragCreateInfo{};
+    fragCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    fragCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    fragCreateInfo.module = fragmentShader;
+    fragCreateInfo.pName = "main";
+
+    VkPipelineVertexInputStateCreateInfo vertInputCreateInfo{};
+    vertInputCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertInputCreateInfo.vertexBindingDescriptionCount = description.bindings.size();
+    vertInputCreateInfo.pVertexBindingDescriptions = description.bindings.data();
+    vertInputCreateInfo.vertexAttributeDescriptionCount = description.attributes.size();
+    vertInputCreateInfo.pVertexAttributeDescriptions = description.attributes.data();
+
+    VkPipelineInputAssemblyStateCreateInfo inputAsmCreateInfo{};
+    inputAsmCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAsmCreateInfo.topology = description.topology;
+    inputAsmCreateInfo.primitiveRestartEnable = false;
+
+    // viewport and scissor are dynamic (set in RenderPass::startRenderPass), so the pipeline survives swapchain resizes
+    VkPipelineViewportStateCreateInfo viewportCreateInfo{};
+    viewportCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportCreateInfo.viewportCount = 1;
+    viewportCreateInfo.scissorCount = 1;
+
+    VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+    VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo{};
+    dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicStateCreateInfo.dynamicStateCount = 2;
+    dynamicStateCreateInfo.pDynamicStates = dynamicStates;
+
+    VkPipelineRasterizationStateCreateInfo rasterizerCreateInfo{};
+    rasterizerCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizerCreateInfo.depthClampEnable = false;
+    rasterizerCreateInfo.polygonMode = description.polygonMode;
+    rasterizerCreateInfo.cullMode = description.cullMode;
+    rasterizerCreateInfo.frontFace = description.frontFace;
+    rasterizerCreateInfo.depthBiasEnable = false;
+    rasterizerCreateInfo.lineWidth = 1;
+
+    VkPipelineMultisampleStateCreateInfo multisampleCreateInfo{};
+    multisampleCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampleCreateInfo.sampleShadingEnable = false;
+    multisampleCreateInfo.rasterizationSamples = description.samples;
+
+    VkPipelineColorBlendStateCreateInfo colorBlendingCreateInfo{};
+    colorBlendingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlendingCreateInfo.logicOpEnable = false;
+    colorBlendingCreateInfo.attachmentCount = 1;
+    colorBlendingCreateInfo.pAttachments = &description.blend;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencilCreateInfo{};
+    depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencilCreateInfo.depthTestEnable = description.depthTest;
+    depthStencilCreateInfo.depthWriteEnable = description.depthWrite;
+    depthStencilCreateInfo.depthCompareOp = description.depthCompareOp;
+
+    PipelineEntry entry{};
+    VkPipelineLayoutCreateInfo layoutCreateInfo{};
+    layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    if (description.textureCount > 0) {
+        setLayout = textureSetLayout(description.textureCount);
+        layoutCreateInfo.setLayoutCount = 1;
+        layoutCreateInfo.pSetLayouts = &setLayout;
+    }
+    VkCheck(vkCreatePipelineLayout(device, &layoutCreateInfo, nullptr, &entry.layout), "vkCreatePipelineLayout (PipelineRegistry.cpp)");
+    created.layout = entry.layout;
+
+    VkPipelineShaderStageCreateInfo stages[] = {vertCreateInfo, fragCreateInfo};
+
+    VkGraphicsPipelineCreateInfo pipelineCreateInfo{};
+    pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineCreateInfo.stageCount = 2;
+    pipelineCreateInfo.pStages = stages;
+    pipelineCreateInfo.pVertexInputState = &vertInputCreateInfo;
+    pipelineCreateInfo.pInputAssemblyState = &inputAsmCreateInfo;
+    pipelineCreateInfo.pViewportState = &viewportCreateInfo;
+    pipelineCreateInfo.pRasterizationState = &rasterizerCreateInfo;
+    pipelineCreateInfo.pMultisampleState = &multisampleCreateInfo;
+    pipelineCreateInfo.pDepthStencilState = &depthStencilCreateInfo;
+    pipelineCreateInfo.pColorBlendState = &colorBlendingCreateInfo;
+    pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
+
+    pipelineCreateInfo.layout = entry.layout;
+    pipelineCreateInfo.renderPass = description.renderPass;
+    pipelineCreateInfo.subpass = description.subpass;
+
+    VkPipelineRenderingCreateInfo renderingCreateInfo{};
+    renderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    renderingCreateInfo.colorAttachmentCount = description.colorFormats.size();
+    renderingCreateInfo.pColorAttachmentFormats = description.colorFormats.data();
+    renderingCreateInfo.depthAttachmentFormat = description.depthFormat;
+    renderingCreateInfo.stencilAttachmentFormat = VkHelper::hasStencil(description.depthFormat) ? description.depthFormat : VK_FORMAT_UNDEFINED;
+    if (description.renderPass == VK_NULL_HANDLE) pipelineCreateInfo.pNext = &renderingCreateInfo;
+
+    VkCheck(vkCreateGraphicsPipelines(device, cache, 1, &pipelineCreateInfo, nullptr, &entry.pipeline), "vkCreateGraphicsPipelines (PipelineRegistry.cpp)");
+
+    // the modules aren't needed once the pipeline exists
+    created.layout = VK_NULL_HANDLE;
+    return entry;
+}
+
+PipelineRegistry::PipelineMap::iterator PipelineRegistry::find(const PipelineDescription& description, uint64_t& key) {
+    key = description.hash();
+    std::optional<uint64_t> reusable;
+    auto it = pipelines.find(key);
+    while (it != pipelines.end()) {
+        if (!it->second.tombstone && it->second.description == description) return it;
+        // the first tombstone takes a new entry, the search still has to go on until the chain ends
+        if (it->second.tombstone && !reusable) reusable = key;
+        it = pipelines.find(++key);
+    }
+    if (reusable) key = *reusable;
+    return it;
+}
+
+PipelineRegistry::Registered& PipelineRegistry::insert(uint64_t key) {
+    Registered& registered = pipelines.try_emplace(key).first->second;
+    if (registered.tombstone) {
+        registered.tombstone = false;
+        tombstones--;
+    }
+    return registered;
+}
+
+void PipelineRegistry::erase(PipelineMap::iterator it) {
+    uint64_t key = it->first;
+    // probing stops at the first missing key, erasing this one would hide every entry behind it
+    if (pipelines.contains(key + 1)) {
+        Registered& registered = it->second;
+        registered.entry = {};
+        registered.tombstone = true;
+        registered.description = {};
+        registered.vertexShaderCode = {};
+        registered.fragmentShaderCode = {};
+        tombstones++;
+        return;
+    }
+
+    pipelines.erase(it);
+    // the chain ends here now, tombstones right in front of it guard nothing anymore
+    for (auto previous = pipelines.find(--key); previous != pipelines.end() && previous->second.tombstone; previous = pipelines.find(--key)) {
+        pipelines.erase(previous);
+        tombstones--;
+    }
+}
+
+PipelineEntry PipelineRegistry::acquire(const PipelineDescription& description, uint64_t& key) {
+    std::unique_lock lock(mutex);
+    auto it = find(description, key);
+    if (it == pipelines.end()) {
+        // built without the lock, other threads keep acquiring and publishing meanwhile
+        lock.unlock();
+        PipelineEntry built = build(description);
+        lock.lock();
+
+        it = find(description, key);
+        if (it != pipelines.end()) {
+            // someone else registered it first, theirs is shared and ours goes
+            discard(built);
+        } else {
+            Registered& registered = insert(key);
+            registered.entry = built;
+            registered.setDescription(description);
+            registered.entry.refCount++;
+            return registered.entry;
+        }
+    }
+    it->second.entry.refCount++;
+    // may still be pending when it was requested async before, callers then go through tryGet() as well
+    return it->second.entry;
+}
+
+PipelineEntry PipelineRegistry::acquireAsync(const PipelineDescription& description, uint64_t& key) {
+    std::unique_lock lock(mutex);
+    auto it = find(description, key);
+    if (it != pipelines.end()) {
+        it->second.entry.refCount++;
+        return it->second.entry;
+    }
+
+    PipelineEntry entry{};
+    entry.pending = true;
+    entry.refCount = 1;
+    Registered& registered = insert(key);
+    registered.entry = entry;
+    registered.generation = ++nextGeneration;
+    registered.setDescription(description);
+
+    auto job = std::make_unique<CompileJob>();
+    job->key = key;
+    job->generation = registered.generation;
+    job->description = description;
+    job->vertexShaderCode.assign(description.vertexShaderCode.begin(), description.vertexShaderCode.end());
+    job->fragmentShaderCode.assign(description.fragmentShaderCode.begin(), description.fragmentShaderCode.end());
+    job->description.vertexShaderCode = job->vertexShaderCode;
+    job->description.fragmentShaderCode = job->fragmentShaderCode;
+    lock.unlock();
+
+    compilesInFlight.fetch_add(1);
+    jobs->run(jobs->createJob([this, compileJob = job.release()] { compile(std::unique_ptr<CompileJob>(compileJob)); }));
+    return entry;
+}
+
+bool PipelineRegistry::tryGet(uint64_t key, PipelineEntry& entry) {
+    std::lock_guard lock(mutex);
+    auto it = pipelines.find(key);
+    if (it == pipelines.end() || it->second.tombstone || it->second.entry.pending || it->second.entry.failed) return false;
+    entry = it->second.entry;
+    return true;
+}
+
+void PipelineRegistry::compile(std::unique_ptr<CompileJob> job) {
+    PipelineEntry built{};
+    bool failed = false;
+    try {
+        built = build(job->description);
+    } catch (const std::exception& e) {
+        std::cout << "async pipeline compilation failed: " << e.what() << "\n";
+        failed = true;
+    }
+    publish(job->key, job->generation, built, failed);
+    compilesInFlight.fetch_sub(1);
+}
+
+void PipelineRegistry::discard(const PipelineEntry& built) const {
+    vkDestroyPipeline(device, built.pipeline, nullptr);
+    vkDestroyPipelineLayout(device, built.layout, nullptr);
+}
+
+void PipelineRegistry::publish(uint64_t key, uint64_t generation, const PipelineEntry& built, bool failed) {
+    std::lock_guard lock(mutex);
+    auto it = pipelines.find(key);
+    // released while it was compiling. the key may already hold a new entry (acquired again, maybe with a job of its
+    // own, or a different description after a collision), which this result must not overwrite
+    if (it == pipelines.end() || !it->second.entry.pending || it->second.generation != generation) {
+        if (!failed) discard(built);
+        return;
+    }
+
+    it->second.entry.pipeline = built.pipeline;
+    it->second.entry.layout = built.layout;
+    it->second.entry.pending = false;
+    it->second.entry.failed = failed;
+}
+
+void PipelineRegistry::release(uint64_t key) {
+    std::lock_guard lock(mutex);
+    auto it = pipelines.find(key);
+    if (it == pipelines.end() || it->second.tombstone || --it->second.entry.refCount > 0) return;
+    
+    // a pending entry is dropped here, the compile job destroys the result when it finds its entry gone
+    if (!it->second.entry.pending && !it->second.entry.failed) {
+        deletionQueue->retirePipeline(it->second.entry.pipeline);
+        deletionQueue->retirePipelineLayout(it->second.entry.layout);
+    }
+    erase(it);
+}
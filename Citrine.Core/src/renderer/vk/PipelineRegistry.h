@@ -0,0 +1,140 @@
+#ifndef CITRINE_PIPELINEREGISTRY_H
+#define CITRINE_PIPELINEREGISTRY_H
+
+#include "VkHelper.h"
+#include <vector>
+#include <span>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <unordered_map>
+#include "LogicalDevice.h"
+#include "PipelineCache.h"
+#include "DeletionQueue.h"
+#include "../../core/JobSystem.h"
+
+// full state of a graphics pipeline. shader code is borrowed, it only has to outlive the acquire() call.
+struct PipelineDescription {
+    std::span<const char> vertexShaderCode;
+    std::span<const char> fragmentShaderCode;
+    std::vector<VkVertexInputBindingDescription> bindings;
+    std::vector<VkVertexInputAttributeDescription> attributes;
+    // combined image samplers the fragment shader reads from set 0, bindings 0..textureCount - 1
+    uint32_t textureCount = 0;
+
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace frontFace = VK_FRONT_FACE_CLOCKWISE;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    // only read when the subpass has a depth attachment
+    bool depthTest = false;
+    bool depthWrite = false;
+    VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+    VkPipelineColorBlendAttachmentState blend{
+        false,
+        VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD,
+        VK_BLEND_FACTOR_ONE, VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD,
+        VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+    };
+
+    // pipelines are usable with any compatible render pass, so only the compatibility key is hashed, not the handle
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    uint64_t renderPassKey = 0;
+    uint32_t subpass = 0;
+    // dynamic rendering: renderPass stays VK_NULL_HANDLE and the pipeline is made for these attachment formats
+    std::vector<VkFormat> colorFormats;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+    [[nodiscard]] uint64_t hash() const;
+    // the state hash() covers (the render pass handle isn't), shader code by content
+    [[nodiscard]] bool operator==(const PipelineDescription& other) const;
+};
+
+struct PipelineEntry {
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    uint32_t refCount = 0;
+    // async entries stay pending until the compile job published the pipeline, failed ones never become ready
+    bool pending = false;
+    bool failed = false;
+};
+
+// creates every distinct pipeline state once (through the persistent cache) and shares it between users.
+// pipelines can also be compiled as jobs on the job system, so new materials never block the frame thread.
+class PipelineRegistry {
+private:
+    // description with its own copy of the shader code, spans point into the vectors
+    struct CompileJob {
+        uint64_t key;
+        uint64_t generation;
+        PipelineDescription description;
+        std::vector<char> vertexShaderCode;
+        std::vector<char> fragmentShaderCode;
+    };
+
+    // a pipeline and the description it was made from, with its own copy of the shader code so lookups can compare
+    // against it. never moved once in the map, the spans point into the vectors
+    struct Registered {
+        PipelineEntry entry;
+        // the compile job a pending entry waits for, results of jobs for an entry released in between are dropped
+        uint64_t generation = 0;
+        // released, but kept so probing (see find()) still reaches the keys after it. reused by the next insert
+        bool tombstone = false;
+        PipelineDescription description;
+        std::vector<char> vertexShaderCode;
+        std::vector<char> fragmentShaderCode;
+
+        void setDescription(const PipelineDescription& source);
+    };
+    using PipelineMap = std::unordered_map<uint64_t, Registered>;
+
+    VkDevice device = VK_NULL_HANDLE;
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    PipelineMap pipelines;
+    uint64_t nextGeneration = 0;
+    size_t tombstones = 0;
+    std::mutex mutex;
+
+    // set 0 of textured pipelines, shared by every pipeline with the same texture count so their sets are interchangeable
+    mutable std::unordered_map<uint32_t, VkDescriptorSetLayout> textureSetLayouts;
+    mutable std::mutex layoutMutex;
+
+    JobSystem* jobs = nullptr;
+    DeletionQueue* deletionQueue = nullptr;
+    std::atomic<uint32_t> compilesInFlight = 0;
+
+    [[nodiscard]] VkShaderModule createShaderModule(std::span<const char> src) const;
+    // with mutex held: the entry made from description, or end() with key set to where it goes. key starts at the
+    // hash, a different description under it (a collision) or a tombstone moves on to the next key
+    PipelineMap::iterator find(const PipelineDescription& description, uint64_t& key);
+    // with mutex held: the slot at key (from a find() that returned end()), a reused tombstone or a new one
+    Registered& insert(uint64_t key);
+    // with mutex held: drops a released entry, or leaves a tombstone when a later key may be on its probe chain
+    void erase(PipelineMap::iterator it);
+    void compile(std::unique_ptr<CompileJob> job);
+    void publish(uint64_t key, uint64_t generation, const PipelineEntry& built, bool failed);
+    // destroys a built pipeline that never made it into the map
+    void discard(const PipelineEntry& built) const;
+public:
+    void create(LogicalDevice& logicalDevice, PipelineCache& pipelineCache, JobSystem& jobSystem, DeletionQueue& deletions);
+    void destroy();
+
+    // creates the pipeline and its layout from the description, not registered anywhere
+    [[nodiscard]] PipelineEntry build(const PipelineDescription& description) const;
+
+    // returns the shared pipeline for the description, creating it on first use. the key is written to key
+    PipelineEntry acquire(const PipelineDescription& description, uint64_t& key);
+    // same as acquire, but never compiles on the calling thread: a missing pipeline is compiled as a job
+    // and the returned entry stays pending until tryGet() sees it published
+    PipelineEntry acquireAsync(const PipelineDescription& description, uint64_t& key);
+    // non blocking, true once the pipeline for key is ready
+    bool tryGet(uint64_t key, PipelineEntry& entry);
+    // the last release retires the pipeline, frames in flight may still draw with it
+    void release(uint64_t key);
+    [[nodiscard]] size_t size() const { return pipelines.size() - tombstones; }
+    // layout of set 0 for pipelines with textureCount textures (PipelineDescription::textureCount), owned by the registry
+    VkDescriptorSetLayout textureSetLayout(uint32_t textureCount) const;
+};
+
+#endif //CITRINE_PIPELINEREGISTRY_H
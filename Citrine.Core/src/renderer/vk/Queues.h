@@ -2,39 +2,43 @@
 #define CITRINE_QUEUES_H
 
 #include "VkHelper.h"
-#include <vector>
+#include "../../core/Profiler.h"
+#include "SubmitBatch.h"
+#include <span>
 
 struct Queues {
     VkQueue graphics;
     VkQueue present;
+    VkQueue transfer;
     uint32_t graphicsIndex;
     uint32_t presentIndex;
+    uint32_t transferIndex;
     
     void get(VkDevice device) {
         vkGetDeviceQueue(device, graphicsIndex, 0, &graphics);
         vkGetDeviceQueue(device, presentIndex, 0, &present);
+        vkGetDeviceQueue(device, transferIndex, 0, &transfer);
     }
     
-    void Submit(std::vector<VkSemaphore> waitSemaphores, std::vector<VkSemaphore> signalSemaphores, VkFence inFlightFence, VkCommandBuffer commandBuffer) {
+    [[nodiscard]] bool hasDedicatedTransfer() const { return transferIndex != graphicsIndex; }
+    
+    // everything queued in batch goes out in one vkQueueSubmit on the graphics queue
+    void Submit(SubmitBatch& batch, VkFence fence = VK_NULL_HANDLE) {
+        CITRINE_PROFILE_SCOPE("submit");
+        batch.submit(graphics, fence);
+    }
+    
+    void SubmitTransfer(VkCommandBuffer commandBuffer, VkFence fence) {
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        
-        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-        submitInfo.pWaitDstStageMask = waitStages;
-        
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
-
-        submitInfo.waitSemaphoreCount = waitSemaphores.size();
-        submitInfo.pWaitSemaphores = waitSemaphores.data();
         
-        submitInfo.signalSemaphoreCount = signalSemaphores.size();
-        submitInfo.pSignalSemaphores = signalSemaphores.data();
-
-        VkCheck(vkQueueSubmit(graphics, 1, &submitInfo, inFlightFence), "vkQueueSubmit (Queues.h)");
+        VkCheck(vkQueueSubmit(transfer, 1, &submitInfo, fence), "vkQueueSubmit (Queues.h)");
     }
     
-    bool Present(std::vector<VkSwapchainKHR> swapChains, std::vector<VkSemaphore> signalSemaphores, uint32_t* currentImageIndex) {
+    bool Present(std::span<const VkSwapchainKHR> swapChains, std::span<const VkSemaphore> signalSemaphores, const uint32_t* currentImageIndex) {
+        CITRINE_PROFILE_SCOPE("present");
         VkPresentInfoKHR presentInfo{};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
         presentInfo.waitSemaphoreCount = signalSemaphores.size();
@@ -46,7 +50,7 @@ struct Queues {
         
         VkResult presentResult = vkQueuePresentKHR(present, &presentInfo);
 
-        if (presentResult == VK_ERROR_OUT_OF_DATE_KHR) return false;
+        if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) return false;
         VkCheck(presentResult, "vkQueuePresentKHR (VkWindow.cpp)");
         return true;
     }
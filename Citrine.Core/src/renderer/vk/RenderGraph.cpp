@@ -0,0 +1,512 @@
+#include "RenderGraph.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    using VkHelper::isDepthFormat;
+    using VkHelper::hasStencil;
+
+    constexpr VkAccessFlags writeAccess = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+}
+
+RenderGraph::AccessInfo RenderGraph::accessInfo(Access access) {
+    switch (access) {
+        case Access::ColorWrite:
+            return {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, true};
+        case Access::DepthWrite:
+            return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, true};
+        case Access::Sampled:
+            break;
+    }
+    return {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, false};
+}
+
+RenderGraphImage RenderGraph::importBackbuffer() {
+    for (RenderGraphImage i = 0; i < images.size(); ++i) if (images[i].backbuffer) return i;
+    images.push_back({"backbuffer", VK_FORMAT_UNDEFINED, 1, true});
+    dirty = true;
+    return images.size() - 1;
+}
+
+RenderGraphImage RenderGraph::createImage(const char* name, VkFormat format, float scale) {
+    images.push_back({name, format, scale, false});
+    dirty = true;
+    return images.size() - 1;
+}
+
+RenderGraphPass RenderGraph::addPass(const char* name, ExecuteFunction execute, bool sideEffects) {
+    passes.push_back({name, {}, std::move(execute), sideEffects});
+    dirty = true;
+    return passes.size() - 1;
+}
+
+void RenderGraph::addUse(RenderGraphPass pass, RenderGraphImage image, Access access, const VkClearValue* clearValue) {
+    for (const Use& use: passes[pass].uses) {
+        if (use.image == image) throw std::runtime_error(std::string("pass '") + passes[pass].name + "' uses image '" + images[image].name + "' twice (RenderGraph.cpp)");
+    }
+    Use use{image, access, clearValue != nullptr, {}};
+    if (clearValue != nullptr) use.clearValue = *clearValue;
+    passes[pass].uses.push_back(use);
+    dirty = true;
+}
+
+void RenderGraph::writeColor(RenderGraphPass pass, RenderGraphImage image, const VkClearValue* clearValue) {
+    addUse(pass, image, Access::ColorWrite, clearValue);
+}
+
+void RenderGraph::writeDepth(RenderGraphPass pass, RenderGraphImage image, const VkClearValue* clearValue) {
+    if (images[image].backbuffer || !isDepthFormat(images[image].format)) throw std::runtime_error(std::string("image '") + images[image].name + "' is no depth image (RenderGraph.cpp)");
+    addUse(pass, image, Access::DepthWrite, clearValue);
+}
+
+void RenderGraph::sample(RenderGraphPass pass, RenderGraphImage image) {
+    if (images[image].backbuffer) throw std::runtime_error("the backbuffer can't be sampled (RenderGraph.cpp)");
+    addUse(pass, image, Access::Sampled, nullptr);
+}
+
+void RenderGraph::cullPasses() {
+    // walk backwards, a pass lives when it has side effects or writes something a live later pass needs.
+    // cleared writes end the need for earlier contents, loads and samples extend it
+    std::vector<bool> needed(images.size(), false);
+    for (size_t i = passes.size(); i-- > 0;) {
+        Pass& pass = passes[i];
+        pass.culled = !pass.sideEffects;
+        for (const Use& use: pass.uses) {
+            if (use.access == Access::Sampled) continue;
+            if (images[use.image].backbuffer || needed[use.image]) pass.culled = false;
+        }
+        if (pass.culled) continue;
+
+        for (const Use& use: pass.uses) {
+            if (use.access != Access::Sampled && use.clear) needed[use.image] = false;
+        }
+        for (const Use& use: pass.uses) {
+            if (use.access == Access::Sampled || !use.clear) needed[use.image] = true;
+        }
+    }
+
+    order.clear();
+    for (RenderGraphPass i = 0; i < passes.size(); ++i) {
+        if (passes[i].culled) continue;
+        order.push_back(i);
+        for (const Use& use: passes[i].uses) {
+            ImageResource& image = images[use.image];
+            image.firstPass = std::min(image.firstPass, i);
+            image.lastPass = std::max(image.lastPass, i);
+        }
+    }
+
+    // a live pass reading an image no live pass wrote before it
+    std::vector<bool> written(images.size(), false);
+    for (RenderGraphPass i: order) {
+        for (const Use& use: passes[i].uses) {
+            if (use.access == Access::Sampled && !written[use.image]) throw std::runtime_error(std::string("pass '") + passes[i].name + "' samples '" + images[use.image].name + "' before any pass wrote it (RenderGraph.cpp)");
+        }
+        for (const Use& use: passes[i].uses) written[use.image] = true;
+    }
+}
+
+void RenderGraph::createImages() {
+    VkExtent2D swapExtent = win.swapChain.swapExtent;
+    std::vector<RenderGraphImage> transient;
+    for (RenderGraphImage i = 0; i < images.size(); ++i) {
+        ImageResource& image = images[i];
+        if (image.backbuffer) {
+            image.format = win.swapChain.surfaceFormat.format;
+            image.extent = swapExtent;
+            continue;
+        }
+        if (image.firstPass == UINT32_MAX) continue;
+
+        image.extent = {
+            std::max(1u, static_cast<uint32_t>(std::lround(swapExtent.width * image.scale))),
+            std::max(1u, static_cast<uint32_t>(std::lround(swapExtent.height * image.scale))),
+        };
+        image.usage = 0;
+        for (RenderGraphPass p: order) {
+            for (const Use& use: passes[p].uses) {
+                if (use.image != i) continue;
+                if (use.access == Access::ColorWrite) image.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+                if (use.access == Access::DepthWrite) image.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+                if (use.access == Access::Sampled) image.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+            }
+        }
+
+        VkImageCreateInfo imageCreateInfo{};
+        imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageCreateInfo.format = image.format;
+        imageCreateInfo.extent = {image.extent.width, image.extent.height, 1};
+        imageCreateInfo.mipLevels = 1;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageCreateInfo.usage = image.usage;
+        imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkCheck(vkCreateImage(win.device.device, &imageCreateInfo, nullptr, &image.image.image), "vkCreateImage (RenderGraph.cpp)");
+        transient.push_back(i);
+    }
+
+    // greedy interval packing: in order of first use, an image takes the first slot that is free again
+    // (its last image was last used by an earlier pass) and has a memory type in common
+    std::sort(transient.begin(), transient.end(), [this](RenderGraphImage a, RenderGraphImage b) { return images[a].firstPass < images[b].firstPass; });
+    std::vector<VkMemoryRequirements> requirements(images.size());
+    for (RenderGraphImage i: transient) {
+        ImageResource& image = images[i];
+        vkGetImageMemoryRequirements(win.device.device, image.image.image, &requirements[i]);
+        const VkMemoryRequirements& required = requirements[i];
+
+        uint32_t slot = 0;
+        for (; slot < memorySlots.size(); ++slot) {
+            if (memorySlots[slot].lastPass < image.firstPass && (memorySlots[slot].requirements.memoryTypeBits & required.memoryTypeBits) != 0) break;
+        }
+        if (slot == memorySlots.size()) {
+            memorySlots.push_back({required, 0, {}});
+        } else {
+            VkMemoryRequirements& shared = memorySlots[slot].requirements;
+            shared.size = std::max(shared.size, required.size);
+            shared.alignment = std::max(shared.alignment, required.alignment);
+            shared.memoryTypeBits &= required.memoryTypeBits;
+        }
+        memorySlots[slot].lastPass = image.lastPass;
+        image.memorySlot = slot;
+    }
+
+    for (auto& slot: memorySlots) slot.allocation = win.allocator.allocate(slot.requirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, AllocationKind::Optimal);
+    for (RenderGraphImage i: transient) {
+        ImageResource& image = images[i];
+        const Allocation& allocation = memorySlots[image.memorySlot].allocation;
+        VkCheck(vkBindImageMemory(win.device.device, image.image.image, allocation.memory, allocation.offset), "vkBindImageMemory (RenderGraph.cpp)");
+
+        VkImageViewCreateInfo viewCreateInfo{};
+        viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewCreateInfo.image = image.image.image;
+        viewCreateInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewCreateInfo.format = image.format;
+        viewCreateInfo.subresourceRange.aspectMask = isDepthFormat(image.format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+        viewCreateInfo.subresourceRange.levelCount = 1;
+        viewCreateInfo.subresourceRange.layerCount = 1;
+        VkCheck(vkCreateImageView(win.device.device, &viewCreateInfo, nullptr, &image.view), "vkCreateImageView (RenderGraph.cpp)");
+    }
+}
+
+VkImageView RenderGraph::attachmentView(const ImageResource& image, uint32_t swapChainImage) const {
+    return image.backbuffer ? win.swapChain.swapChainImageViews[swapChainImage] : image.view;
+}
+
+void RenderGraph::createRenderPasses() {
+    for (RenderGraphPass p: order) {
+        Pass& pass = passes[p];
+
+        // colors in declaration order, depth last
+        std::vector<const Use*> attachments;
+        for (const Use& use: pass.uses) if (use.access == Access::ColorWrite) attachments.push_back(&use);
+        for (const Use& use: pass.uses) if (use.access == Access::DepthWrite) attachments.push_back(&use);
+        if (attachments.empty()) throw std::runtime_error(std::string("pass '") + pass.name + "' writes no attachment (RenderGraph.cpp)");
+
+        std::vector<VkAttachmentDescription> descriptions;
+        std::vector<VkAttachmentReference> colorReferences;
+        VkAttachmentReference depthReference{};
+        bool hasDepth = false;
+        pass.clearValues.clear();
+        pass.colorAttachments.clear();
+        pass.colorFormats.clear();
+        pass.depthFormat = VK_FORMAT_UNDEFINED;
+        pass.backbufferAttachment = UINT32_MAX;
+        pass.compatibilityKey = 0;
+        pass.writesBackbuffer = false;
+        pass.extent = images[attachments[0]->image].extent;
+
+        for (const Use* use: attachments) {
+            const ImageResource& image = images[use->image];
+            if (image.extent.width != pass.extent.width || image.extent.height != pass.extent.height) throw std::runtime_error(std::string("attachments of pass '") + pass.name + "' differ in size (RenderGraph.cpp)");
+            pass.writesBackbuffer |= image.backbuffer;
+
+            bool writtenBefore = image.firstPass < p;
+            bool readAfter = image.backbuffer || image.lastPass > p;
+            AccessInfo info = accessInfo(use->access);
+
+            // barriers outside the pass do every transition, the render pass itself keeps the layout
+            VkAttachmentDescription description{};
+            description.format = image.format;
+            description.samples = VK_SAMPLE_COUNT_1_BIT;
+            description.loadOp = use->clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : writtenBefore ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            description.storeOp = readAfter ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            description.stencilLoadOp = hasStencil(image.format) ? description.loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            description.stencilStoreOp = hasStencil(image.format) ? description.storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            description.initialLayout = info.layout;
+            description.finalLayout = info.layout;
+
+            VkRenderingAttachmentInfo rendering{};
+            rendering.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            rendering.imageView = attachmentView(image, 0);
+            rendering.imageLayout = info.layout;
+            rendering.loadOp = description.loadOp;
+            rendering.storeOp = description.storeOp;
+            rendering.clearValue = use->clearValue;
+
+            VkAttachmentReference reference{static_cast<uint32_t>(descriptions.size()), info.layout};
+            if (use->access == Access::DepthWrite) {
+                depthReference = reference;
+                hasDepth = true;
+                pass.depthFormat = image.format;
+                pass.depthAttachment = rendering;
+            } else {
+                colorReferences.push_back(reference);
+                pass.colorFormats.push_back(image.format);
+                if (image.backbuffer) pass.backbufferAttachment = pass.colorAttachments.size();
+                pass.colorAttachments.push_back(rendering);
+            }
+            descriptions.push_back(description);
+            pass.clearValues.push_back(use->clearValue);
+
+            // same formula as RenderPass for a single color attachment, so their pipelines are shared
+            uint64_t attachmentKey = (static_cast<uint64_t>(image.format) << 8) | description.samples | (use->access == Access::DepthWrite ? 0x80 : 0);
+            pass.compatibilityKey = pass.compatibilityKey * 0x100000001b3ull ^ attachmentKey;
+        }
+        // dynamic rendering begins on the attachment infos above, no render pass or framebuffer objects
+        if (win.device.dynamicRendering) continue;
+
+        VkSubpassDescription subpass{};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.colorAttachmentCount = colorReferences.size();
+        subpass.pColorAttachments = colorReferences.data();
+        subpass.pDepthStencilAttachment = hasDepth ? &depthReference : nullptr;
+
+        VkRenderPassCreateInfo passCreateInfo{};
+        passCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+        passCreateInfo.attachmentCount = descriptions.size();
+        passCreateInfo.pAttachments = descriptions.data();
+        passCreateInfo.subpassCount = 1;
+        passCreateInfo.pSubpasses = &subpass;
+        VkCheck(vkCreateRenderPass(win.device.device, &passCreateInfo, nullptr, &pass.renderPass), "vkCreateRenderPass (RenderGraph.cpp)");
+
+        uint32_t framebufferCount = pass.writesBackbuffer ? win.swapChain.swapChainImageViews.size() : 1;
+        pass.framebuffers.resize(framebufferCount);
+        for (uint32_t f = 0; f < framebufferCount; ++f) {
+            std::vector<VkImageView> views;
+            for (const Use* use: attachments) views.push_back(attachmentView(images[use->image], f));
+
+            VkFramebufferCreateInfo framebufferCreateInfo{};
+            framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+            framebufferCreateInfo.renderPass = pass.renderPass;
+            framebufferCreateInfo.attachmentCount = views.size();
+            framebufferCreateInfo.pAttachments = views.data();
+            framebufferCreateInfo.width = pass.extent.width;
+            framebufferCreateInfo.height = pass.extent.height;
+            framebufferCreateInfo.layers = 1;
+            VkCheck(vkCreateFramebuffer(win.device.device, &framebufferCreateInfo, nullptr, &pass.framebuffers[f]), "vkCreateFramebuffer (RenderGraph.cpp)");
+        }
+    }
+}
+
+void RenderGraph::computeBarriers() {
+    struct State {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags stages = 0;
+        VkAccessFlags access = 0;
+        bool used = false;
+    };
+
+    // first pass over the frame: state every image is left in, which the next frame's first use waits on
+    std::vector<State> states(images.size());
+    for (RenderGraphPass p: order) {
+        for (const Use& use: passes[p].uses) {
+            AccessInfo info = accessInfo(use.access);
+            images[use.image].lastStages = info.stages;
+            images[use.image].lastAccess = info.access;
+        }
+    }
+    // aliased images also wait on whatever else used their memory
+    std::vector<VkPipelineStageFlags> slotStages(memorySlots.size(), 0);
+    std::vector<VkAccessFlags> slotAccess(memorySlots.size(), 0);
+    for (const ImageResource& image: images) {
+        if (image.memorySlot == UINT32_MAX) continue;
+        slotStages[image.memorySlot] |= image.lastStages;
+        slotAccess[image.memorySlot] |= image.lastAccess;
+    }
+
+    for (RenderGraphPass p: order) {
+        Pass& pass = passes[p];
+        pass.barriers.clear();
+        pass.srcStages = 0;
+        pass.dstStages = 0;
+        pass.backbufferBarrier = UINT32_MAX;
+
+        for (const Use& use: pass.uses) {
+            ImageResource& image = images[use.image];
+            State& state = states[use.image];
+            AccessInfo info = accessInfo(use.access);
+
+            VkPipelineStageFlags srcStages = state.stages;
+            VkAccessFlags srcAccess = state.access & writeAccess;
+            if (!state.used) {
+                // contents of the previous frame are never kept, but its writes have to finish before ours
+                if (image.backbuffer) {
+                    // the acquire semaphore is waited on at color output, the transition has to come after it
+                    srcStages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+                    srcAccess = 0;
+                } else {
+                    srcStages = slotStages[image.memorySlot];
+                    srcAccess = slotAccess[image.memorySlot] & writeAccess;
+                }
+            }
+            // read after read in the same layout needs nothing
+            bool needed = !state.used || state.layout != info.layout || srcAccess != 0 || info.write;
+            if (needed) {
+                VkImageMemoryBarrier barrier{};
+                barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+                barrier.srcAccessMask = srcAccess;
+                barrier.dstAccessMask = info.access;
+                barrier.oldLayout = state.used ? state.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+                barrier.newLayout = info.layout;
+                barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+                barrier.image = image.image.image;
+                barrier.subresourceRange.aspectMask = isDepthFormat(image.format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+                if (hasStencil(image.format)) barrier.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+                barrier.subresourceRange.levelCount = 1;
+                barrier.subresourceRange.layerCount = 1;
+                if (image.backbuffer) pass.backbufferBarrier = pass.barriers.size();
+                pass.barriers.push_back(barrier);
+                pass.srcStages |= srcStages;
+                pass.dstStages |= info.stages;
+            }
+
+            state = {info.layout, info.stages, info.access, true};
+        }
+        // an empty src mask is invalid, TOP_OF_PIPE waits for nothing
+        if (pass.srcStages == 0) pass.srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    }
+
+    finalBarrier = {};
+    finalSrcStages = 0;
+    finalDstStages = 0;
+    for (RenderGraphImage i = 0; i < images.size(); ++i) {
+        if (!images[i].backbuffer || !states[i].used) continue;
+        // headless images are copied out after the frame, presented ones only need the layout
+        bool headless = win.swapChain.headless;
+        finalBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        finalBarrier.srcAccessMask = states[i].access & writeAccess;
+        finalBarrier.dstAccessMask = headless ? VK_ACCESS_TRANSFER_READ_BIT : 0;
+        finalBarrier.oldLayout = states[i].layout;
+        finalBarrier.newLayout = win.swapChain.imageFinalLayout;
+        finalBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        finalBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        finalBarrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        finalSrcStages = states[i].stages;
+        finalDstStages = headless ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    }
+}
+
+void RenderGraph::compile() {
+    CITRINE_PROFILE_SCOPE("compile render graph");
+    releaseCompiled();
+    for (auto& image: images) {
+        image.firstPass = UINT32_MAX;
+        image.lastPass = 0;
+        image.memorySlot = UINT32_MAX;
+    }
+
+    cullPasses();
+    createImages();
+    createRenderPasses();
+    computeBarriers();
+
+    dirty = false;
+    compiled = true;
+    compiledGeneration = win.swapChain.generation;
+}
+
+void RenderGraph::execute(VkCommandBuffer commandBuffer) {
+    if (dirty || !compiled || compiledGeneration != win.swapChain.generation) compile();
+    CITRINE_PROFILE_SCOPE("render graph");
+
+    uint32_t imageIndex = win.swapChain.currentImageIndex;
+    VkImage backbuffer = win.swapChain.swapChainImages[imageIndex];
+    bool dynamicRendering = win.device.dynamicRendering;
+    for (RenderGraphPass p: order) {
+        Pass& pass = passes[p];
+        if (!pass.barriers.empty()) {
+            // the backbuffer changes every frame, it goes into a copy in the frame arena so the compiled barriers stay untouched
+            std::span<VkImageMemoryBarrier> barriers = pass.barriers;
+            if (pass.backbufferBarrier != UINT32_MAX) {
+                barriers = win.frameArena().copy<VkImageMemoryBarrier>(pass.barriers);
+                barriers[pass.backbufferBarrier].image = backbuffer;
+            }
+            vkCmdPipelineBarrier(commandBuffer, pass.srcStages, pass.dstStages, 0, 0, nullptr, 0, nullptr, barriers.size(), barriers.data());
+        }
+
+        uint32_t scope = win.profiler.beginScope(commandBuffer, pass.name, true);
+        if (dynamicRendering) {
+            if (pass.backbufferAttachment != UINT32_MAX) pass.colorAttachments[pass.backbufferAttachment].imageView = win.swapChain.swapChainImageViews[imageIndex];
+            bool hasDepth = pass.depthFormat != VK_FORMAT_UNDEFINED;
+
+            VkRenderingInfo renderingInfo{};
+            renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+            renderingInfo.renderArea.extent = pass.extent;
+            renderingInfo.layerCount = 1;
+            renderingInfo.colorAttachmentCount = pass.colorAttachments.size();
+            renderingInfo.pColorAttachments = pass.colorAttachments.data();
+            renderingInfo.pDepthAttachment = hasDepth ? &pass.depthAttachment : nullptr;
+            renderingInfo.pStencilAttachment = hasStencil(pass.depthFormat) ? &pass.depthAttachment : nullptr;
+            win.device.cmdBeginRendering(commandBuffer, &renderingInfo);
+        } else {
+            VkRenderPassBeginInfo beginInfo{};
+            beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            beginInfo.renderPass = pass.renderPass;
+            beginInfo.framebuffer = pass.framebuffers[pass.writesBackbuffer ? imageIndex : 0];
+            beginInfo.renderArea.extent = pass.extent;
+            beginInfo.clearValueCount = pass.clearValues.size();
+            beginInfo.pClearValues = pass.clearValues.data();
+            vkCmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        }
+
+        VkViewport viewport{0, 0, static_cast<float>(pass.extent.width), static_cast<float>(pass.extent.height), 0, 1};
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        VkRect2D scissor{{0, 0}, pass.extent};
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+        if (pass.execute) pass.execute(commandBuffer);
+        if (dynamicRendering) win.device.cmdEndRendering(commandBuffer);
+        else vkCmdEndRenderPass(commandBuffer);
+        win.profiler.endScope(commandBuffer, scope);
+    }
+
+    if (finalSrcStages != 0) {
+        finalBarrier.image = backbuffer;
+        vkCmdPipelineBarrier(commandBuffer, finalSrcStages, finalDstStages, 0, 0, nullptr, 0, nullptr, 1, &finalBarrier);
+    }
+}
+
+void RenderGraph::releaseCompiled() {
+    if (!compiled) return;
+    for (auto& pass: passes) {
+        for (auto framebuffer: pass.framebuffers) win.deletionQueue.retireFramebuffer(framebuffer);
+        win.deletionQueue.retireRenderPass(pass.renderPass);
+        pass.framebuffers.clear();
+        pass.renderPass = VK_NULL_HANDLE;
+    }
+    for (auto& image: images) {
+        win.deletionQueue.retireImageView(image.view);
+        // memory belongs to the slot
+        win.deletionQueue.retireImage(image.image);
+        image.view = VK_NULL_HANDLE;
+    }
+    for (auto& slot: memorySlots) win.deletionQueue.retireMemory(slot.allocation);
+    memorySlots.clear();
+    order.clear();
+    compiled = false;
+}
+
+void RenderGraph::reset() {
+    releaseCompiled();
+    passes.clear();
+    images.clear();
+    dirty = true;
+}
+
+void RenderGraph::destroy() {
+    reset();
+}
@@ -0,0 +1,162 @@
+#ifndef CITRINE_RENDERGRAPH_H
+#define CITRINE_RENDERGRAPH_H
+
+#include "VkHelper.h"
+#include <vector>
+#include <functional>
+#include "VkWindow.h"
+
+// image of a render graph, returned by importBackbuffer/createImage
+using RenderGraphImage = uint32_t;
+// pass of a render graph, returned by addPass
+using RenderGraphPass = uint32_t;
+
+// the frame as a list of passes that declare which images they write and read. compile() culls passes nothing
+// depends on, creates the transient images (sharing memory between images whose lifetimes don't overlap),
+// one VkRenderPass + framebuffers per pass (nothing with dynamic rendering, passes then begin on the image views)
+// and every barrier/layout transition between them. execute() only
+// replays that, the graph recompiles by itself when the topology changed or the swapchain was recreated.
+// passes run in declaration order, so a pass has to be added after the passes producing what it reads.
+class RenderGraph {
+public:
+    using ExecuteFunction = std::function<void(VkCommandBuffer commandBuffer)>;
+
+private:
+    enum class Access : uint8_t {
+        ColorWrite,
+        DepthWrite,
+        // sampled in the fragment shader
+        Sampled,
+    };
+
+    // layout, stages and access of an image while a pass uses it
+    struct AccessInfo {
+        VkImageLayout layout;
+        VkPipelineStageFlags stages;
+        VkAccessFlags access;
+        bool write;
+    };
+
+    struct Use {
+        RenderGraphImage image;
+        Access access;
+        bool clear;
+        VkClearValue clearValue;
+    };
+
+    struct ImageResource {
+        const char* name;
+        VkFormat format;
+        // of the swapchain extent
+        float scale;
+        bool backbuffer;
+
+        // compiled
+        VkExtent2D extent{};
+        VkImageUsageFlags usage = 0;
+        Image image{};
+        VkImageView view = VK_NULL_HANDLE;
+        uint32_t memorySlot = UINT32_MAX;
+        uint32_t firstPass = UINT32_MAX;
+        uint32_t lastPass = 0;
+        // state after the last pass of the frame, the next frame's first use waits on it
+        VkPipelineStageFlags lastStages = 0;
+        VkAccessFlags lastAccess = 0;
+    };
+
+    struct Pass {
+        const char* name;
+        std::vector<Use> uses;
+        ExecuteFunction execute;
+        // never culled, even if nothing reads what it writes
+        bool sideEffects;
+
+        // compiled
+        bool culled = false;
+        bool writesBackbuffer = false;
+        uint64_t compatibilityKey = 0;
+        std::vector<VkFormat> colorFormats;
+        VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+        // render pass objects
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        // one per swapchain image when the pass writes the backbuffer, otherwise one
+        std::vector<VkFramebuffer> framebuffers;
+        std::vector<VkClearValue> clearValues;
+        // dynamic rendering
+        std::vector<VkRenderingAttachmentInfo> colorAttachments;
+        VkRenderingAttachmentInfo depthAttachment{};
+        // index into colorAttachments whose view is the acquired swapchain image, patched every frame
+        uint32_t backbufferAttachment = UINT32_MAX;
+        std::vector<VkImageMemoryBarrier> barriers;
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+        // index into barriers whose image is the acquired swapchain image, patched every frame
+        uint32_t backbufferBarrier = UINT32_MAX;
+    };
+
+    // memory shared by transient images with disjoint lifetimes
+    struct MemorySlot {
+        VkMemoryRequirements requirements{};
+        uint32_t lastPass = 0;
+        Allocation allocation{};
+    };
+
+    VkWindow& win;
+    std::vector<ImageResource> images;
+    std::vector<Pass> passes;
+    std::vector<MemorySlot> memorySlots;
+    // live passes in execution order
+    std::vector<RenderGraphPass> order;
+    // backbuffer to the swapchain's final layout after its last pass
+    VkImageMemoryBarrier finalBarrier{};
+    VkPipelineStageFlags finalSrcStages = 0;
+    VkPipelineStageFlags finalDstStages = 0;
+
+    bool dirty = true;
+    bool compiled = false;
+    uint64_t compiledGeneration = 0;
+
+    static AccessInfo accessInfo(Access access);
+    void addUse(RenderGraphPass pass, RenderGraphImage image, Access access, const VkClearValue* clearValue);
+    void cullPasses();
+    void createImages();
+    void createRenderPasses();
+    void computeBarriers();
+    // retires everything compile() created, in flight frames may still use it
+    void releaseCompiled();
+    [[nodiscard]] VkImageView attachmentView(const ImageResource& image, uint32_t swapChainImage) const;
+public:
+    explicit RenderGraph(VkWindow& window) : win(window) {}
+
+    // the swapchain image of the current frame, presented after the graph ran
+    RenderGraphImage importBackbuffer();
+    // transient image, only valid during the frame. extent is the swapchain extent times scale
+    RenderGraphImage createImage(const char* name, VkFormat format, float scale = 1);
+
+    // name is kept as is (profiler scopes), pass a literal
+    RenderGraphPass addPass(const char* name, ExecuteFunction execute, bool sideEffects = false);
+    // without a clear value the attachment keeps what earlier passes wrote into it
+    void writeColor(RenderGraphPass pass, RenderGraphImage image, const VkClearValue* clearValue = nullptr);
+    void writeDepth(RenderGraphPass pass, RenderGraphImage image, const VkClearValue* clearValue = nullptr);
+    void sample(RenderGraphPass pass, RenderGraphImage image);
+
+    void compile();
+    // records every live pass into commandBuffer, between VkWindow::startCommandBuffer and endCommandBuffer
+    void execute(VkCommandBuffer commandBuffer);
+    // drops all passes and images, the next execute compiles the new topology
+    void reset();
+    void destroy();
+
+    // valid after compile, for creating pipelines. VK_NULL_HANDLE when the pass was culled or with dynamic rendering
+    [[nodiscard]] VkRenderPass renderPass(RenderGraphPass pass) const { return passes[pass].renderPass; }
+    [[nodiscard]] uint64_t compatibilityKey(RenderGraphPass pass) const { return passes[pass].compatibilityKey; }
+    // attachment formats, what dynamic rendering pipelines are created for
+    [[nodiscard]] const std::vector<VkFormat>& colorFormats(RenderGraphPass pass) const { return passes[pass].colorFormats; }
+    [[nodiscard]] VkFormat depthFormat(RenderGraphPass pass) const { return passes[pass].depthFormat; }
+    [[nodiscard]] bool isCulled(RenderGraphPass pass) const { return passes[pass].culled; }
+    // transient images only, for descriptors of the passes sampling them
+    [[nodiscard]] VkImageView imageView(RenderGraphImage image) const { return images[image].view; }
+};
+
+#endif //CITRINE_RENDERGRAPH_H
@@ -2,6 +2,12 @@
 #include "RenderPass.h"
 
 void RenderPass::createRenderPass() {
+    dynamicRendering = win.device.dynamicRendering;
+    colorFormat = win.swapChain.surfaceFormat.format;
+    compatibilityKey = (static_cast<uint64_t>(colorFormat) << 8) | VK_SAMPLE_COUNT_1_BIT;
+    // pipelines are made for the formats, nothing to create
+    if (dynamicRendering) return;
+    
     VkAttachmentDescription colorAttachment{};
     colorAttachment.format = win.swapChain.surfaceFormat.format;
     colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -10,7 +16,7 @@ void RenderPass::createRenderPass() {
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.finalLayout = win.swapChain.imageFinalLayout;
     
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.attachment = 0;
@@ -42,11 +48,59 @@ void RenderPass::createRenderPass() {
 }
 
 void RenderPass::destroyRenderPass() {
-    vkDestroyRenderPass(win.device.device, renderPass, nullptr);
+    win.deletionQueue.retireRenderPass(renderPass);
+    renderPass = VK_NULL_HANDLE;
+}
+
+void RenderPass::transitionImage(VkImageLayout oldLayout, VkImageLayout newLayout) {
+    bool toAttachment = newLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    bool headless = win.swapChain.headless;
+    
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = toAttachment ? 0 : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = toAttachment ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : headless ? VK_ACCESS_TRANSFER_READ_BIT : 0;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = win.swapChain.swapChainImages[win.swapChain.currentImageIndex];
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    
+    // same as the external dependency of the render pass object: after the acquire semaphore wait at color output
+    VkPipelineStageFlags dstStages = toAttachment ? VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT : headless ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    vkCmdPipelineBarrier(win.commandPool.currentCommandBuffer().vk, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, dstStages, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
 
-void RenderPass::startRenderPass() {
+void RenderPass::startRenderPass(VkSubpassContents contents) {
     uint32_t imageIndex = win.swapChain.currentImageIndex;
+    VkCommandBuffer commandBuffer = win.commandPool.currentCommandBuffer().vk;
+    VkClearValue clearColor = {{{0,0,0,1}}};
+    
+    if (dynamicRendering) {
+        transitionImage(VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+        
+        VkRenderingAttachmentInfo colorAttachment{};
+        colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        colorAttachment.imageView = win.swapChain.swapChainImageViews[imageIndex];
+        colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.clearValue = clearColor;
+        
+        VkRenderingInfo renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        renderingInfo.flags = contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+        renderingInfo.renderArea.extent = win.swapChain.swapExtent;
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = 1;
+        renderingInfo.pColorAttachments = &colorAttachment;
+        
+        profilerScope = win.profiler.beginScope(commandBuffer, "render pass", contents == VK_SUBPASS_CONTENTS_INLINE);
+        win.device.cmdBeginRendering(commandBuffer, &renderingInfo);
+        if (contents == VK_SUBPASS_CONTENTS_INLINE) setDynamicState(commandBuffer);
+        return;
+    }
     
     VkRenderPassBeginInfo renderPassBeginInfo{};
     renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -55,15 +109,39 @@ void RenderPass::startRenderPass() {
     renderPassBeginInfo.renderArea.offset = {0,0};
     renderPassBeginInfo.renderArea.extent = win.swapChain.swapExtent;
 
-    VkClearValue clearColor = {{{0,0,0,1}}};
     renderPassBeginInfo.clearValueCount = 1;
     renderPassBeginInfo.pClearValues = &clearColor;
 
-    vkCmdBeginRenderPass(win.commandPool.currentCommandBuffer().vk, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // pipeline statistics can't stay active across vkCmdExecuteCommands, secondary passes only get timestamps
+    profilerScope = win.profiler.beginScope(commandBuffer, "render pass", contents == VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, contents);
+    
+    // secondary command buffers don't inherit dynamic state, they set it themselves
+    if (contents == VK_SUBPASS_CONTENTS_INLINE) setDynamicState(commandBuffer);
+}
+
+void RenderPass::setDynamicState(VkCommandBuffer commandBuffer) const {
+    VkViewport viewport{};
+    viewport.x = 0;
+    viewport.y = 0;
+    viewport.width = static_cast<float>(win.swapChain.swapExtent.width);
+    viewport.height = static_cast<float>(win.swapChain.swapExtent.height);
+    viewport.minDepth = 0;
+    viewport.maxDepth = 1;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    
+    VkRect2D scissor{};
+    scissor.offset = {0,0};
+    scissor.extent = win.swapChain.swapExtent;
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 }
 
 void RenderPass::endRenderPass() {
-    vkCmdEndRenderPass(win.commandPool.currentCommandBuffer().vk);
+    VkCommandBuffer commandBuffer = win.commandPool.currentCommandBuffer().vk;
+    if (dynamicRendering) win.device.cmdEndRendering(commandBuffer);
+    else vkCmdEndRenderPass(commandBuffer);
+    win.profiler.endScope(commandBuffer, profilerScope);
+    if (dynamicRendering) transitionImage(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, win.swapChain.imageFinalLayout);
 }
 
 void RenderPass::recreateRenderPass() {
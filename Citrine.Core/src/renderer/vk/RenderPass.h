@@ -8,15 +8,26 @@
 #include "VkWindow.h"
 #include "VkHelper.h"
 
+// clears the swapchain image and renders into it. on devices with dynamic rendering there is no VkRenderPass
+// (renderPass stays VK_NULL_HANDLE), the pass begins on the image view and transitions the image itself
 class RenderPass {
 private:
     VkWindow& win;
+    uint32_t profilerScope = UINT32_MAX;
+    
+    void transitionImage(VkImageLayout oldLayout, VkImageLayout newLayout);
 public:
-    VkRenderPass renderPass;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    // equal for render passes that are compatible (same attachment formats/samples), pipelines are keyed by it
+    uint64_t compatibilityKey = 0;
+    VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+    bool dynamicRendering = false;
     
     explicit RenderPass(VkWindow& window) : win(window) {}
     void createRenderPass();
-    void startRenderPass();
+    void startRenderPass(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+    // viewport/scissor covering the current swapchain extent
+    void setDynamicState(VkCommandBuffer commandBuffer) const;
     void endRenderPass();
     void destroyRenderPass();
     void recreateRenderPass();
@@ -0,0 +1,72 @@
+#include "SamplerCache.h"
+#include <algorithm>
+#include <cstring>
+
+uint64_t SamplerDescription::hash() const {
+    // FNV-1a over the fields, floats by their bits
+    uint64_t value = 14695981039346656037ull;
+    auto add = [&value](const auto& field) {
+        unsigned char bytes[sizeof(field)];
+        std::memcpy(bytes, &field, sizeof(field));
+        for (unsigned char byte: bytes) {
+            value ^= byte;
+            value *= 1099511628211ull;
+        }
+    };
+    add(magFilter);
+    add(minFilter);
+    add(mipmapMode);
+    add(addressModeU);
+    add(addressModeV);
+    add(addressModeW);
+    add(maxAnisotropy);
+    add(mipLodBias);
+    add(minLod);
+    add(maxLod);
+    add(compareOp);
+    add(borderColor);
+    return value;
+}
+
+void SamplerCache::create(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice) {
+    device = logicalDevice.device;
+    // LogicalDevice enables every feature the device has
+    anisotropy = logicalDevice.features.samplerAnisotropy;
+    maxAnisotropy = physicalDevice.physicalDeviceProperties.limits.maxSamplerAnisotropy;
+}
+
+void SamplerCache::destroy() {
+    std::lock_guard lock(mutex);
+    for (auto& [key, cached]: samplers) vkDestroySampler(device, cached.sampler, nullptr);
+    samplers.clear();
+}
+
+VkSampler SamplerCache::get(const SamplerDescription& description) {
+    uint64_t key = description.hash();
+    std::lock_guard lock(mutex);
+    auto it = samplers.find(key);
+    while (it != samplers.end() && !(it->second.description == description)) it = samplers.find(++key);
+    if (it != samplers.end()) return it->second.sampler;
+    
+    VkSamplerCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    createInfo.magFilter = description.magFilter;
+    createInfo.minFilter = description.minFilter;
+    createInfo.mipmapMode = description.mipmapMode;
+    createInfo.addressModeU = description.addressModeU;
+    createInfo.addressModeV = description.addressModeV;
+    createInfo.addressModeW = description.addressModeW;
+    createInfo.mipLodBias = description.mipLodBias;
+    createInfo.anisotropyEnable = anisotropy && description.maxAnisotropy > 1;
+    createInfo.maxAnisotropy = std::clamp(description.maxAnisotropy, 1.f, maxAnisotropy);
+    createInfo.compareEnable = description.compareOp != VK_COMPARE_OP_NEVER;
+    createInfo.compareOp = description.compareOp;
+    createInfo.minLod = description.minLod;
+    createInfo.maxLod = description.maxLod;
+    createInfo.borderColor = description.borderColor;
+    
+    VkSampler sampler;
+    VkCheck(vkCreateSampler(device, &createInfo, nullptr, &sampler), "vkCreateSampler (SamplerCache.cpp)");
+    samplers.emplace(key, Cached{description, sampler});
+    return sampler;
+}
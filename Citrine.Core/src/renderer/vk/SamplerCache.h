@@ -0,0 +1,53 @@
+#ifndef CITRINE_SAMPLERCACHE_H
+#define CITRINE_SAMPLERCACHE_H
+
+#include "VkHelper.h"
+#include <mutex>
+#include <unordered_map>
+#include "PhysicalDevice.h"
+#include "LogicalDevice.h"
+
+// sampler state, trilinear, repeating and as anisotropic as the device allows by default
+struct SamplerDescription {
+    VkFilter magFilter = VK_FILTER_LINEAR;
+    VkFilter minFilter = VK_FILTER_LINEAR;
+    VkSamplerMipmapMode mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    VkSamplerAddressMode addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    VkSamplerAddressMode addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    VkSamplerAddressMode addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    // 1 or less turns it off, clamped to maxSamplerAnisotropy. ignored without the samplerAnisotropy feature
+    float maxAnisotropy = 16;
+    float mipLodBias = 0;
+    float minLod = 0;
+    float maxLod = VK_LOD_CLAMP_NONE;
+    // depth comparison (shadow maps) when not VK_COMPARE_OP_NEVER
+    VkCompareOp compareOp = VK_COMPARE_OP_NEVER;
+    VkBorderColor borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+
+    [[nodiscard]] uint64_t hash() const;
+    [[nodiscard]] bool operator==(const SamplerDescription& other) const = default;
+};
+
+// one VkSampler per distinct description, shared by every texture using it. devices only guarantee 4000 samplers
+// (maxSamplerAllocationCount) and a handful of states covers whole scenes. samplers live until destroy, thread safe
+class SamplerCache {
+private:
+    VkDevice device = VK_NULL_HANDLE;
+    bool anisotropy = false;
+    float maxAnisotropy = 1;
+    struct Cached {
+        SamplerDescription description;
+        VkSampler sampler;
+    };
+    // keyed by hash, a different description under a key (a collision) goes to the next key
+    std::unordered_map<uint64_t, Cached> samplers;
+    std::mutex mutex;
+public:
+    void create(PhysicalDevice& physicalDevice, LogicalDevice& logicalDevice);
+    void destroy();
+
+    VkSampler get(const SamplerDescription& description = {});
+    [[nodiscard]] size_t size() const { return samplers.size(); }
+};
+
+#endif //CITRINE_SAMPLERCACHE_H
@@ -0,0 +1,119 @@
+#ifndef CITRINE_SUBMITBATCH_H
+#define CITRINE_SUBMITBATCH_H
+
+#include "VkHelper.h"
+#include <array>
+#include <span>
+#include <stdexcept>
+
+struct SemaphoreWait {
+    VkSemaphore semaphore;
+    // ignored for binary semaphores
+    uint64_t value = 0;
+    VkPipelineStageFlags stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+};
+
+struct SemaphoreSignal {
+    VkSemaphore semaphore;
+    // ignored for binary semaphores
+    uint64_t value = 0;
+};
+
+// collects the work of one queue for a frame and hands it to the driver in a single vkQueueSubmit.
+// every add() becomes one VkSubmitInfo (with its timeline values), so waits and signals keep their order.
+// fixed capacity, nothing is allocated.
+struct SubmitBatch {
+private:
+    static constexpr uint32_t maxSubmits = 8;
+    static constexpr uint32_t maxCommandBuffers = 32;
+    static constexpr uint32_t maxSemaphores = 32;
+    
+    struct Range {
+        uint32_t first = 0;
+        uint32_t count = 0;
+    };
+    
+    struct Entry {
+        Range commandBuffers;
+        Range waits;
+        Range signals;
+    };
+    
+    std::array<Entry, maxSubmits> entries{};
+    std::array<VkCommandBuffer, maxCommandBuffers> commandBuffers{};
+    std::array<VkSemaphore, maxSemaphores> waitSemaphores{};
+    std::array<uint64_t, maxSemaphores> waitValues{};
+    std::array<VkPipelineStageFlags, maxSemaphores> waitStages{};
+    std::array<VkSemaphore, maxSemaphores> signalSemaphores{};
+    std::array<uint64_t, maxSemaphores> signalValues{};
+    uint32_t entryCount = 0;
+    uint32_t commandBufferCount = 0;
+    uint32_t waitCount = 0;
+    uint32_t signalCount = 0;
+public:
+    void add(std::span<const VkCommandBuffer> buffers, std::span<const SemaphoreWait> waits = {}, std::span<const SemaphoreSignal> signals = {}) {
+        if (entryCount == maxSubmits || commandBufferCount + buffers.size() > maxCommandBuffers ||
+            waitCount + waits.size() > maxSemaphores || signalCount + signals.size() > maxSemaphores)
+            throw std::runtime_error("submit batch full (SubmitBatch.h)");
+        
+        Entry& entry = entries[entryCount++];
+        entry.commandBuffers = {commandBufferCount, static_cast<uint32_t>(buffers.size())};
+        for (VkCommandBuffer buffer: buffers) commandBuffers[commandBufferCount++] = buffer;
+        
+        entry.waits = {waitCount, static_cast<uint32_t>(waits.size())};
+        for (const auto& wait: waits) {
+            waitSemaphores[waitCount] = wait.semaphore;
+            waitValues[waitCount] = wait.value;
+            waitStages[waitCount++] = wait.stage;
+        }
+        
+        entry.signals = {signalCount, static_cast<uint32_t>(signals.size())};
+        for (const auto& signal: signals) {
+            signalSemaphores[signalCount] = signal.semaphore;
+            signalValues[signalCount++] = signal.value;
+        }
+    }
+    
+    [[nodiscard]] bool empty() const { return entryCount == 0; }
+    
+    // one vkQueueSubmit for everything added since the last submit, then starts over
+    void submit(VkQueue queue, VkFence fence = VK_NULL_HANDLE) {
+        if (entryCount == 0 && fence == VK_NULL_HANDLE) return;
+        
+        VkSubmitInfo submitInfos[maxSubmits];
+        VkTimelineSemaphoreSubmitInfo timelineInfos[maxSubmits];
+        for (uint32_t i = 0; i < entryCount; ++i) {
+            const Entry& entry = entries[i];
+            
+            timelineInfos[i] = {};
+            timelineInfos[i].sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfos[i].waitSemaphoreValueCount = entry.waits.count;
+            timelineInfos[i].pWaitSemaphoreValues = waitValues.data() + entry.waits.first;
+            timelineInfos[i].signalSemaphoreValueCount = entry.signals.count;
+            timelineInfos[i].pSignalSemaphoreValues = signalValues.data() + entry.signals.first;
+            
+            submitInfos[i] = {};
+            submitInfos[i].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            submitInfos[i].pNext = &timelineInfos[i];
+            submitInfos[i].waitSemaphoreCount = entry.waits.count;
+            submitInfos[i].pWaitSemaphores = waitSemaphores.data() + entry.waits.first;
+            submitInfos[i].pWaitDstStageMask = waitStages.data() + entry.waits.first;
+            submitInfos[i].commandBufferCount = entry.commandBuffers.count;
+            submitInfos[i].pCommandBuffers = commandBuffers.data() + entry.commandBuffers.first;
+            submitInfos[i].signalSemaphoreCount = entry.signals.count;
+            submitInfos[i].pSignalSemaphores = signalSemaphores.data() + entry.signals.first;
+        }
+        
+        VkCheck(vkQueueSubmit(queue, entryCount, submitInfos, fence), "vkQueueSubmit (SubmitBatch.h)");
+        clear();
+    }
+    
+    void clear() {
+        entryCount = 0;
+        commandBufferCount = 0;
+        waitCount = 0;
+        signalCount = 0;
+    }
+};
+
+#endif //CITRINE_SUBMITBATCH_H
@@ -4,6 +4,9 @@
 #include "VkHelper.h"
 #include "PhysicalDevice.h"
 #include "LogicalDevice.h"
+#include "MemoryAllocator.h"
+#include "FrameSettings.h"
+#include "DeletionQueue.h"
 #include <vector>
 
 struct SwapChainSupportDetails {
@@ -44,17 +47,28 @@ private:
     }
     
     void chooseSwapPresentMode() {
-        // V-Sync
-        // VK_PRESENT_MODE_FIFO_KHR on linux x11 with nvidia drivers lags so much, so avoid it's as much as possible
-        swapPresentMode = swapChainSupportDetails.presentModes[0];
-
-        // no V-Sync
-        if (std::find(swapChainSupportDetails.presentModes.begin(), swapChainSupportDetails.presentModes.end(), VK_PRESENT_MODE_IMMEDIATE_KHR) != swapChainSupportDetails.presentModes.end())
-            swapPresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
-
-        // V-Sync
-        if (std::find(swapChainSupportDetails.presentModes.begin(), swapChainSupportDetails.presentModes.end(), VK_PRESENT_MODE_MAILBOX_KHR) != swapChainSupportDetails.presentModes.end())
-            swapPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+        // VK_PRESENT_MODE_FIFO_KHR on linux x11 with nvidia drivers lags so much, only power saving asks for it first
+        std::vector<VkPresentModeKHR> preferred;
+        switch (presentPolicy) {
+            case PresentPolicy::LowLatency:
+                preferred = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR};
+                break;
+            case PresentPolicy::Throughput:
+                preferred = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR};
+                break;
+            case PresentPolicy::PowerSaving:
+                break;
+        }
+        
+        // FIFO is the only mode the spec guarantees
+        swapPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+        const auto& available = swapChainSupportDetails.presentModes;
+        for (VkPresentModeKHR mode: preferred) {
+            if (std::find(available.begin(), available.end(), mode) != available.end()) {
+                swapPresentMode = mode;
+                break;
+            }
+        }
 
         std::string presentModeName = "?";
         switch (swapPresentMode) {
@@ -83,14 +97,14 @@ private:
         std::cout << "chosen " << presentModeName << " as present mode\n";
     }
     
-    void chooseSwapExtent(GLFWwindow* glfwWindow) {
+    // framebuffer size comes from the main thread, glfwGetFramebufferSize must not be called from the render thread
+    void chooseSwapExtent(VkExtent2D framebufferExtent) {
         if (swapChainSupportDetails.capabilities.currentExtent.width != UINT32_MAX) {
             swapExtent = swapChainSupportDetails.capabilities.currentExtent;
             return;
         }
 
-        int width, height;
-        glfwGetFramebufferSize(glfwWindow, &width, &height);
+        uint32_t width = framebufferExtent.width, height = framebufferExtent.height;
 
         swapExtent = {
                 swapExtent.width = std::clamp(static_cast<uint32_t>(width),
@@ -138,14 +152,27 @@ public:
 
     uint32_t currentImageIndex = 0;
     uint32_t swapchainSize = 0;
+    // bumped by every (re)creation, users of the images and views compare it to notice a new swapchain
+    uint64_t generation = 0;
+    // read on every (re)creation, changing it only takes effect with the next recreate
+    PresentPolicy presentPolicy = PresentPolicy::LowLatency;
+    
+    // set when images are device owned offscreen targets instead of swapchain images
+    bool headless = false;
+    VkImageLayout imageFinalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    std::vector<Allocation> headlessImageMemory;
     
-    void create(GLFWwindow* glfwWindow, PhysicalDevice& physicalDevice, LogicalDevice& device, VkSurfaceKHR surface, Queues& queues) {
+    void create(VkExtent2D framebufferExtent, PhysicalDevice& physicalDevice, LogicalDevice& device, VkSurfaceKHR surface, Queues& queues, VkSwapchainKHR oldSwapChain = VK_NULL_HANDLE) {
         querySwapChainSupport(physicalDevice, surface);
         chooseSwapSurfaceFormat();
         chooseSwapPresentMode();
-        chooseSwapExtent(glfwWindow);
+        chooseSwapExtent(framebufferExtent);
 
-        uint32_t imageCount = std::min(swapChainSupportDetails.capabilities.minImageCount + 1, swapChainSupportDetails.capabilities.maxImageCount);
+        // mailbox needs a third image to always have one free to render into while one waits for the vblank
+        uint32_t imageCount = swapChainSupportDetails.capabilities.minImageCount + 1;
+        if (swapPresentMode == VK_PRESENT_MODE_MAILBOX_KHR) imageCount = std::max(imageCount, 3u);
+        // maxImageCount 0 means no limit
+        if (swapChainSupportDetails.capabilities.maxImageCount != 0) imageCount = std::min(imageCount, swapChainSupportDetails.capabilities.maxImageCount);
 
         VkSwapchainCreateInfoKHR createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
@@ -169,7 +196,7 @@ public:
         createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         createInfo.presentMode = swapPresentMode;
         createInfo.clipped = true;
-        createInfo.oldSwapchain = VK_NULL_HANDLE;
+        createInfo.oldSwapchain = oldSwapChain;
 
         VkCheck(vkCreateSwapchainKHR(device.device, &createInfo, nullptr, &swapChain), "vkCreateSwapchainKHR (SwapChain.h)");
 
@@ -178,6 +205,39 @@ public:
         vkGetSwapchainImagesKHR(device.device, swapChain, &imageCount, swapChainImages.data());
         
         createImageViews(device);
+        generation++;
+    }
+
+    void createHeadless(VkExtent2D extent, uint32_t imageCount, MemoryAllocator& allocator, LogicalDevice& device) {
+        headless = true;
+        imageFinalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        surfaceFormat = {VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+        swapExtent = extent;
+        
+        swapChainImages.resize(imageCount);
+        headlessImageMemory.resize(imageCount);
+        for (int i = 0; i < imageCount; ++i) {
+            VkImageCreateInfo imageCreateInfo{};
+            imageCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageCreateInfo.format = surfaceFormat.format;
+            imageCreateInfo.extent = {extent.width, extent.height, 1};
+            imageCreateInfo.mipLevels = 1;
+            imageCreateInfo.arrayLayers = 1;
+            imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageCreateInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageCreateInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            // render targets are the first thing that should get dedicated memory on drivers that care
+            Image image = allocator.createImage(imageCreateInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, true);
+            swapChainImages[i] = image.image;
+            headlessImageMemory[i] = image.allocation;
+        }
+        swapchainSize = imageCount;
+        
+        createImageViews(device);
+        generation++;
     }
 
     void createFramebuffers(VkRenderPass renderPass, LogicalDevice& device) {
@@ -200,22 +260,37 @@ public:
         }
     }
     
-    void destroy(LogicalDevice& device) {
+    void destroy(LogicalDevice& device, MemoryAllocator& allocator) {
         for (auto framebuffer: swapChainFramebuffers) vkDestroyFramebuffer(device.device, framebuffer, nullptr);
         for (auto view: swapChainImageViews) vkDestroyImageView(device.device, view, nullptr);
+        if (headless) {
+            for (auto image: swapChainImages) vkDestroyImage(device.device, image, nullptr);
+            for (auto& memory: headlessImageMemory) allocator.free(memory);
+            return;
+        }
         vkDestroySwapchainKHR(device.device, swapChain, nullptr);
     }
     
-    void recreate(GLFWwindow* glfwWindow, PhysicalDevice& physicalDevice, LogicalDevice& device, VkSurfaceKHR surface, Queues& queues) {
-        cleanup(device);
-        create(glfwWindow, physicalDevice, device, surface, queues);
+    // creates the new swapchain from the old one so presentation can continue through the transition,
+    // old framebuffers/views/swapchain are returned in retired and must be destroyed once no frame uses them (retire)
+    void recreate(VkExtent2D framebufferExtent, PhysicalDevice& physicalDevice, LogicalDevice& device, VkSurfaceKHR surface, Queues& queues, SwapChain& retired) {
+        retired.swapChain = swapChain;
+        retired.swapChainFramebuffers = std::move(swapChainFramebuffers);
+        retired.swapChainImageViews = std::move(swapChainImageViews);
+        swapChainFramebuffers.clear();
+        swapChainImageViews.clear();
+        
+        create(framebufferExtent, physicalDevice, device, surface, queues, retired.swapChain);
     }
 
-    void cleanup(LogicalDevice& device) {
-        size_t count = swapChainFramebuffers.size();
-        for (int i = 0; i < count; ++i) vkDestroyFramebuffer(device.device, swapChainFramebuffers[i], nullptr);
-        for (int i = 0; i < count; ++i) vkDestroyImageView(device.device, swapChainImageViews[i], nullptr);
-        vkDestroySwapchainKHR(device.device, swapChain, nullptr);
+    // hands what recreate() returned to the deletion queue, the images belong to the swapchain
+    void retire(DeletionQueue& deletionQueue) {
+        for (auto framebuffer: swapChainFramebuffers) deletionQueue.retireFramebuffer(framebuffer);
+        for (auto view: swapChainImageViews) deletionQueue.retireImageView(view);
+        deletionQueue.retireSwapChain(swapChain);
+        swapChainFramebuffers.clear();
+        swapChainImageViews.clear();
+        swapChain = VK_NULL_HANDLE;
     }
 };
 
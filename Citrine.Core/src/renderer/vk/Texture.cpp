@@ -0,0 +1,155 @@
+#include "Texture.h"
+#include <algorithm>
+#include <bit>
+
+bool Texture::isFormatSupported(VkWindow& window, VkFormat format) {
+    if (formatBlock(format).bytes == 0) return false;
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(window.physicalDevice.physicalDevice, format, &properties);
+    return properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+}
+
+bool Texture::canBlit() const {
+    if (isBlockCompressed(format)) return false;
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(win.physicalDevice.physicalDevice, format, &properties);
+    VkFormatFeatureFlags required = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    return (properties.optimalTilingFeatures & required) == required;
+}
+
+void Texture::createImage(uint32_t width, uint32_t height, uint32_t levels, uint32_t layerCount, bool cube) {
+    extent = {width, height};
+    mipLevels = levels;
+    layers = layerCount;
+    ready = false;
+    
+    VkImageCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    createInfo.flags = cube ? VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT : 0;
+    createInfo.imageType = VK_IMAGE_TYPE_2D;
+    createInfo.format = format;
+    createInfo.extent = {width, height, 1};
+    createInfo.mipLevels = levels;
+    createInfo.arrayLayers = layerCount;
+    createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    // blits read the previous level
+    createInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | (generateMips ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0);
+    createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image = win.uploader.createDeviceImage(createInfo);
+    
+    VkImageViewCreateInfo viewCreateInfo{};
+    viewCreateInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewCreateInfo.image = image.image;
+    if (cube) viewCreateInfo.viewType = layerCount > 6 ? VK_IMAGE_VIEW_TYPE_CUBE_ARRAY : VK_IMAGE_VIEW_TYPE_CUBE;
+    else viewCreateInfo.viewType = layerCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+    viewCreateInfo.format = format;
+    viewCreateInfo.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, layerCount};
+    VkCheck(vkCreateImageView(win.device.device, &viewCreateInfo, nullptr, &view), "vkCreateImageView (Texture.cpp)");
+}
+
+void Texture::create(const void* pixels, uint32_t width, uint32_t height, VkFormat pixelFormat, bool mipmaps) {
+    format = pixelFormat;
+    if (!isFormatSupported(win, format)) throw std::runtime_error("texture format " + std::to_string(format) + " can't be sampled on this device (Texture.cpp)");
+    generateMips = mipmaps && canBlit();
+    uint32_t levels = generateMips ? std::bit_width(std::max(width, height)) : 1;
+    createImage(width, height, levels, 1, false);
+    
+    ImageUploadRegion region{0, 0, 1, {width, height, 1}, pixels, formatLevelSize(format, width, height)};
+    VkImageLayout layout = generateMips ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    uploadTicket = win.uploader.uploadImage(image, format, mipLevels, layers, {&region, 1}, layout);
+}
+
+void Texture::create(const Ktx2Image& ktx) {
+    format = static_cast<VkFormat>(ktx.vkFormat);
+    if (!isFormatSupported(win, format)) throw std::runtime_error("texture format " + std::to_string(format) + " can't be sampled on this device (Texture.cpp)");
+    if (ktx.depth > 1) throw std::runtime_error("3D textures are not supported (Texture.cpp)");
+    
+    bool cube = ktx.faces == 6;
+    if (cube && ktx.layers > 1 && !win.device.features.imageCubeArray) throw std::runtime_error("cube map arrays are not supported by this device (Texture.cpp)");
+    uint32_t layerCount = std::max(ktx.layers, 1u) * ktx.faces;
+    generateMips = ktx.generateMips && canBlit();
+    uint32_t storedLevels = ktx.levels.size();
+    uint32_t levels = generateMips ? std::bit_width(std::max(ktx.width, ktx.height)) : storedLevels;
+    
+    std::vector<ImageUploadRegion> regions;
+    for (uint32_t i = 0; i < storedLevels; ++i) {
+        uint32_t width = std::max(ktx.width >> i, 1u), height = std::max(ktx.height >> i, 1u);
+        if (ktx.levels[i].size() != formatLevelSize(format, width, height) * layerCount) {
+            throw std::runtime_error("KTX2 level " + std::to_string(i) + " has the wrong size for its format (Texture.cpp)");
+        }
+        regions.push_back({i, 0, layerCount, {width, height, 1}, ktx.levels[i].data(), ktx.levels[i].size()});
+    }
+    createImage(ktx.width, ktx.height, levels, layerCount, cube);
+    
+    VkImageLayout layout = generateMips ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    uploadTicket = win.uploader.uploadImage(image, format, mipLevels, layers, regions, layout);
+}
+
+void Texture::load(const std::string& path) {
+    // staged before create returns, the file can go right after
+    std::vector<char> file = VkHelper::readFile(path);
+    create(Ktx2::parse(std::as_bytes(std::span(file))));
+}
+
+void Texture::destroy() {
+    // still on the transfer queue, the copies have to finish before the image can go
+    if (!ready) win.uploader.wait(uploadTicket);
+    win.deletionQueue.retireImageView(view);
+    win.deletionQueue.retireImage(image);
+    view = VK_NULL_HANDLE;
+    ready = false;
+}
+
+bool Texture::prepare(VkCommandBuffer commandBuffer) {
+    if (ready) return true;
+    if (!win.uploader.isComplete(uploadTicket)) return false;
+    if (generateMips) recordMipChain(commandBuffer);
+    ready = true;
+    return true;
+}
+
+void Texture::recordMipChain(VkCommandBuffer commandBuffer) const {
+    CITRINE_PROFILE_SCOPE("texture mips");
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image.image;
+    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, layers};
+    
+    // every level is blitted from the one above it, which is done afterwards and goes to the shaders
+    int32_t width = static_cast<int32_t>(extent.width), height = static_cast<int32_t>(extent.height);
+    for (uint32_t level = 1; level < mipLevels; ++level) {
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        
+        int32_t nextWidth = std::max(width / 2, 1), nextHeight = std::max(height / 2, 1);
+        VkImageBlit blit{};
+        blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level - 1, 0, layers};
+        blit.srcOffsets[1] = {width, height, 1};
+        blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, layers};
+        blit.dstOffsets[1] = {nextWidth, nextHeight, 1};
+        vkCmdBlitImage(commandBuffer, image.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+        
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        width = nextWidth;
+        height = nextHeight;
+    }
+    
+    barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
@@ -0,0 +1,53 @@
+#ifndef CITRINE_TEXTURE_H
+#define CITRINE_TEXTURE_H
+
+#include "VkHelper.h"
+#include <string>
+#include "VkWindow.h"
+#include "TextureFormat.h"
+#include "../../core/Ktx2.h"
+
+// sampled 2D image (array or cube map) in device local memory, uploaded through the uploader's staging ring.
+// plain formats may bring only the base level, prepare() then blits the rest of the mip chain on the graphics
+// queue. block compressed formats (BC1-7, ETC2, ASTC, usually out of a KTX2 file) stay compressed all the way to
+// the sampler and bring their mips along, they can't be blitted. sample it with a sampler from win.samplers
+class Texture {
+private:
+    VkWindow& win;
+    Image image{};
+    uint64_t uploadTicket = 0;
+    // only the base level was uploaded, the other levels are still TRANSFER_DST_OPTIMAL and undefined
+    bool generateMips = false;
+    bool ready = false;
+
+    void createImage(uint32_t width, uint32_t height, uint32_t levels, uint32_t layerCount, bool cube);
+    void recordMipChain(VkCommandBuffer commandBuffer) const;
+    [[nodiscard]] bool canBlit() const;
+public:
+    VkImageView view = VK_NULL_HANDLE;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent{};
+    uint32_t mipLevels = 0;
+    // array layers, 6 per cube
+    uint32_t layers = 0;
+
+    explicit Texture(VkWindow& window) : win(window) {}
+
+    // tightly packed base level. mipmaps: full chain, generated on the gpu when the format can be blitted
+    void create(const void* pixels, uint32_t width, uint32_t height, VkFormat pixelFormat = VK_FORMAT_R8G8B8A8_SRGB, bool mipmaps = true);
+    // levels as stored (e.g. straight from an asset pack mapping). throws when the device can't sample the format
+    void create(const Ktx2Image& ktx);
+    // a .ktx2 file
+    void load(const std::string& path);
+    void destroy();
+
+    // frame thread, outside of render passes and before the draws sampling it. true once it can be sampled,
+    // until then draws using it are skipped
+    bool prepare(VkCommandBuffer commandBuffer);
+    [[nodiscard]] bool isReady() const { return ready; }
+
+    // sampled with optimal tiling, BC/ETC2/ASTC depend on the device. pick the variant of an asset the device supports
+    static bool isFormatSupported(VkWindow& window, VkFormat format);
+};
+
+#endif //CITRINE_TEXTURE_H
@@ -0,0 +1,64 @@
+#ifndef CITRINE_TIMELINESEMAPHORE_H
+#define CITRINE_TIMELINESEMAPHORE_H
+
+#include "VkHelper.h"
+#include <atomic>
+#include "LogicalDevice.h"
+
+// monotonically increasing gpu progress counter. isComplete first checks the last value seen, so asking about
+// old values never calls into the driver. safe to query from any thread.
+struct TimelineSemaphore {
+private:
+    LogicalDevice* device = nullptr;
+    std::atomic<uint64_t> completedCache = 0;
+public:
+    VkSemaphore semaphore = VK_NULL_HANDLE;
+    
+    void create(LogicalDevice& logicalDevice, uint64_t initialValue = 0) {
+        device = &logicalDevice;
+        
+        VkSemaphoreTypeCreateInfo typeCreateInfo{};
+        typeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeCreateInfo.initialValue = initialValue;
+        
+        VkSemaphoreCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        createInfo.pNext = &typeCreateInfo;
+        VkCheck(vkCreateSemaphore(device->device, &createInfo, nullptr, &semaphore), "vkCreateSemaphore (TimelineSemaphore.h)");
+        completedCache = initialValue;
+    }
+    
+    void destroy() {
+        vkDestroySemaphore(device->device, semaphore, nullptr);
+        semaphore = VK_NULL_HANDLE;
+    }
+    
+    uint64_t completedValue() {
+        uint64_t value = 0;
+        VkCheck(vkGetSemaphoreCounterValue(device->device, semaphore, &value), "vkGetSemaphoreCounterValue (TimelineSemaphore.h)");
+        // keep the cache monotonic when two threads race
+        uint64_t cached = completedCache.load(std::memory_order_relaxed);
+        while (cached < value && !completedCache.compare_exchange_weak(cached, value, std::memory_order_relaxed)) {}
+        return value;
+    }
+    
+    bool isComplete(uint64_t value) {
+        if (completedCache.load(std::memory_order_relaxed) >= value) return true;
+        return completedValue() >= value;
+    }
+    
+    void wait(uint64_t value) {
+        if (completedCache.load(std::memory_order_relaxed) >= value) return;
+        
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &semaphore;
+        waitInfo.pValues = &value;
+        VkCheck(vkWaitSemaphores(device->device, &waitInfo, UINT64_MAX), "vkWaitSemaphores (TimelineSemaphore.h)");
+        completedValue();
+    }
+};
+
+#endif //CITRINE_TIMELINESEMAPHORE_H
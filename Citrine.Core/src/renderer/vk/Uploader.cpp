@@ -0,0 +1,306 @@
+#include "Uploader.h"
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+    // reads a byte of every page of data. pages of a file mapping (AssetPack) fault in here, on the calling thread
+    // without the lock, instead of in the memcpy under it
+    void prefault(const void* data, VkDeviceSize size) {
+        if (size == 0) return;
+        static const uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+        uintptr_t begin = reinterpret_cast<uintptr_t>(data);
+        uintptr_t end = begin + size;
+        uintptr_t firstPage = begin & ~(pageSize - 1);
+        // read ahead the whole range at once rather than a page per fault
+        madvise(reinterpret_cast<void*>(firstPage), end - firstPage, MADV_WILLNEED);
+        for (uintptr_t page = firstPage; page < end; page += pageSize) {
+            (void)*reinterpret_cast<const volatile char*>(std::max(page, begin));
+        }
+    }
+}
+
+void Uploader::create(LogicalDevice& logicalDevice, Queues& deviceQueues, MemoryAllocator& memoryAllocator, VkDeviceSize ringSize) {
+    device = logicalDevice.device;
+    queues = &deviceQueues;
+    allocator = &memoryAllocator;
+    granularity = logicalDevice.transferGranularity;
+
+    VkCommandPoolCreateInfo poolCreateInfo{};
+    poolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolCreateInfo.queueFamilyIndex = queues->transferIndex;
+    VkCheck(vkCreateCommandPool(device, &poolCreateInfo, nullptr, &commandPool), "vkCreateCommandPool (Uploader.cpp)");
+
+    VkFenceCreateInfo fenceCreateInfo{};
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    for (auto& batch: batches) {
+        batch.commandBuffer.create(commandPool, device);
+        VkCheck(vkCreateFence(device, &fenceCreateInfo, nullptr, &batch.fence), "vkCreateFence (Uploader.cpp)");
+    }
+
+    // copies into it are flushed, so non coherent memory works too
+    ring = allocator->createBuffer(ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+void Uploader::destroy() {
+    // nothing else uploads anymore, so nobody waits on the fences either
+    std::lock_guard lock(mutex);
+    while (retireOldest(true));
+
+    for (auto& batch: batches) vkDestroyFence(device, batch.fence, nullptr);
+    vkDestroyCommandPool(device, commandPool, nullptr);
+    allocator->destroyBuffer(ring);
+}
+
+Buffer Uploader::createDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage) {
+    uint32_t families[] = {queues->graphicsIndex, queues->transferIndex};
+    std::span<const uint32_t> sharedFamilies(families, queues->hasDedicatedTransfer() ? 2 : 1);
+    return allocator->createBuffer(size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, sharedFamilies);
+}
+
+Image Uploader::createDeviceImage(VkImageCreateInfo createInfo) {
+    uint32_t families[] = {queues->graphicsIndex, queues->transferIndex};
+    createInfo.usage |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    // concurrent like the buffers, so neither queue has to transfer ownership
+    if (queues->hasDedicatedTransfer()) {
+        createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        createInfo.queueFamilyIndexCount = 2;
+        createInfo.pQueueFamilyIndices = families;
+    }
+    return allocator->createImage(createInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+VkDeviceSize Uploader::allocateRing(std::unique_lock<std::mutex>& lock, VkDeviceSize size, VkDeviceSize alignment) {
+    VkDeviceSize offset, consumed;
+    // ring is full: the only place where uploads wait on the gpu. other threads move the head meanwhile, so the
+    // placement is worked out again after every wait
+    while (true) {
+        if (ringUsed == 0) ringHead = 0;
+        // not always a power of two, texel blocks of 3 channel formats are 3 bytes
+        offset = (ringHead + alignment - 1) / alignment * alignment;
+        if (offset + size > ring.size) offset = 0;
+        // bytes skipped at the end of the ring on wrap around are consumed as well
+        consumed = (offset >= ringHead ? offset - ringHead : ring.size - ringHead) + size;
+        if (ringUsed + consumed <= ring.size) break;
+        
+        if (batchesInFlight == 0) flushLocked(lock);
+        if (batchesInFlight > 0) waitOldest(lock);
+    }
+
+    ringHead = offset + size;
+    ringUsed += consumed;
+    pendingRingBytes += consumed;
+    return offset;
+}
+
+void Uploader::waitOldest(std::unique_lock<std::mutex>& lock) {
+    Batch& batch = batches[oldestBatch];
+    VkFence fence = batch.fence;
+    batch.waiters++;
+    lock.unlock();
+    vkWaitForFences(device, 1, &fence, true, UINT64_MAX);
+    lock.lock();
+    batch.waiters--;
+    retireFinished();
+}
+
+bool Uploader::retireOldest(bool wait) {
+    if (batchesInFlight == 0) return false;
+
+    Batch& batch = batches[oldestBatch];
+    // another thread waits on it unlocked, resetting the fence under it isn't allowed. it retires it when done
+    if (batch.waiters > 0) return false;
+    if (wait) vkWaitForFences(device, 1, &batch.fence, true, UINT64_MAX);
+    else if (vkGetFenceStatus(device, batch.fence) != VK_SUCCESS) return false;
+
+    vkResetFences(device, 1, &batch.fence);
+    batch.inFlight = false;
+    ringUsed -= batch.ringBytes;
+    completedTicket = batch.ticket;
+    oldestBatch = (oldestBatch + 1) % maxBatches;
+    batchesInFlight--;
+    return true;
+}
+
+uint64_t Uploader::flushLocked(std::unique_lock<std::mutex>& lock) {
+    // the copies may have gone out with another thread's flush while this one waited
+    while (!pendingCopies.empty() && batchesInFlight == maxBatches) waitOldest(lock);
+    if (pendingCopies.empty()) return nextTicket - 1;
+
+    Batch& batch = batches[nextBatch];
+    batch.commandBuffer.reset();
+    batch.commandBuffer.record();
+
+    // consecutive copies into the same buffer (image) go out as one vkCmdCopyBuffer (vkCmdCopyBufferToImage)
+    copyRegions.clear();
+    imageRegions.clear();
+    for (size_t i = 0; i < pendingCopies.size(); ++i) {
+        const PendingCopy& copy = pendingCopies[i];
+        const PendingCopy* next = i + 1 < pendingCopies.size() ? &pendingCopies[i + 1] : nullptr;
+        bool merges = next != nullptr && next->kind == copy.kind && next->buffer == copy.buffer && next->image == copy.image;
+        switch (copy.kind) {
+            case PendingKind::BufferCopy:
+                copyRegions.push_back(copy.region);
+                if (merges) continue;
+                vkCmdCopyBuffer(batch.commandBuffer.vk, ring.buffer, copy.buffer, static_cast<uint32_t>(copyRegions.size()), copyRegions.data());
+                copyRegions.clear();
+                break;
+            case PendingKind::ImageCopy:
+                imageRegions.push_back(copy.imageRegion);
+                if (merges) continue;
+                vkCmdCopyBufferToImage(batch.commandBuffer.vk, ring.buffer, copy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                       static_cast<uint32_t>(imageRegions.size()), imageRegions.data());
+                imageRegions.clear();
+                break;
+            case PendingKind::ImageBarrier:
+                vkCmdPipelineBarrier(batch.commandBuffer.vk, copy.srcStages, copy.dstStages, 0, 0, nullptr, 0, nullptr, 1, &copy.barrier);
+                break;
+        }
+    }
+    batch.commandBuffer.end();
+
+    queues->SubmitTransfer(batch.commandBuffer.vk, batch.fence);
+
+    batch.ticket = nextTicket++;
+    batch.ringBytes = pendingRingBytes;
+    batch.inFlight = true;
+    pendingRingBytes = 0;
+    pendingCopies.clear();
+
+    nextBatch = (nextBatch + 1) % maxBatches;
+    batchesInFlight++;
+    return batch.ticket;
+}
+
+uint64_t Uploader::upload(const Buffer& dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) {
+    prefault(data, size);
+    std::unique_lock lock(mutex);
+
+    // split big uploads so a single one can never need the whole ring
+    const VkDeviceSize maxChunk = ring.size / 2;
+    VkDeviceSize done = 0;
+    while (done < size) {
+        VkDeviceSize chunk = std::min(size - done, maxChunk);
+        VkDeviceSize offset = allocateRing(lock, chunk);
+        memcpy(static_cast<char*>(ring.allocation.mapped) + offset, static_cast<const char*>(data) + done, chunk);
+        allocator->flush(ring.allocation, offset, chunk);
+        PendingCopy& copy = pendingCopies.emplace_back();
+        copy.kind = PendingKind::BufferCopy;
+        copy.buffer = dst.buffer;
+        copy.region = {offset, dstOffset + done, chunk};
+        done += chunk;
+    }
+    return nextTicket;
+}
+
+void Uploader::pushImageBarrier(VkImage image, uint32_t mipLevels, uint32_t layers, VkImageLayout oldLayout, VkImageLayout newLayout) {
+    PendingCopy& copy = pendingCopies.emplace_back();
+    copy.kind = PendingKind::ImageBarrier;
+    copy.image = image;
+    copy.barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    copy.barrier.oldLayout = oldLayout;
+    copy.barrier.newLayout = newLayout;
+    copy.barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    copy.barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    copy.barrier.image = image;
+    copy.barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, layers};
+    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
+        copy.barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        copy.srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        copy.dstStages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    } else {
+        // the transfer queue may not know the shader stages, readers wait for the ticket like they do for buffers
+        copy.barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        copy.srcStages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        copy.dstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    }
+}
+
+uint64_t Uploader::uploadImage(const Image& dst, VkFormat format, uint32_t mipLevels, uint32_t layers, std::span<const ImageUploadRegion> regions,
+                               VkImageLayout finalLayout) {
+    FormatBlock block = formatBlock(format);
+    if (block.bytes == 0) throw std::runtime_error("image upload of an unsupported format (Uploader.cpp)");
+    // offsets into the ring have to be multiples of the texel block size as well
+    VkDeviceSize alignment = std::lcm(copyAlignment, static_cast<VkDeviceSize>(block.bytes));
+    
+    for (const ImageUploadRegion& region: regions) prefault(region.data, region.size);
+    std::unique_lock lock(mutex);
+    pushImageBarrier(dst.image, mipLevels, layers, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    
+    const VkDeviceSize maxChunk = ring.size / 2;
+    for (const ImageUploadRegion& region: regions) {
+        VkDeviceSize layerSize = region.size / region.layerCount;
+        uint32_t blockRows = (region.extent.height + block.height - 1) / block.height;
+        // whole layers when they fit, otherwise bands of block rows of one layer (2D only)
+        uint32_t layersPerChunk = std::clamp<uint32_t>(static_cast<uint32_t>(maxChunk / layerSize), 1, region.layerCount);
+        VkDeviceSize rowSize = layerSize / blockRows;
+        uint32_t rowsPerChunk = blockRows;
+        if (layerSize > maxChunk) {
+            if (region.extent.depth > 1) throw std::runtime_error("3D image level larger than half the staging ring (Uploader.cpp)");
+            // bands start on multiples of the transfer family's granularity (in blocks), the last one ends at the edge
+            if (granularity.height == 0) {
+                if (layerSize > ring.size) throw std::runtime_error("image level larger than the staging ring, the transfer queue only copies whole levels (Uploader.cpp)");
+            } else {
+                rowsPerChunk = std::max<uint32_t>(static_cast<uint32_t>(maxChunk / rowSize), 1);
+                rowsPerChunk = std::max(rowsPerChunk / granularity.height * granularity.height, granularity.height);
+                if (rowsPerChunk * rowSize > ring.size) throw std::runtime_error("image band larger than the staging ring (Uploader.cpp)");
+            }
+        }
+        
+        for (uint32_t layer = 0; layer < region.layerCount; layer += layersPerChunk) {
+            uint32_t layerCount = std::min(layersPerChunk, region.layerCount - layer);
+            for (uint32_t row = 0; row < blockRows; row += rowsPerChunk) {
+                uint32_t rows = std::min(rowsPerChunk, blockRows - row);
+                VkDeviceSize size = layerCount > 1 ? layerCount * layerSize : rows * rowSize;
+                VkDeviceSize source = layer * layerSize + row * rowSize;
+                VkDeviceSize offset = allocateRing(lock, size, alignment);
+                memcpy(static_cast<char*>(ring.allocation.mapped) + offset, static_cast<const char*>(region.data) + source, size);
+                allocator->flush(ring.allocation, offset, size);
+                
+                PendingCopy& copy = pendingCopies.emplace_back();
+                copy.kind = PendingKind::ImageCopy;
+                copy.image = dst.image;
+                copy.imageRegion.bufferOffset = offset;
+                copy.imageRegion.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, region.mipLevel, region.baseLayer + layer, layerCount};
+                copy.imageRegion.imageOffset = {0, static_cast<int32_t>(row * block.height), 0};
+                // the last band may end in a partial block, the extent stays within the level
+                uint32_t height = std::min(rows * block.height, region.extent.height - row * block.height);
+                copy.imageRegion.imageExtent = {region.extent.width, height, region.extent.depth};
+            }
+        }
+    }
+    
+    if (finalLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) pushImageBarrier(dst.image, mipLevels, layers, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, finalLayout);
+    return nextTicket;
+}
+
+void Uploader::retireFinished() {
+    while (retireOldest(false));
+}
+
+uint64_t Uploader::flush() {
+    std::unique_lock lock(mutex);
+    retireFinished();
+    return flushLocked(lock);
+}
+
+void Uploader::poll() {
+    std::lock_guard lock(mutex);
+    retireFinished();
+}
+
+bool Uploader::isComplete(uint64_t ticket) {
+    std::lock_guard lock(mutex);
+    retireFinished();
+    return ticket <= completedTicket;
+}
+
+void Uploader::wait(uint64_t ticket) {
+    std::unique_lock lock(mutex);
+    // queued copies only get a batch (and a fence) with the next flush
+    if (ticket >= nextTicket) flushLocked(lock);
+    while (completedTicket < ticket && batchesInFlight > 0) waitOldest(lock);
+}
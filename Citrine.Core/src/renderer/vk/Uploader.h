@@ -0,0 +1,119 @@
+#ifndef CITRINE_UPLOADER_H
+#define CITRINE_UPLOADER_H
+
+#include "VkHelper.h"
+#include <array>
+#include <vector>
+#include <mutex>
+#include "CommandBuffer.h"
+#include "Queues.h"
+#include "LogicalDevice.h"
+#include "MemoryAllocator.h"
+#include "TextureFormat.h"
+
+// one mip level of one or more array layers, tightly packed in whole texel blocks (layer after layer)
+struct ImageUploadRegion {
+    uint32_t mipLevel;
+    uint32_t baseLayer;
+    uint32_t layerCount;
+    VkExtent3D extent;
+    const void* data;
+    VkDeviceSize size;
+};
+
+// async upload path into device local buffers and images. data is copied into a persistently mapped staging ring, copies are
+// batched and submitted once per flush() on the transfer queue (a dedicated family if the device has one).
+// every upload returns a ticket, isComplete(ticket) tells when the destination is safe to read without waiting.
+class Uploader {
+private:
+    static constexpr uint32_t maxBatches = 8;
+    static constexpr VkDeviceSize copyAlignment = 16;
+
+    enum class PendingKind : uint8_t {
+        BufferCopy,
+        ImageCopy,
+        // layout transition of an image upload, recorded in order with the copies around it
+        ImageBarrier,
+    };
+
+    struct PendingCopy {
+        PendingKind kind;
+        VkBuffer buffer;
+        VkImage image;
+        VkBufferCopy region;
+        VkBufferImageCopy imageRegion;
+        VkImageMemoryBarrier barrier;
+        VkPipelineStageFlags srcStages;
+        VkPipelineStageFlags dstStages;
+    };
+
+    struct Batch {
+        CommandBuffer commandBuffer{};
+        VkFence fence = VK_NULL_HANDLE;
+        uint64_t ticket = 0;
+        VkDeviceSize ringBytes = 0;
+        bool inFlight = false;
+        // threads waiting on the fence without the lock, it isn't reset (retired) until they're done
+        uint32_t waiters = 0;
+    };
+
+    VkDevice device = VK_NULL_HANDLE;
+    Queues* queues = nullptr;
+    MemoryAllocator* allocator = nullptr;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkExtent3D granularity{1, 1, 1};
+
+    Buffer ring;
+    VkDeviceSize ringHead = 0;
+    VkDeviceSize ringUsed = 0;
+    VkDeviceSize pendingRingBytes = 0;
+
+    std::array<Batch, maxBatches> batches;
+    uint32_t nextBatch = 0;
+    uint32_t oldestBatch = 0;
+    uint32_t batchesInFlight = 0;
+
+    std::vector<PendingCopy> pendingCopies;
+    // scratch for flush, kept so flushing doesn't allocate once it has seen its largest batch
+    std::vector<VkBufferCopy> copyRegions;
+    std::vector<VkBufferImageCopy> imageRegions;
+    uint64_t nextTicket = 1;
+    uint64_t completedTicket = 0;
+    std::mutex mutex;
+
+    // these take the held lock, they release it while waiting on the gpu
+    VkDeviceSize allocateRing(std::unique_lock<std::mutex>& lock, VkDeviceSize size, VkDeviceSize alignment = copyAlignment);
+    void waitOldest(std::unique_lock<std::mutex>& lock);
+    uint64_t flushLocked(std::unique_lock<std::mutex>& lock);
+    void pushImageBarrier(VkImage image, uint32_t mipLevels, uint32_t layers, VkImageLayout oldLayout, VkImageLayout newLayout);
+    bool retireOldest(bool wait);
+    void retireFinished();
+
+public:
+    void create(LogicalDevice& logicalDevice, Queues& deviceQueues, MemoryAllocator& memoryAllocator, VkDeviceSize ringSize = 16ull * 1024 * 1024);
+    void destroy();
+
+    // device local buffer usable by both the transfer and the graphics queue
+    Buffer createDeviceBuffer(VkDeviceSize size, VkBufferUsageFlags usage);
+    // device local image usable by both queues, usage gets TRANSFER_DST added
+    Image createDeviceImage(VkImageCreateInfo createInfo);
+
+    // stages data and queues the copy for the next flush, only blocks when the staging ring is full. safe from io threads:
+    // data is faulted in before the lock is taken and waits for ring space don't hold it, so streaming from a mapped
+    // file never stalls the frame thread's flush and isComplete
+    uint64_t upload(const Buffer& dst, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+    // stages every region and queues their copies between two layout transitions of the whole image: from undefined
+    // (previous contents are dropped) to finalLayout. TRANSFER_DST_OPTIMAL leaves it to the caller, e.g. to blit mips.
+    // levels larger than half the ring are split into bands of block rows
+    uint64_t uploadImage(const Image& dst, VkFormat format, uint32_t mipLevels, uint32_t layers, std::span<const ImageUploadRegion> regions,
+                         VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    // submits all queued copies in a single vkQueueSubmit, returns the ticket of that submission
+    uint64_t flush();
+    // non blocking, retires finished submissions and recycles their staging memory
+    void poll();
+    bool isComplete(uint64_t ticket);
+    // blocks until ticket completed, flushing it first if it is still queued. for tearing down what an upload writes
+    void wait(uint64_t ticket);
+};
+
+#endif //CITRINE_UPLOADER_H
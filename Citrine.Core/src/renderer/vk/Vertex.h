@@ -0,0 +1,80 @@
+#ifndef CITRINE_VERTEX_H
+#define CITRINE_VERTEX_H
+
+#include "VkHelper.h"
+#include "VertexLayout.h"
+#include <array>
+#include <algorithm>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+struct Vertex {
+    glm::vec3 pos;
+    glm::vec3 col;
+
+    using Layout = VertexLayout<VK_VERTEX_INPUT_RATE_VERTEX,
+            VertexAttribute<0, VK_FORMAT_R32G32B32_SFLOAT>,
+            VertexAttribute<1, VK_FORMAT_R32G32B32_SFLOAT>>;
+
+    static VkVertexInputBindingDescription getBindingDescription() { return Layout::binding(0); }
+    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() { return Layout::attributes(0); }
+};
+static_assert(sizeof(Vertex) == Vertex::Layout::stride && offsetof(Vertex, col) == Vertex::Layout::offset(1));
+
+// half of Vertex, read by the same shaders: position as snorm16 relative to the mesh bounds (Mesh::decode maps it
+// back), color as unorm8. built by VertexEncoding::quantize
+struct CompactVertex {
+    // w unused, 3 component 16 bit formats are rarely supported for vertex input
+    int16_t pos[4];
+    uint32_t col;
+
+    using Layout = VertexLayout<VK_VERTEX_INPUT_RATE_VERTEX,
+            VertexAttribute<0, VK_FORMAT_R16G16B16A16_SNORM>,
+            VertexAttribute<1, VK_FORMAT_R8G8B8A8_UNORM>>;
+
+    static VkVertexInputBindingDescription getBindingDescription() { return Layout::binding(0); }
+    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() { return Layout::attributes(0); }
+};
+static_assert(sizeof(CompactVertex) == CompactVertex::Layout::stride && offsetof(CompactVertex, col) == CompactVertex::Layout::offset(1));
+
+// textured meshes (shaders/textured), color comes from the texture and the instance
+struct TexturedVertex {
+    glm::vec3 pos;
+    glm::vec2 uv;
+
+    using Layout = VertexLayout<VK_VERTEX_INPUT_RATE_VERTEX,
+            VertexAttribute<0, VK_FORMAT_R32G32B32_SFLOAT>,
+            VertexAttribute<1, VK_FORMAT_R32G32_SFLOAT>>;
+
+    static VkVertexInputBindingDescription getBindingDescription() { return Layout::binding(0); }
+    static std::array<VkVertexInputAttributeDescription, 2> getAttributeDescriptions() { return Layout::attributes(0); }
+};
+static_assert(sizeof(TexturedVertex) == TexturedVertex::Layout::stride && offsetof(TexturedVertex, uv) == TexturedVertex::Layout::offset(1));
+
+// per instance stream of instanced pipelines (shaders/instanced), binding 1 next to the Vertex binding
+struct InstanceData {
+    glm::mat4 transform;
+    // RGBA8, multiplied with the vertex color
+    uint32_t color;
+
+    static constexpr uint32_t binding = 1;
+
+    // a mat4 attribute takes one location per column
+    using Layout = VertexLayout<VK_VERTEX_INPUT_RATE_INSTANCE,
+            VertexAttribute<2, VK_FORMAT_R32G32B32A32_SFLOAT>,
+            VertexAttribute<3, VK_FORMAT_R32G32B32A32_SFLOAT>,
+            VertexAttribute<4, VK_FORMAT_R32G32B32A32_SFLOAT>,
+            VertexAttribute<5, VK_FORMAT_R32G32B32A32_SFLOAT>,
+            VertexAttribute<6, VK_FORMAT_R8G8B8A8_UNORM>>;
+
+    static VkVertexInputBindingDescription getBindingDescription() { return Layout::binding(binding); }
+    static std::array<VkVertexInputAttributeDescription, 5> getAttributeDescriptions() { return Layout::attributes(binding); }
+
+    static uint32_t packColor(float r, float g, float b, float a = 1) {
+        auto channel = [](float v) { return static_cast<uint32_t>(std::clamp(v, 0.f, 1.f) * 255 + .5f); };
+        return channel(r) | channel(g) << 8 | channel(b) << 16 | channel(a) << 24;
+    }
+};
+static_assert(sizeof(InstanceData) == InstanceData::Layout::stride && offsetof(InstanceData, color) == InstanceData::Layout::offset(4));
+
+#endif //CITRINE_VERTEX_H
@@ -0,0 +1,59 @@
+#ifndef CITRINE_VERTEXLAYOUT_H
+#define CITRINE_VERTEXLAYOUT_H
+
+#include "VkHelper.h"
+#include <array>
+#include <cstdint>
+
+// bytes a vertex attribute of the format takes, 0 for formats layouts don't use (yet)
+constexpr uint32_t vertexFormatSize(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R32G32B32A32_SFLOAT: return 16;
+        case VK_FORMAT_R32G32B32_SFLOAT: return 12;
+        case VK_FORMAT_R32G32_SFLOAT: return 8;
+        case VK_FORMAT_R16G16B16A16_SNORM: return 8;
+        case VK_FORMAT_R16G16B16A16_SFLOAT: return 8;
+        case VK_FORMAT_R16G16_SNORM: return 4;
+        case VK_FORMAT_R16G16_SFLOAT: return 4;
+        case VK_FORMAT_R8G8B8A8_UNORM: return 4;
+        case VK_FORMAT_R8G8B8A8_SNORM: return 4;
+        default: return 0;
+    }
+}
+
+template<uint32_t Location, VkFormat Format>
+struct VertexAttribute {
+    static constexpr uint32_t location = Location;
+    static constexpr VkFormat format = Format;
+    static constexpr uint32_t size = vertexFormatSize(Format);
+    static_assert(size > 0, "format missing from vertexFormatSize");
+};
+
+// binding and attribute descriptions generated at compile time. attributes are tightly packed in declaration order,
+// the vertex struct declares its members in the same order (static_assert the offsets next to it)
+template<VkVertexInputRate InputRate, typename... Attributes>
+struct VertexLayout {
+    static constexpr uint32_t attributeCount = sizeof...(Attributes);
+    static constexpr uint32_t stride = (Attributes::size + ...);
+
+    static constexpr uint32_t offset(uint32_t attribute) {
+        constexpr uint32_t sizes[] = {Attributes::size...};
+        uint32_t result = 0;
+        for (uint32_t i = 0; i < attribute; ++i) result += sizes[i];
+        return result;
+    }
+
+    static constexpr VkVertexInputBindingDescription binding(uint32_t binding) {
+        return {binding, stride, InputRate};
+    }
+
+    static constexpr std::array<VkVertexInputAttributeDescription, attributeCount> attributes(uint32_t binding) {
+        constexpr uint32_t locations[] = {Attributes::location...};
+        constexpr VkFormat formats[] = {Attributes::format...};
+        std::array<VkVertexInputAttributeDescription, attributeCount> description{};
+        for (uint32_t i = 0; i < attributeCount; ++i) description[i] = {locations[i], binding, formats[i], offset(i)};
+        return description;
+    }
+};
+
+#endif //CITRINE_VERTEXLAYOUT_H
@@ -4,6 +4,9 @@
 #define GLFW_INCLUDE_VULKAN
 #include <GLFW/glfw3.h>
 #include <stdexcept>
+#include <string>
+#include <vector>
+#include <fstream>
 #include <vulkan/vulkan.h>
 
 #define VkCheck(result, phase)              \
@@ -31,6 +34,30 @@ namespace VkHelper {
         glfwInit();
         glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
     }
+    
+    inline bool isDepthFormat(VkFormat format) {
+        return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_X8_D24_UNORM_PACK32 || format == VK_FORMAT_D32_SFLOAT ||
+               format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+    
+    inline bool hasStencil(VkFormat format) {
+        return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    }
+    
+    // whole file, for shader code
+    inline std::vector<char> readFile(const std::string& filename) {
+        std::ifstream file(filename, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) throw std::runtime_error("failed to open file '" + filename + "'");
+        
+        size_t size = file.tellg();
+        std::vector<char> buffer(size);
+        
+        file.seekg(0);
+        file.read(buffer.data(), (std::streamsize) size);
+        
+        file.close();
+        return buffer;
+    }
 };
 
 
@@ -1,75 +1,185 @@
 #include "VkWindow.h"
 
-void VkWindow::initVulkan() {
+void VkWindow::initVulkan(VkExtent2D headlessExtent, const FrameSettings& settings) {
+    if (settings.framesInFlight == 0) throw std::runtime_error("framesInFlight must be at least 1 (VkWindow.cpp)");
+    maxFramesInFlight = settings.framesInFlight;
+    swapChain.presentPolicy = settings.presentPolicy;
+    jobs.create();
     createInstance();
-    VkCheck(glfwCreateWindowSurface(vkInstance.instance, glfwWindow, nullptr, &surface), "glfwCreateWindowSurface (VkWindow.cpp)");
+    surface = VK_NULL_HANDLE;
+    if (!headless) VkCheck(glfwCreateWindowSurface(vkInstance.instance, glfwWindow, nullptr, &surface), "glfwCreateWindowSurface (VkWindow.cpp)");
     physicalDevice.create(vkInstance.instance);
-    createLogicalDevice();
-    swapChain.create(glfwWindow, physicalDevice, device, surface, queues);
+    createLogicalDevice(settings.dynamicRendering);
+    allocator.create(physicalDevice, device);
+    uploader.create(device, queues, allocator);
+    pipelineCache.create(physicalDevice, device);
+    pipelines.create(device, pipelineCache, jobs, deletionQueue);
+    samplers.create(physicalDevice, device);
+    if (headless) swapChain.createHeadless(headlessExtent, maxFramesInFlight, allocator, device);
+    else swapChain.create(framebufferExtent(), physicalDevice, device, surface, queues);
+    createCommandPool();
+    frameTimeline.create(device);
+    deletionQueue.create(device, allocator, frameTimeline);
+    frameArenas.resize(commandPool.maxFramesInFlight);
+    for (auto& arena: frameArenas) arena.create(64 * 1024);
+    profiler.create(physicalDevice, device, queues.graphicsIndex, commandPool.maxFramesInFlight);
 }
 
 void VkWindow::createInstance() {
-    vkInstance.create(vkRequiredValidationLayers);
+    vkInstance.create(vkRequiredValidationLayers, headless);
 }
 
-VkWindow::VkWindow() {
+VkWindow::VkWindow(const FrameSettings& settings) {
     createGlfwWindow();
-    initVulkan();
+    initVulkan({}, settings);
+}
+
+VkWindow::VkWindow(VkExtent2D headlessExtent, const FrameSettings& settings) {
+    headless = true;
+    initVulkan(headlessExtent, settings);
 }
 
 void VkWindow::Close() {
+    deletionQueue.destroy();
+    profiler.destroy();
+    for (auto& arena: frameArenas) arena.destroy();
+    frameTimeline.destroy();
     commandPool.destroy(device);
     
-    swapChain.destroy(device);
+    swapChain.destroy(device, allocator);
     
+    samplers.destroy();
+    pipelines.destroy();
+    pipelineCache.destroy();
+    uploader.destroy();
+    allocator.destroy();
     device.destroy();
-    vkDestroySurfaceKHR(vkInstance.instance, surface, nullptr);
+    if (!headless) vkDestroySurfaceKHR(vkInstance.instance, surface, nullptr);
     vkInstance.destroy();
+    jobs.destroy();
+    if (headless) return;
     glfwDestroyWindow(glfwWindow);
     glfwTerminate();
 }
 
-void VkWindow::createLogicalDevice() {
+void VkWindow::createLogicalDevice(bool allowDynamicRendering) {
     device = {};
-    device.create(physicalDevice.physicalDevice, surface, vkRequiredValidationLayers, vkRequiredDeviceExtensions);
+    device.create(physicalDevice.physicalDevice, surface, vkRequiredValidationLayers, headless ? std::vector<const char*>{} : vkRequiredDeviceExtensions, allowDynamicRendering);
     queues.graphicsIndex = device.vkQueueFamilyIndices.graphics.value();
     queues.presentIndex = device.vkQueueFamilyIndices.present.value();
+    queues.transferIndex = device.vkQueueFamilyIndices.transfer.value();
     queues.get(device.device);
 }
 
 void VkWindow::createFramebuffers(VkRenderPass renderPass) {
+    // dynamic rendering renders into the image views directly
+    if (renderPass == VK_NULL_HANDLE) return;
     swapChain.createFramebuffers(renderPass, device);
-    createCommandPool();
 }
 
 void VkWindow::createCommandPool() {
-    commandPool.create(queues, device);
+    commandPool.create(queues, device, maxFramesInFlight);
 }
 
 bool VkWindow::startCommandBuffer() {
-    vkWaitForFences(device.device, 1, &commandPool.currentInFlightFence(), true, UINT64_MAX);
-    if (vkAcquireNextImageKHR(device.device, swapChain.swapChain, UINT64_MAX, commandPool.currentImageAvailableSemaphore(), VK_NULL_HANDLE, &swapChain.currentImageIndex) == VK_ERROR_OUT_OF_DATE_KHR)
-        return false;
-    vkResetFences(device.device, 1, &commandPool.currentInFlightFence());
+    CITRINE_PROFILE_FRAME(frameNumber);
+    frameStartAllocations = AllocationCounter::threadAllocations();
+    deletionQueue.setFrame(frameNumber);
+    {
+        // everything uploaded since the last frame goes out in one transfer submission
+        CITRINE_PROFILE_SCOPE("upload flush");
+        uploader.flush();
+    }
+    if (swapChainOutdated) return false;
+    if (frameNumber >= maxFramesInFlight) {
+        // the frame that used this slot before
+        CITRINE_PROFILE_SCOPE("wait for frame");
+        waitForFrame(frameNumber - maxFramesInFlight);
+    }
+    // nothing of the frame that used this slot is read anymore. growing it allocates, which restarts the warmup
+    if (frameArena().reset()) steadyFrames = 0;
+    deletionQueue.collect();
+    // one offscreen image per frame in flight, so the wait above also guards the image
+    if (headless) swapChain.currentImageIndex = commandPool.currentFrameIndex;
+    else {
+        CITRINE_PROFILE_SCOPE("acquire image");
+        VkResult acquireResult = vkAcquireNextImageKHR(device.device, swapChain.swapChain, UINT64_MAX, commandPool.currentImageAvailableSemaphore(), VK_NULL_HANDLE, &swapChain.currentImageIndex);
+        if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) return false;
+        // suboptimal still signals the semaphore, render this frame and recreate after presenting it
+        if (acquireResult == VK_SUBOPTIMAL_KHR) swapChainOutdated = true;
+        else VkCheck(acquireResult, "vkAcquireNextImageKHR (VkWindow.cpp)");
+    }
     commandPool.currentCommandBuffer().reset();
     commandPool.currentCommandBuffer().record();
+    profiler.beginFrame(commandPool.currentCommandBuffer().vk, commandPool.currentFrameIndex, frameNumber);
     return true;
 }
 
 void VkWindow::endCommandBuffer() {
+    profiler.endFrame(commandPool.currentCommandBuffer().vk);
     commandPool.currentCommandBuffer().end();
+    CITRINE_PROFILE_SUBMIT(frameNumber);
+    
+    VkCommandBuffer commandBuffer = commandPool.currentCommandBuffer().vk;
+    if (headless) {
+        SemaphoreSignal frameDone{frameTimeline.semaphore, frameNumber + 1};
+        frameSubmit.add({&commandBuffer, 1}, {}, {&frameDone, 1});
+        queues.Submit(frameSubmit);
+    } else {
+        SemaphoreWait imageAvailable{commandPool.currentImageAvailableSemaphore(), 0, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+        SemaphoreSignal signals[] = {{commandPool.currentRenderFinishedSemaphore()}, {frameTimeline.semaphore, frameNumber + 1}};
+        frameSubmit.add({&commandBuffer, 1}, {&imageAvailable, 1}, signals);
+        queues.Submit(frameSubmit);
+        
+        if (!queues.Present({&swapChain.swapChain, 1}, {&commandPool.currentRenderFinishedSemaphore(), 1}, &swapChain.currentImageIndex)) swapChainOutdated = true;
+    }
+    
+    checkFrameAllocations();
+    frameNumber++;
+    commandPool.currentFrameIndex = (commandPool.currentFrameIndex + 1) % maxFramesInFlight;
+}
+
+void VkWindow::checkFrameAllocations() {
+    if (!AllocationCounter::enabled) return;
+    // first frames fill lazily grown storage (secondary command buffers, profiler rings, arena growth)
+    if (steadyFrames < steadyFrameWarmup) {
+        steadyFrames++;
+        return;
+    }
+    // the frame outgrew its arena, the overflow blocks are heap allocations until the next reset grew it
+    if (frameArena().overflowed()) {
+        steadyFrames = 0;
+        return;
+    }
+    uint64_t allocations = AllocationCounter::threadAllocations() - frameStartAllocations;
+    if (allocations != 0) throw std::runtime_error("frame " + std::to_string(frameNumber) + " made " + std::to_string(allocations) + " heap allocations, the steady state frame loop must make none (VkWindow.cpp)");
+}
 
-    std::vector<VkSemaphore> waitSemaphores = {commandPool.currentImageAvailableSemaphore()};
-    std::vector<VkSemaphore> signalSemaphores = {commandPool.currentRenderFinishedSemaphore()};
-    queues.Submit(waitSemaphores, signalSemaphores, commandPool.currentInFlightFence(), commandPool.currentCommandBuffer().vk);
+VkExtent2D VkWindow::framebufferExtent() const {
+    int width, height;
+    glfwGetFramebufferSize(glfwWindow, &width, &height);
+    return {static_cast<uint32_t>(width), static_cast<uint32_t>(height)};
+}
+
+bool VkWindow::recreateSwapChain(VkExtent2D framebufferExtent) {
+    if (headless) return false;
+    CITRINE_PROFILE_SCOPE("recreate swapchain");
+    steadyFrames = 0;
+    swapChainOutdated = false;
+    VkFormat oldFormat = swapChain.surfaceFormat.format;
+    
+    SwapChain retired{};
+    swapChain.recreate(framebufferExtent, physicalDevice, device, surface, queues, retired);
+    // frames still in flight may use the old framebuffers, they go once those finished
+    retired.retire(deletionQueue);
     
-    if (queues.Present({swapChain.swapChain}, signalSemaphores, &swapChain.currentImageIndex)) commandPool.currentFrameIndex = (commandPool.currentFrameIndex + 1) % maxFramesInFlight;
-    else commandPool.currentFrameIndex = 0;
+    return swapChain.surfaceFormat.format != oldFormat;
 }
 
-void VkWindow::recreateSwapChain() {
-    device.WaitIdle();
-    swapChain.recreate(glfwWindow, physicalDevice, device, surface, queues);
+void VkWindow::setPresentPolicy(PresentPolicy policy) {
+    if (headless || policy == swapChain.presentPolicy) return;
+    swapChain.presentPolicy = policy;
+    swapChainOutdated = true;
 }
 
 
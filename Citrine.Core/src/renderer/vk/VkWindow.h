@@ -18,20 +18,62 @@
 #include "VulkanInstance.h"
 #include "CommandPool.h"
 #include "SwapChain.h"
+#include "MemoryAllocator.h"
+#include "Uploader.h"
+#include "PipelineCache.h"
+#include "PipelineRegistry.h"
+#include "SamplerCache.h"
+#include "GpuProfiler.h"
+#include "TimelineSemaphore.h"
+#include "SubmitBatch.h"
+#include "FrameSettings.h"
+#include "DeletionQueue.h"
+#include "../../core/JobSystem.h"
+#include "../../core/Profiler.h"
+#include "../../core/FrameArena.h"
+#include "../../core/AllocationCounter.h"
 
 class VkWindow : public Window {
 public:
+    // engine wide scheduler, created first and destroyed last so every subsystem can submit jobs
+    JobSystem jobs;
     VulkanInstance vkInstance;
     PhysicalDevice physicalDevice;
     LogicalDevice device;
+    MemoryAllocator allocator;
+    Uploader uploader;
+    PipelineCache pipelineCache;
+    PipelineRegistry pipelines;
+    SamplerCache samplers;
     
     VkSurfaceKHR surface;
     SwapChain swapChain;
     
     CommandPool commandPool;
+    GpuProfiler profiler;
+    // frame N signals N + 1 when the gpu finished it
+    TimelineSemaphore frameTimeline;
+    // resources that in flight frames may still use go here instead of being destroyed
+    DeletionQueue deletionQueue;
+    // graphics queue work of the current frame, endCommandBuffer adds the frame's command buffer and submits it all at once
+    SubmitBatch frameSubmit;
+    
+    // renders into device owned images, no glfw window, surface or swapchain
+    bool headless = false;
+    // frames submitted so far, profilers tag their events with it
+    uint64_t frameNumber = 0;
     
 private:
-    const int maxFramesInFlight = 2;
+    uint32_t maxFramesInFlight = 2;
+    
+    // set when present reports out of date/suboptimal, the next startCommandBuffer requests a recreation
+    bool swapChainOutdated = false;
+    
+    std::vector<FrameArena> frameArenas;
+    // frames since the last swapchain (re)creation, the zero allocation check starts after a few of them
+    static constexpr uint32_t steadyFrameWarmup = 8;
+    uint32_t steadyFrames = 0;
+    uint64_t frameStartAllocations = 0;
     
     Queues queues;
     
@@ -40,19 +82,35 @@ private:
     const std::vector<const char*> vkRequiredValidationLayers = {"VK_LAYER_KHRONOS_validation"};
     const std::vector<const char*> vkRequiredDeviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
     
-    void initVulkan();
+    void initVulkan(VkExtent2D headlessExtent, const FrameSettings& settings);
     void createInstance();
     //static VkBool32 debugMessengerCallback(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types, const VkDebugUtilsMessengerCallbackDataEXT* callbackDataExt, void* userData);
     
-    void createLogicalDevice();
+    void createLogicalDevice(bool allowDynamicRendering);
     
     void createCommandPool();
+    // debug builds (CITRINE_COUNT_ALLOCATIONS): throws when a steady state frame allocated on the heap
+    void checkFrameAllocations();
 public:
-    VkWindow();
+    explicit VkWindow(const FrameSettings& settings = {});
+    explicit VkWindow(VkExtent2D headlessExtent, const FrameSettings& settings = {});
+    // no-op for VK_NULL_HANDLE (RenderPass on a dynamic rendering device)
     void createFramebuffers(VkRenderPass renderPass);
     bool startCommandBuffer();
+    // non blocking, true once the gpu finished frame (a frameNumber)
+    bool isFrameComplete(uint64_t frame) { return frameTimeline.isComplete(frame + 1); }
+    void waitForFrame(uint64_t frame) { frameTimeline.wait(frame + 1); }
+    // transient memory of the current frame, valid until the frame slot comes around again. frame thread only
+    FrameArena& frameArena() { return frameArenas[commandPool.currentFrameIndex]; }
     void endCommandBuffer();
-    void recreateSwapChain();
+    // main thread only (glfw)
+    [[nodiscard]] VkExtent2D framebufferExtent() const;
+    // returns true when the surface format changed, so render passes (and pipelines made for them) must be rebuilt.
+    // framebufferExtent is only used when the surface leaves the extent to the application
+    bool recreateSwapChain(VkExtent2D framebufferExtent);
+    // frame thread only, the next startCommandBuffer fails so the caller recreates the swapchain with the new present mode
+    void setPresentPolicy(PresentPolicy policy);
+    [[nodiscard]] uint32_t framesInFlight() const { return maxFramesInFlight; }
     
     void Close() override;
 };
@@ -9,10 +9,13 @@ private:
         std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
         return VK_FALSE;
     }
-    static void getRequiredExtensions(std::vector<const char*>& requiredDeviceExtensions) {
-        uint32_t glfwExtensionCount;
-        const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-        for (int i = 0; i < glfwExtensionCount; ++i) requiredDeviceExtensions.push_back(glfwExtensions[i]);
+    static void getRequiredExtensions(std::vector<const char*>& requiredDeviceExtensions, bool headless) {
+        // headless instances never create a surface, so they don't need glfw (or a display) at all
+        if (!headless) {
+            uint32_t glfwExtensionCount;
+            const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            for (int i = 0; i < glfwExtensionCount; ++i) requiredDeviceExtensions.push_back(glfwExtensions[i]);
+        }
         if (enableVkValidationLayers) requiredDeviceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
     static void populateDebugMessenger(VkDebugUtilsMessengerCreateInfoEXT& createInfo) {
@@ -40,14 +43,22 @@ public:
     VkInstance instance;
     VkDebugUtilsMessengerEXT debugMessenger;
     
-    void create(const std::vector<const char*>& vkRequiredValidationLayers) {
+    void create(const std::vector<const char*>& vkRequiredValidationLayers, bool headless = false) {
+        // vkEnumerateInstanceVersion is 1.1 itself, a 1.0 loader doesn't have it
+        auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion) vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion");
+        uint32_t instanceVersion = VK_API_VERSION_1_0;
+        if (enumerateInstanceVersion) enumerateInstanceVersion(&instanceVersion);
+        if (instanceVersion < VK_API_VERSION_1_2) throw std::runtime_error("vulkan 1.2 is required, the loader only has 1." + std::to_string(VK_API_VERSION_MINOR(instanceVersion)) + " (VulkanInstance.h)");
+        
         VkApplicationInfo appInfo{};
         appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
         appInfo.pApplicationName = "Citrine engine";
         appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
         appInfo.pEngineName = "No Engine";
         appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-        appInfo.apiVersion = VK_API_VERSION_1_0;
+        // 1.2 is the minimum (timeline semaphores, the *2 queries of the allocator), PhysicalDevice skips older devices.
+        // 1.3 so dynamic rendering is usable in core where the device has it, 1.2 devices just report less
+        appInfo.apiVersion = VK_API_VERSION_1_3;
 
         VkInstanceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -63,7 +74,7 @@ public:
         }
 
         std::vector<const char*> extensions;
-        getRequiredExtensions(extensions);
+        getRequiredExtensions(extensions, headless);
         createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
         createInfo.ppEnabledExtensionNames = extensions.data();
         createInfo.enabledLayerCount = 0;
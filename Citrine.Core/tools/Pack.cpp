@@ -0,0 +1,95 @@
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../src/core/AssetPack.h"
+#include "../src/core/Ktx2.h"
+#include "../src/renderer/vk/VkHelper.h"
+#include "../src/renderer/ObjLoader.h"
+#include "../src/renderer/MeshOptimizer.h"
+#include "../src/renderer/VertexEncoding.h"
+
+// offline packer: shaders (.spv), meshes (.obj, optimized and quantized here so the engine only copies them), textures
+// (.ktx2, checked here, uploaded as stored) and any other file as a blob, into one asset pack. assets are named by the path as given, e.g. shaders/basic/vert.spv
+
+struct PackOptions {
+    std::string output;
+    AssetVertexFormat vertexFormat = AssetVertexFormat::Compact;
+    std::vector<std::string> inputs;
+};
+
+static void printUsage() {
+    std::cout << "usage: citrine_pack -o OUT.pack [--vertex-format float|compact] FILE...\n";
+}
+
+static bool parseOptions(int argc, char** argv, PackOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") return false;
+        if (arg == "-o" || arg == "--vertex-format") {
+            if (i + 1 >= argc) return false;
+            std::string value = argv[++i];
+            if (arg == "-o") options.output = value;
+            else if (value == "float") options.vertexFormat = AssetVertexFormat::Float;
+            else if (value == "compact") options.vertexFormat = AssetVertexFormat::Compact;
+            else return false;
+        }
+        else options.inputs.push_back(arg);
+    }
+    return !options.output.empty() && !options.inputs.empty();
+}
+
+static bool endsWith(const std::string& value, const char* suffix) {
+    size_t length = std::strlen(suffix);
+    return value.size() >= length && value.compare(value.size() - length, length, suffix) == 0;
+}
+
+static void packMesh(AssetPackWriter& writer, const std::string& path, AssetVertexFormat format) {
+    MeshData mesh = ObjLoader::load(path);
+    MeshOptimizer::optimize(mesh);
+    std::cout << path << ": " << mesh.indices.size() / 3 << " triangles, " << mesh.vertices.size() << " vertices, acmr "
+              << MeshOptimizer::averageCacheMissRatio(mesh.indices, mesh.vertices.size()) << "\n";
+    if (format == AssetVertexFormat::Float) {
+        const float identity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+        writer.addMesh(path, format, sizeof(Vertex), std::as_bytes(std::span(mesh.vertices)), mesh.indices, identity);
+        return;
+    }
+    VertexEncoding::QuantizedMesh quantized = VertexEncoding::quantize(mesh);
+    float decode[16];
+    std::memcpy(decode, &quantized.decode, sizeof(decode));
+    writer.addMesh(path, format, sizeof(CompactVertex), std::as_bytes(std::span(quantized.vertices)), quantized.indices, decode);
+}
+
+int main(int argc, char** argv) {
+    PackOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+    
+    try {
+        AssetPackWriter writer;
+        for (const std::string& input: options.inputs) {
+            if (endsWith(input, ".obj")) {
+                packMesh(writer, input, options.vertexFormat);
+                continue;
+            }
+            std::vector<char> file = VkHelper::readFile(input);
+            AssetType type = AssetType::Blob;
+            if (endsWith(input, ".spv")) type = AssetType::Shader;
+            else if (endsWith(input, ".ktx2")) {
+                // rejects what the engine couldn't upload without decoding (supercompression, Basis Universal)
+                Ktx2Image image = Ktx2::parse(std::as_bytes(std::span(file)));
+                std::cout << input << ": " << image.width << "x" << image.height << ", format " << image.vkFormat << ", " << image.levels.size() << " levels\n";
+                type = AssetType::Texture;
+            }
+            writer.add(input, type, std::as_bytes(std::span(file)));
+        }
+        writer.write(options.output);
+        std::cout << "wrote " << options.inputs.size() << " assets to " << options.output << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}